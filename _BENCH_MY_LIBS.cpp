@@ -0,0 +1,125 @@
+﻿#include "sib_unit_test.h"
+#include <clocale>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #include <Windows.h>
+#endif
+
+// Overhead of the sib::debug macro layer itself, per sink.
+// Results: median ns per macro call and global operator new calls per macro call.
+
+namespace {
+
+    using TStreamBuf = ::std::basic_streambuf<sib::debug::OutStrmCh, sib::debug::OutStrmTr>;
+    using TFileBuf   = ::std::basic_filebuf  <sib::debug::OutStrmCh, sib::debug::OutStrmTr>;
+
+    class TNullBuf : public TStreamBuf
+    {
+    protected:
+        int_type        overflow(int_type ch)                  override { return traits_type::not_eof(ch); }
+        std::streamsize xsputn  (char_type const *, std::streamsize n) override { return n; }
+    };
+
+    struct TBenchResult
+    {
+        std::string              name;
+        std::string              sink;
+        sib::debug::TPerfMeasure measure;
+    };
+
+    std::vector<TBenchResult> results;
+
+    template <typename F>
+    void bench(char const * sink, char const * name, F&& block)
+    {
+        results.push_back({ name, sink, sib::debug::detail::perf_measure(std::forward<F>(block)) });
+    }
+
+    void run_benchmarks(char const * sink)
+    {
+        sib::debug::TTestLog CUR_LOG;
+
+        int              i   = 42;
+        double           d   = 3.14;
+        std::string      str = "benchmark string";
+        std::vector<int> vec = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+        bench(sink, "start_macro/finish_macro", [&]() {
+            sib::debug::detail::start_macro("x");
+            sib::debug::detail::finish_macro(sib::debug::BP_ALL);
+        });
+
+        bench(sink, "ASS pass"       , [&]() { ASS(i == 42);                    });
+        bench(sink, "ASS fail"       , [&]() { ASS(i != 42); CUR_LOG.clear();   });
+        bench(sink, "PRN int"        , [&]() { PRN(i);                          });
+        bench(sink, "PRN double"     , [&]() { PRN(d);                          });
+        bench(sink, "PRN std::string", [&]() { PRN(str);                        });
+        bench(sink, "PRN vector<int>", [&]() { PRN(vec);                        });
+        bench(sink, "TYP"            , [&]() { TYP(std::vector<int>);           });
+    }
+
+    void print_results()
+    {
+        sib::debug::TBufer buf;
+        buf << std::left << std::fixed << std::setprecision(2)
+            << "  ---------------------------------------------------------------------\n"
+            << "  | Benchmark                | Sink     | ns/op      | allocs/op\n"
+            << "  ---------------------------------------------------------------------\n";
+        for (auto const & res : results)
+        {
+            buf << "  | " << std::setw(24) << res.name
+                << " | " << std::setw(8)  << res.sink
+                << " | " << std::setw(10) << res.measure.ns_per_op
+                << " | ";
+            if (res.measure.allocs_per_op < 0) buf << "n/a";
+            else                               buf << res.measure.allocs_per_op;
+            buf << "\n";
+        }
+        buf << "  ---------------------------------------------------------------------\n";
+        sib::debug::outstream << buf.str();
+        sib::debug::outstream.flush();
+    }
+
+} // namespace
+
+// MAIN ------------------------------------------------------------------------------
+
+int main()
+{
+    setlocale(LC_ALL, "ru_RU.UTF8");
+
+    #ifdef _WIN32
+        SetConsoleCP(CP_UTF8);
+        SetConsoleOutputCP(CP_UTF8);
+    #endif
+
+    sib::debug::Init();
+
+    auto& out = sib::debug::outstream;
+    auto* terminal = out.rdbuf();
+
+    TNullBuf null_buf;
+    out.rdbuf(&null_buf);
+    run_benchmarks("null");
+
+    char const * file_name = "bench_my_libs_sink.txt";
+    {
+        TFileBuf file_buf;
+        file_buf.open(file_name, std::ios::out | std::ios::trunc);
+        out.rdbuf(&file_buf);
+        run_benchmarks("file");
+        out.rdbuf(terminal);
+    }
+    std::remove(file_name);
+
+    out.rdbuf(terminal);
+    run_benchmarks("terminal");
+
+    print_results();
+    return 0;
+}
@@ -3,6 +3,12 @@
 #include "sib_support.h"
 
 #define TEST_CONSOLE
+#define TEST_CONSOLE_PTY
+#define TEST_SCREEN
+#define TEST_STRING
+#define TEST_VIEWER
+#define TEST_SUPPORT
+#define TEST_UNIT_TEST
 //#define TEST_TYPE_TRAITS
 //#define TEST_TYPES_PACK
 //#define TEST_TYPES_LIST
@@ -13,10 +19,36 @@
 //#define TEST_WRAPPER
 //#define TEST_UNIQUE_TUPLE
 
+//#define TEST_PROGRESS_LINE // live status instead of the transcript, which goes to test_transcript.log
+
 #if defined(TEST_CONSOLE)
     #include "test_console.h"
 #endif
 
+#if defined(TEST_CONSOLE_PTY)
+    #include "test_console_pty.h"
+#endif
+
+#if defined(TEST_SCREEN)
+    #include "test_screen.h"
+#endif
+
+#if defined(TEST_STRING)
+    #include "test_string.h"
+#endif
+
+#if defined(TEST_VIEWER)
+    #include "test_viewer.h"
+#endif
+
+#if defined(TEST_SUPPORT)
+    #include "test_support.h"
+#endif
+
+#if defined(TEST_UNIT_TEST)
+    #include "test_unit_test.h"
+#endif
+
 #if defined(TEST_TYPE_TRAITS) || defined(TEST_TYPES_PACK) || defined(TEST_TYPES_LIST)
     #include "test_type_traits.h"
 #endif
@@ -102,8 +134,36 @@ int main()
         sib::debug::Tests.emplace("10 unique_tuple", test_TUniqueTuple);
     #endif
     
-    sib::debug::RunAllTest();
-    sib::debug::outstream << sib::debug::ReportText() << "\n";
+    #ifdef TEST_CONSOLE_PTY
+        sib::debug::Tests.emplace("11 console (pty)", test_console_pty);
+    #endif
+    
+    #ifdef TEST_SCREEN
+        sib::debug::Tests.emplace("12 screen", test_screen);
+    #endif
+    
+    #ifdef TEST_STRING
+        sib::debug::Tests.emplace("13 string", test_string);
+    #endif
+    
+    #ifdef TEST_VIEWER
+        sib::debug::Tests.emplace("14 viewer", test_viewer);
+    #endif
+    
+    #ifdef TEST_SUPPORT
+        sib::debug::Tests.emplace("15 support", test_support);
+    #endif
+    
+    #ifdef TEST_UNIT_TEST
+        sib::debug::Tests.emplace("16 unit_test", test_unit_test);
+    #endif
+    
+    #ifdef TEST_PROGRESS_LINE
+        sib::debug::RunAllTest(sib::debug::TProgressOptions{});
+    #else
+        sib::debug::RunAllTest();
+    #endif
+    sib::debug::PrintReport();
     
     return 0;
 }
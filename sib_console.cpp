@@ -1,11 +1,33 @@
 ﻿#include "sib_console.h"
 
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <cstring>
+#include <atomic>
+#include <optional>
+
 #if defined(_WIN32)
     #include <windows.h>
     #include "conio.h"
     #include <synchapi.h>
 #else
     #include <cerrno>
+    #include <csignal>
+    #include <cstdlib>
+    #include <mutex>
+    #include <poll.h>
+    #include <cstdio>
+    #include <fcntl.h>
+    #include <sys/ioctl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+    #include <climits>
+    #if defined(__linux__)
+        #include <sys/epoll.h>
+        #include <sys/eventfd.h>
+    #endif
     #include <unistd.h>
     #include <termios.h>
     #include "sib_support.h"
@@ -16,8 +38,17 @@ namespace console {
 
     // ----------------------------------------------------------------------------------- tabs
 
+    TTabWidths::TTabWidths(::std::vector<int> widths)
+        : _widths(::std::move(widths))
+        , _pos(_widths.size())
+    {
+        int sum = 0;
+        for (size_t i = 0; i < _widths.size(); ++i)
+            _pos[i] = sum += _widths[i];
+    }
+
     thread_local int TAB_DEF_WIDTH = 4;
-    thread_local ::std::vector<int> TAB_WIDTH = { 4, 6 };
+    thread_local TTabWidths TAB_WIDTH = { 4, 6 };
 
     int tab_width(size_t idx)
     {
@@ -27,37 +58,290 @@ namespace console {
 
     int tab_pos(size_t idx)
     {
-        int res = tab_width(idx);
-        for (size_t i = 0 ; i < idx ; ++i)
-            res += tab_width(i);
-        return res;
+        if (TAB_WIDTH.size() > idx) return TAB_WIDTH.pos(idx);
+        int res = TAB_WIDTH.empty() ? 0 : TAB_WIDTH.pos(TAB_WIDTH.size() - 1);
+        return res + static_cast<int>(idx + 1 - TAB_WIDTH.size()) * TAB_DEF_WIDTH;
     }
 
 
 
-    // ----------------------------------------------------------------------------------- TKeyCode
+    // ----------------------------------------------------------------------------------- cursor control
 
-    TKeyCode& TKeyCode::operator<<(char ch)
+    bool IsTerminalOutput()
     {
-        base::push_back(ch); return *this;
+        #if defined(_WIN32)
+            static bool const vt = [] {
+                HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+                DWORD mode = 0;
+                return GetConsoleMode(handle, &mode) and SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+            }();
+            return vt;
+        #else
+            return ::isatty(STDOUT_FILENO);
+        #endif
     }
 
-    bool TKeyCode::operator==(TKeyCode const& other) const noexcept
+    int TerminalWidth()
     {
-        return static_cast<base const &>(*this) == static_cast<base const &>(other);
+        return TerminalSize().first;
     }
 
-    bool TKeyCode::operator< (TKeyCode const& other) const noexcept
+    ::std::pair<int, int> TerminalSize()
     {
-        return static_cast<base const &>(*this) < static_cast<base const &>(other);
+        #if defined(_WIN32)
+            CONSOLE_SCREEN_BUFFER_INFO info;
+            if (GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+                return { info.srWindow.Right - info.srWindow.Left + 1, info.srWindow.Bottom - info.srWindow.Top + 1 };
+        #else
+            winsize ws{};
+            if (::ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0)
+                return { ws.ws_col > 0 ? ws.ws_col : 80, ws.ws_row > 0 ? ws.ws_row : 24 };
+        #endif
+        return { 80, 24 };
     }
 
-    ::std::string TKeyCode::name() const
+    #if !defined(_WIN32)
+        namespace {
+
+            // stdout left non-blocking (by another process sharing the terminal, or a pipe) is full:
+            // waits for room instead of failing the write
+            bool wait_output_room()
+            {
+                if (errno != EAGAIN and errno != EWOULDBLOCK) return false;
+                pollfd pfd{ STDOUT_FILENO, POLLOUT, 0 };
+                while (::poll(&pfd, 1, -1) < 0)
+                    if (errno != EINTR) return false;
+                return (pfd.revents & POLLOUT) != 0;
+            }
+
+        } // namespace
+    #endif
+
+    bool WriteOutput(::std::string_view data)
+    {
+        #if defined(_WIN32)
+            IsTerminalOutput();
+            DWORD written = 0;
+            return WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), data.data(), static_cast<DWORD>(data.size()), &written, nullptr)
+                and written == data.size();
+        #else
+            while (not data.empty())
+            {
+                auto done = ::write(STDOUT_FILENO, data.data(), data.size());
+                if (done < 0 and (errno == EINTR or wait_output_room())) continue;
+                if (done <= 0) return false;
+                data.remove_prefix(size_t(done));
+            }
+            return true;
+        #endif
+    }
+
+    bool WriteOutput(::std::span<::std::string_view const> pieces)
+    {
+        size_t written = 0;
+        return WriteOutput(pieces, written);
+    }
+
+    bool WriteOutput(::std::span<::std::string_view const> pieces, size_t& written)
+    {
+        written = 0;
+        #if defined(_WIN32)
+            for (auto piece : pieces)
+            {
+                if (not piece.empty() and not WriteOutput(piece)) return false;
+                written += piece.size();
+            }
+            return true;
+        #else
+            // a batch of pieces per call (IOV_MAX is 16 at least), a partial write resumes inside the piece it stopped at
+            #if defined(IOV_MAX)
+                ::std::array<::iovec, (IOV_MAX < 64) ? IOV_MAX : 64> iov;
+            #else
+                ::std::array<::iovec, 16> iov;
+            #endif
+            size_t first = 0;
+            size_t skip  = 0; // written characters of pieces[first]
+            while (first < pieces.size())
+            {
+                size_t count = 0;
+                for (size_t i = first; i < pieces.size() and count < iov.size(); ++i)
+                {
+                    auto piece = pieces[i].substr((i == first) ? skip : 0);
+                    if (not piece.empty()) iov[count++] = { const_cast<char*>(piece.data()), piece.size() };
+                }
+                if (count == 0) return true;
+
+                auto done = ::writev(STDOUT_FILENO, iov.data(), int(count));
+                if (done < 0 and (errno == EINTR or wait_output_room())) continue;
+                if (done <= 0) return false;
+
+                written += size_t(done);
+                for (size_t left = size_t(done); first < pieces.size(); )
+                {
+                    size_t rest = pieces[first].size() - skip;
+                    if (left < rest) { skip += left; break; }
+                    left -= rest;
+                    skip  = 0;
+                    ++first;
+                }
+            }
+            return true;
+        #endif
+    }
+
+    void AppendRewind(::std::string& out, int lines)
+    {
+        out += '\r';
+        if (lines > 0)
+        {
+            out += "\x1B[";
+            out += ::std::to_string(lines);
+            out += 'A';
+        }
+        out += "\x1B[J";
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- TKeyCode
+
+    namespace {
+
+        struct TKeyName
+        {
+            TKeyCode           code;
+            ::std::string_view name;
+        };
+
+        // later entries win when a platform maps two keys to one sequence
+        constexpr TKeyName key_names[] = {
+            { KC_ENTER         , "ENTER"           },
+            { KC_ESC           , "ESC"             },
+            { KC_TAB           , "TAB"             },
+            { KC_SPACE         , "SPACE"           },
+            { KC_BACKSPACE     , "BACKSPACE"       },
+
+            { KC_CTRL_ENTER    , "Ctrl, ENTER"     },
+            { KC_CTRL_TAB      , "Ctrl, TAB"       },
+            { KC_CTRL_BACKSPACE, "Ctrl, BACKSPACE" },
+
+            { KC_F1            , "F1"              },
+            { KC_F2            , "F2"              },
+            { KC_F3            , "F3"              },
+            { KC_F4            , "F4"              },
+            { KC_F5            , "F5"              },
+            { KC_F6            , "F6"              },
+            { KC_F7            , "F7"              },
+            { KC_F8            , "F8"              },
+            { KC_F9            , "F9"              },
+            { KC_F10           , "F10"             },
+            { KC_F11           , "F11"             },
+            { KC_F12           , "F12"             },
+
+            { KC_NUM_INSERT    , "NUM_INSERT"      },
+            { KC_NUM_DELETE    , "NUM_DELETE"      },
+            { KC_NUM_HOME      , "NUM_HOME"        },
+            { KC_NUM_END       , "NUM_END"         },
+            { KC_NUM_PAGE_UP   , "NUM_PAGE_UP"     },
+            { KC_NUM_PAGE_DOWN , "NUM_PAGE_DOWN"   },
+
+            { KC_INSERT        , "INSERT"          },
+            { KC_DELETE        , "DELETE"          },
+            { KC_HOME          , "HOME"            },
+            { KC_END           , "END"             },
+            { KC_PAGE_UP       , "PAGE_UP"         },
+            { KC_PAGE_DOWN     , "PAGE_DOWN"       },
+
+            { KC_NUM_LEFT      , "NUM_LEFT"        },
+            { KC_NUM_RIGHT     , "NUM_RIGHT"       },
+            { KC_NUM_UP        , "NUM_UP"          },
+            { KC_NUM_DOWN      , "NUM_DOWN"        },
+
+            { KC_LEFT          , "LEFT"            },
+            { KC_RIGHT         , "RIGHT"           },
+            { KC_UP            , "UP"              },
+            { KC_DOWN          , "DOWN"            },
+        };
+
+        // Perfect hash over key_names: multiply-shift with a seed searched at compile time,
+        // so a lookup is one multiplication and one compare.
+        class TKeyNameTable
+        {
+        public:
+            static constexpr unsigned BITS  = 8;
+            static constexpr size_t   SLOTS = size_t(1) << BITS;
+
+            constexpr TKeyNameTable()
+            {
+                for (::std::uint64_t seed = 0x9E3779B97F4A7C15ull; ; seed += 0x632BE59BD9B4E019ull)
+                    if (build(seed | 1)) return;
+            }
+
+            constexpr ::std::string_view find(TKeyCode code) const noexcept
+            {
+                auto const& cell = _cells[slot(code, _seed)];
+                return (cell.code == code) ? cell.name : ::std::string_view{};
+            }
+
+        private:
+            static constexpr size_t slot(TKeyCode code, ::std::uint64_t seed) noexcept
+            {
+                return static_cast<size_t>((code.data() * seed) >> (64 - BITS));
+            }
+
+            constexpr bool build(::std::uint64_t seed)
+            {
+                _seed  = seed;
+                _cells = {};
+                for (auto const& entry : key_names)
+                {
+                    if (entry.code.empty()) continue;
+                    auto& cell = _cells[slot(entry.code, seed)];
+                    if (not cell.code.empty() and cell.code != entry.code) return false;
+                    cell = entry;
+                }
+                return true;
+            }
+
+            ::std::uint64_t                  _seed = 0;
+            ::std::array<TKeyName, SLOTS>    _cells{};
+        };
+
+        constexpr TKeyNameTable key_name_table;
+
+        constexpr char printable_ascii[] =
+            "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+
+        static_assert(sizeof(printable_ascii) == 126 - 33 + 2);
+        static_assert(key_name_table.find(KC_ESC) == "ESC" or KC_ESC.empty());
+        static_assert(key_name_table.find(KC_EMPTY).empty());
+
+    } // namespace
+
+    ::std::string_view TKeyCode::known_name() const noexcept
     {
-        if (size() == 0) return "";
+        if (empty()) return {};
+
+        if (not KeyCodeNames.empty())
+        {
+            auto it = KeyCodeNames.find(*this);
+            if (it != KeyCodeNames.end()) return it->second;
+        }
+
+        if (size() == 1)
+        {
+            auto ch = static_cast<unsigned char>((*this)[0]);
+            if (ch >= 33 and ch <= 126) return { printable_ascii + (ch - 33), 1 };
+        }
+
+        return key_name_table.find(*this);
+    }
 
-        auto it = KeyCodeNames.find(*this);
-        if (it != KeyCodeNames.end()) return it->second;
+    ::std::string TKeyCode::name() const
+    {
+        auto known = known_name();
+        if (not known.empty()) return ::std::string(known);
+        if (empty()) return "";
 
         ::std::string res;
         res = ::std::to_string(static_cast<unsigned char>((*this)[0]));
@@ -68,353 +352,1483 @@ namespace console {
 
 
 
-    // ----------------------------------------------------------------------------------- console lib initialization
+    // ----------------------------------------------------------------------------------- raw mode session
 
-    static bool is_initialized_val = false;
+    #if defined(_WIN32)
 
-    bool const & is_initialized_console_unit = is_initialized_val;
+        namespace { ::std::atomic<int> raw_depth{ 0 }; }
 
-    bool Init()
-    {
-        if (is_initialized_val) return true;
+        TRawModeSession::TRawModeSession() : _ok(true) { ++raw_depth; }
+        TRawModeSession::~TRawModeSession() { --raw_depth; }
 
-        // default KeyCodes
-        #ifdef _WIN32
-    
-            KC_ENTER          << char( 13);
-            KC_ESC            << char( 27);
-            KC_TAB            << char(  9);
-            KC_SPACE          << char( 32);
-            KC_BACKSPACE      << char(  8);
-
-            KC_CTRL_ENTER     << char( 10);
-            KC_CTRL_TAB       << char(  0) << char(148);
-            KC_CTRL_BACKSPACE << char(127);
-
-            KC_F1  << char(  0) << char( 59);
-            KC_F2  << char(  0) << char( 60);
-            KC_F3  << char(  0) << char( 61);
-            KC_F4  << char(  0) << char( 62);
-            KC_F5  << char(  0) << char( 63);
-            KC_F6  << char(  0) << char( 64);
-            KC_F7  << char(  0) << char( 65);
-            KC_F8  << char(  0) << char( 66);
-            KC_F9  << char(  0) << char( 67);
-            KC_F10 << char(  0) << char( 68);
-            KC_F11 << char(224) << char(133);
-            KC_F12 << char(224) << char(134);
-    
-            KC_NUM_INSERT    << char(0) << char(82);
-            KC_NUM_DELETE    << char(0) << char(83);
-            KC_NUM_HOME      << char(0) << char(71);
-            KC_NUM_END       << char(0) << char(79);
-            KC_NUM_PAGE_UP   << char(0) << char(73);
-            KC_NUM_PAGE_DOWN << char(0) << char(81);
-    
-            KC_INSERT    << char(224) << char(82);
-            KC_DELETE    << char(224) << char(83);
-            KC_HOME      << char(224) << char(71);
-            KC_END       << char(224) << char(79);
-            KC_PAGE_UP   << char(224) << char(73);
-            KC_PAGE_DOWN << char(224) << char(81);
-    
-            KC_NUM_LEFT  << char(0) << char(75);
-            KC_NUM_RIGHT << char(0) << char(77);
-            KC_NUM_UP    << char(0) << char(72);
-            KC_NUM_DOWN  << char(0) << char(80);
-    
-            KC_LEFT  << char(224) << char(75);
-            KC_RIGHT << char(224) << char(77);
-            KC_UP    << char(224) << char(72);
-            KC_DOWN  << char(224) << char(80);
-    
-        #elif defined(_POSIX_VERSION)
-    
-            KC_ENTER << '\n';
-            KC_ESC   << '\e';
-    
-            KC_F1  << '\e' << char(79) << char(80);
-            KC_F2  << '\e' << char(79) << char(81);
-            KC_F3  << '\e' << char(79) << char(82);
-            KC_F4  << '\e' << char(79) << char(83);
-            KC_F5  << '\e' << char(91) << char(49) << char(53) << char(126);
-            KC_F6  << '\e' << char(91) << char(49) << char(55) << char(126);
-            KC_F7  << '\e' << char(91) << char(49) << char(56) << char(126);
-            KC_F8  << '\e' << char(91) << char(49) << char(57) << char(126);
-            KC_F9  << '\e' << char(91) << char(50) << char(48) << char(126);
-            KC_F10 << '\e' << char(91) << char(50) << char(49) << char(126);
-            KC_F11 << '\e' << char(91) << char(50) << char(51) << char(126);
-            KC_F12 << '\e' << char(91) << char(50) << char(52) << char(126);
-    
-            KC_INSERT    << '\e' << char(91) << char(50) << char(126);
-            KC_DELETE    << '\e' << char(91) << char(51) << char(126);
-            KC_HOME      << '\e' << char(91) << char(72)             ;
-            KC_END       << '\e' << char(91) << char(70)             ;
-            KC_PAGE_UP   << '\e' << char(91) << char(53) << char(126);
-            KC_PAGE_DOWN << '\e' << char(91) << char(54) << char(126);
-    
-            KC_NUM_INSERT    << '\e' << char(91) << char(50) << char(126);
-            KC_NUM_DELETE    << '\e' << char(91) << char(51) << char(126);
-            KC_NUM_HOME      << '\e' << char(91) << char(72)             ;
-            KC_NUM_END       << '\e' << char(91) << char(76)             ;
-            KC_NUM_PAGE_UP   << '\e' << char(91) << char(53) << char(126);
-            KC_NUM_PAGE_DOWN << '\e' << char(91) << char(54) << char(126);
-
-            KC_UP    << '\e' << char(91) << char(65);
-            KC_DOWN  << '\e' << char(91) << char(66);
-            KC_RIGHT << '\e' << char(91) << char(67);
-            KC_LEFT  << '\e' << char(91) << char(68);
-
-            KC_NUM_LEFT  << '\e' << char(91) << char(65);
-            KC_NUM_RIGHT << '\e' << char(91) << char(66);
-            KC_NUM_UP    << '\e' << char(91) << char(67);
-            KC_NUM_DOWN  << '\e' << char(91) << char(68);
+    #else
 
-        #else
+        namespace {
 
-            #ifndef DISABLE_SIB_WARNINGS
-            #ifndef DISABLE_WARNING_UNKNOWN_KEY_CODES
-    
-                #pragma message (                                                                       \
-                    "Warning [SIB]: Unknown platform. KC_<> values ​​are not set. "                       \
-                    "To suppress this warning, define the DISABLE_WARNING_UNKNOWN_KEY_CODES macros."    \
-                )                                                                                       \
+            ::std::mutex          raw_mtx{};
+            int                   raw_depth = 0;
+            termios               raw_saved{};
+            volatile sig_atomic_t raw_on    = 0;
 
-            #endif
-            #endif
+            constexpr int raw_signals[] = { SIGTERM, SIGHUP, SIGQUIT, SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+            struct sigaction raw_old_actions[sizeof(raw_signals) / sizeof(raw_signals[0])];
 
-        #endif
+            // async-signal-safe
+            void raw_restore() noexcept
+            {
+                if (raw_on)
+                {
+                    (void)tcsetattr(STDIN_FILENO, TCSANOW, &raw_saved);
+                    raw_on = 0;
+                }
+            }
 
-        // default KeyCodeNames registration
-
-        KeyCodeNames[KC_ENTER         ] = "ENTER"           ;
-        KeyCodeNames[KC_ESC           ] = "ESC"             ;
-        KeyCodeNames[KC_TAB           ] = "TAB"             ;
-        KeyCodeNames[KC_SPACE         ] = "SPACE"           ;
-        KeyCodeNames[KC_BACKSPACE     ] = "BACKSPACE"       ;
-
-        KeyCodeNames[KC_CTRL_ENTER    ] = "Ctrl, ENTER"     ;
-        KeyCodeNames[KC_CTRL_TAB      ] = "Ctrl, TAB"       ;
-        KeyCodeNames[KC_CTRL_BACKSPACE] = "Ctrl, BACKSPACE" ;
-
-        KeyCodeNames[KC_F1            ] = "F1"              ; 
-        KeyCodeNames[KC_F2            ] = "F2"              ; 
-        KeyCodeNames[KC_F3            ] = "F3"              ; 
-        KeyCodeNames[KC_F4            ] = "F4"              ; 
-        KeyCodeNames[KC_F5            ] = "F5"              ; 
-        KeyCodeNames[KC_F6            ] = "F6"              ; 
-        KeyCodeNames[KC_F7            ] = "F7"              ; 
-        KeyCodeNames[KC_F8            ] = "F8"              ; 
-        KeyCodeNames[KC_F9            ] = "F9"              ; 
-        KeyCodeNames[KC_F10           ] = "F10"             ; 
-        KeyCodeNames[KC_F11           ] = "F11"             ; 
-        KeyCodeNames[KC_F12           ] = "F12"             ; 
-                                      
-        KeyCodeNames[KC_NUM_INSERT    ] = "NUM_INSERT"      ; 
-        KeyCodeNames[KC_NUM_DELETE    ] = "NUM_DELETE"      ; 
-        KeyCodeNames[KC_NUM_HOME      ] = "NUM_HOME"        ; 
-        KeyCodeNames[KC_NUM_END       ] = "NUM_END"         ; 
-        KeyCodeNames[KC_NUM_PAGE_UP   ] = "NUM_PAGE_UP"     ; 
-        KeyCodeNames[KC_NUM_PAGE_DOWN ] = "NUM_PAGE_DOWN"   ; 
-                                      
-        KeyCodeNames[KC_INSERT        ] = "INSERT"          ; 
-        KeyCodeNames[KC_DELETE        ] = "DELETE"          ; 
-        KeyCodeNames[KC_HOME          ] = "HOME"            ; 
-        KeyCodeNames[KC_END           ] = "END"             ; 
-        KeyCodeNames[KC_PAGE_UP       ] = "PAGE_UP"         ; 
-        KeyCodeNames[KC_PAGE_DOWN     ] = "PAGE_DOWN"       ; 
-                                      
-        KeyCodeNames[KC_NUM_LEFT      ] = "NUM_LEFT"        ; 
-        KeyCodeNames[KC_NUM_RIGHT     ] = "NUM_RIGHT"       ; 
-        KeyCodeNames[KC_NUM_UP        ] = "NUM_UP"          ; 
-        KeyCodeNames[KC_NUM_DOWN      ] = "NUM_DOWN"        ; 
-                                      
-        KeyCodeNames[KC_LEFT          ] = "LEFT"            ; 
-        KeyCodeNames[KC_RIGHT         ] = "RIGHT"           ; 
-        KeyCodeNames[KC_UP            ] = "UP"              ; 
-        KeyCodeNames[KC_DOWN          ] = "DOWN"            ; 
-
-        // ASCII
-        KeyCodeNames[{char( 33)}] = "!";
-        KeyCodeNames[{char( 34)}] = "\"";
-        KeyCodeNames[{char( 35)}] = "#";
-        KeyCodeNames[{char( 36)}] = "$";
-        KeyCodeNames[{char( 37)}] = "%";
-        KeyCodeNames[{char( 38)}] = "&";
-        KeyCodeNames[{char( 39)}] = "'";
-        KeyCodeNames[{char( 40)}] = "(";
-        KeyCodeNames[{char( 41)}] = ")";
-        KeyCodeNames[{char( 42)}] = "*";
-        KeyCodeNames[{char( 43)}] = "+";
-        KeyCodeNames[{char( 44)}] = ",";
-        KeyCodeNames[{char( 45)}] = "-";
-        KeyCodeNames[{char( 46)}] = ".";
-        KeyCodeNames[{char( 47)}] = "/";
-        KeyCodeNames[{char( 48)}] = "0";
-        KeyCodeNames[{char( 49)}] = "1";
-        KeyCodeNames[{char( 50)}] = "2";
-        KeyCodeNames[{char( 51)}] = "3";
-        KeyCodeNames[{char( 52)}] = "4";
-        KeyCodeNames[{char( 53)}] = "5";
-        KeyCodeNames[{char( 54)}] = "6";
-        KeyCodeNames[{char( 55)}] = "7";
-        KeyCodeNames[{char( 56)}] = "8";
-        KeyCodeNames[{char( 57)}] = "9";
-        KeyCodeNames[{char( 58)}] = ":";
-        KeyCodeNames[{char( 59)}] = ";";
-        KeyCodeNames[{char( 60)}] = "<";
-        KeyCodeNames[{char( 61)}] = "=";
-        KeyCodeNames[{char( 62)}] = ">";
-        KeyCodeNames[{char( 63)}] = "?";
-        KeyCodeNames[{char( 64)}] = "@";
-        KeyCodeNames[{char( 65)}] = "A";
-        KeyCodeNames[{char( 66)}] = "B";
-        KeyCodeNames[{char( 67)}] = "C";
-        KeyCodeNames[{char( 68)}] = "D";
-        KeyCodeNames[{char( 69)}] = "E";
-        KeyCodeNames[{char( 70)}] = "F";
-        KeyCodeNames[{char( 71)}] = "G";
-        KeyCodeNames[{char( 72)}] = "H";
-        KeyCodeNames[{char( 73)}] = "I";
-        KeyCodeNames[{char( 74)}] = "J";
-        KeyCodeNames[{char( 75)}] = "K";
-        KeyCodeNames[{char( 76)}] = "L";
-        KeyCodeNames[{char( 77)}] = "M";
-        KeyCodeNames[{char( 78)}] = "N";
-        KeyCodeNames[{char( 79)}] = "O";
-        KeyCodeNames[{char( 80)}] = "P";
-        KeyCodeNames[{char( 81)}] = "Q";
-        KeyCodeNames[{char( 82)}] = "R";
-        KeyCodeNames[{char( 83)}] = "S";
-        KeyCodeNames[{char( 84)}] = "T";
-        KeyCodeNames[{char( 85)}] = "U";
-        KeyCodeNames[{char( 86)}] = "V";
-        KeyCodeNames[{char( 87)}] = "W";
-        KeyCodeNames[{char( 88)}] = "X";
-        KeyCodeNames[{char( 89)}] = "Y";
-        KeyCodeNames[{char( 90)}] = "Z";
-        KeyCodeNames[{char( 91)}] = "[";
-        KeyCodeNames[{char( 92)}] = "\\";
-        KeyCodeNames[{char( 93)}] = "]";
-        KeyCodeNames[{char( 94)}] = "^";
-        KeyCodeNames[{char( 95)}] = "_";
-        KeyCodeNames[{char( 96)}] = "`";
-        KeyCodeNames[{char( 97)}] = "a";
-        KeyCodeNames[{char( 98)}] = "b";
-        KeyCodeNames[{char( 99)}] = "c";
-        KeyCodeNames[{char(100)}] = "d";
-        KeyCodeNames[{char(101)}] = "e";
-        KeyCodeNames[{char(102)}] = "f";
-        KeyCodeNames[{char(103)}] = "g";
-        KeyCodeNames[{char(104)}] = "h";
-        KeyCodeNames[{char(105)}] = "i";
-        KeyCodeNames[{char(106)}] = "j";
-        KeyCodeNames[{char(107)}] = "k";
-        KeyCodeNames[{char(108)}] = "l";
-        KeyCodeNames[{char(109)}] = "m";
-        KeyCodeNames[{char(110)}] = "n";
-        KeyCodeNames[{char(111)}] = "o";
-        KeyCodeNames[{char(112)}] = "p";
-        KeyCodeNames[{char(113)}] = "q";
-        KeyCodeNames[{char(114)}] = "r";
-        KeyCodeNames[{char(115)}] = "s";
-        KeyCodeNames[{char(116)}] = "t";
-        KeyCodeNames[{char(117)}] = "u";
-        KeyCodeNames[{char(118)}] = "v";
-        KeyCodeNames[{char(119)}] = "w";
-        KeyCodeNames[{char(120)}] = "x";
-        KeyCodeNames[{char(121)}] = "y";
-        KeyCodeNames[{char(122)}] = "z";
-        KeyCodeNames[{char(123)}] = "{";
-        KeyCodeNames[{char(124)}] = "|";
-        KeyCodeNames[{char(125)}] = "}";
-        KeyCodeNames[{char(126)}] = "~";
+            void raw_signal_handler(int sig)
+            {
+                raw_restore();
+                for (size_t i = 0; i < ::std::size(raw_signals); ++i)
+                {
+                    if (raw_signals[i] == sig) sigaction(sig, &raw_old_actions[i], nullptr);
+                }
+                raise(sig);
+            }
 
-        return is_initialized_val = true;
-    }
+            void raw_install_handlers()
+            {
+                static bool installed = false;
+                if (installed) return;
+                installed = true;
 
-    // ----------------------------------------------------------------------------------- console functions
+                ::std::atexit(raw_restore);
 
-    [[nodiscard]] TKeyCode GetKey() {
-        TKeyCode res;
+                struct sigaction act{};
+                act.sa_handler = raw_signal_handler;
+                sigemptyset(&act.sa_mask);
+                act.sa_flags = SA_RESETHAND;
+                for (size_t i = 0; i < ::std::size(raw_signals); ++i)
+                {
+                    sigaction(raw_signals[i], &act, &raw_old_actions[i]);
+                }
+            }
 
-        #if defined(_WIN32)
+        } // namespace
 
-            do {
-                int i = _getch();
-                int c = static_cast<unsigned char>(i);
-                if (c != i)
+        TRawModeSession::TRawModeSession()
+        {
+            ::std::lock_guard lock(raw_mtx);
+            if (raw_depth == 0)
+            {
+                termios saved;
+                if (tcgetattr(STDIN_FILENO, &saved) == -1) return;
+
+                termios raw = saved;
+                raw.c_lflag &= ~(ISIG | ICANON | ECHO);
+                raw.c_cc[VMIN] = 1;
+                raw.c_cc[VTIME] = 0;
+
+                raw_install_handlers();
+                raw_saved = saved;
+                raw_on    = 1;
+                if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) == -1)
                 {
-                    FlushConsoleInputBuffer(GetStdHandle(STD_INPUT_HANDLE));
-                    break;
+                    raw_on = 0;
+                    return;
                 }
-                res << c;
             }
-            while (_kbhit());
+            ++raw_depth;
+            _ok = true;
+        }
 
-        #elif defined(_POSIX_VERSION)
+        TRawModeSession::~TRawModeSession()
+        {
+            if (not _ok) return;
+            ::std::lock_guard lock(raw_mtx);
+            if (--raw_depth == 0) raw_restore();
+        }
+
+    #endif
+
+    bool TRawModeSession::ok() const noexcept { return _ok; }
+
+    bool TRawModeSession::active() noexcept
+    {
+        #if defined(_WIN32)
+            return raw_depth > 0;
+        #else
+            return raw_on;
+        #endif
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- bracketed paste
 
-            char buf[16];
-            ssize_t bytesRead;
+    #if defined(_WIN32)
 
-            // save terminal mode
-            termios oldt;
-            if (tcgetattr(STDIN_FILENO, &oldt) == -1) return res;
-            termios curt = oldt;
-            SIB_SCOPE_GUARD( (void)tcsetattr(STDIN_FILENO, TCSANOW, &oldt); );
+        TBracketedPaste::TBracketedPaste() {}
+        TBracketedPaste::~TBracketedPaste() {}
 
-            // first read buf
+    #else
+
+        namespace {
+
+            ::std::mutex paste_mutex;
+            int          paste_depth = 0;
+            bool         paste_on    = false;
+
+            void paste_mode(char const* seq, size_t size)
             {
-                // set raw & block mode
-                curt.c_lflag &= ~(ISIG | ICANON | ECHO);
-                curt.c_cc[VMIN] = 1;
-                curt.c_cc[VTIME] = 0;
-                if (tcsetattr(STDIN_FILENO, TCSANOW, &curt) == -1) return res;
-            
-                bytesRead = ::read(STDIN_FILENO, buf, sizeof(buf));
-                usleep(100000); // 0.1 sec
+                [[maybe_unused]] auto res = ::write(STDOUT_FILENO, seq, size);
+            }
 
-                // set not block mode
-                curt.c_cc[VMIN] = 0;
-                if (tcsetattr(STDIN_FILENO, TCSANOW, &curt) == -1) return res;
+        } // namespace
+
+        TBracketedPaste::TBracketedPaste()
+        {
+            ::std::lock_guard lock(paste_mutex);
+            if (paste_depth++ == 0 and ::isatty(STDIN_FILENO) and ::isatty(STDOUT_FILENO))
+            {
+                outstream.flush();
+                paste_mode("\x1B[?2004h", 8);
+                paste_on = true;
             }
+        }
 
-            for(;; bytesRead = ::read(STDIN_FILENO, buf, sizeof(buf)))
+        TBracketedPaste::~TBracketedPaste()
+        {
+            ::std::lock_guard lock(paste_mutex);
+            if (--paste_depth == 0 and paste_on)
             {
-                if (bytesRead > 0)
+                outstream.flush();
+                paste_mode("\x1B[?2004l", 8);
+                paste_on = false;
+            }
+        }
+
+    #endif
+
+
+
+    // ----------------------------------------------------------------------------------- key decoder
+
+    thread_local int KEY_SEQUENCE_TIMEOUT_MS = 25;
+
+    bool TKeyDecoder::feed(char ch)
+    {
+        auto uch = static_cast<unsigned char>(ch);
+        if (_code.size() == TKeyCode::capacity) _overlong = true;
+        _code << ch;
+
+        switch (_state)
+        {
+            case TState::Ground:
+                if (uch == 27)
                 {
-                    res.insert(res.end(), buf, buf + bytesRead);
-                    continue;
+                    _state = TState::Esc;
+                    return false;
                 }
-                if ((bytesRead == 0) or (errno != EINTR)) break;
-            }
+                if (uch >= 0xC0 and uch <= 0xF7)
+                {
+                    _need  = (uch >= 0xF0) ? 3 : (uch >= 0xE0) ? 2 : 1;
+                    _state = TState::Utf8;
+                    return false;
+                }
+                return true;
 
-        #else
+            case TState::Esc:
+                if (ch == '[') { _state = TState::Csi; return false; }
+                if (ch == 'O') { _state = TState::Ss3; return false; }
+                return true; // Alt + ch
 
-            static_assert(false, "unknown platform");
+            case TState::Csi:
+                if (_code.size() == 3 and ch == '[') { _state = TState::CsiLinux; return false; }
+                if (uch < 0x40 or uch > 0x7E) return false;
+                if (_overlong)
+                {
+                    // cut to capacity it would read as another key - dropped
+                    *this = TKeyDecoder();
+                    return false;
+                }
+                return true;
 
-        #endif
+            case TState::CsiLinux:
+            case TState::Ss3:
+                return true;
+
+            case TState::Utf8:
+                return (--_need == 0) or ((uch & 0xC0) != 0x80);
+        }
+        return true;
+    }
+
+    bool TKeyDecoder::pending() const noexcept
+    {
+        return _state != TState::Ground;
+    }
+
+    TKeyCode TKeyDecoder::take()
+    {
+        TKeyCode res = TTerminalKeys::current().translate(_code);
+        _code     = {};
+        _state    = TState::Ground;
+        _need     = 0;
+        _overlong = false;
         return res;
     }
 
-    TKeyCode WaitKeyCodes(
-        ::std::set<TKeyCode> const& codes,
-        TString              const& msg /* = {} */)
+
+
+    // ----------------------------------------------------------------------------------- terminal keys
+
+    namespace {
+
+        struct TCapKey
+        {
+            unsigned short cap;  // index of the string capability in a compiled terminfo entry
+            TKeyCode       key;
+        };
+
+        constexpr TCapKey terminfo_keys[] = {
+            {  55, KC_BACKSPACE     }, // kbs
+            {  59, KC_DELETE        }, // kdch1
+            {  61, KC_DOWN          }, // kcud1
+            {  66, KC_F1            }, // kf1
+            {  68, KC_F2            }, // kf2
+            {  69, KC_F3            }, // kf3
+            {  70, KC_F4            }, // kf4
+            {  71, KC_F5            }, // kf5
+            {  72, KC_F6            }, // kf6
+            {  73, KC_F7            }, // kf7
+            {  74, KC_F8            }, // kf8
+            {  75, KC_F9            }, // kf9
+            {  67, KC_F10           }, // kf10
+            { 216, KC_F11           }, // kf11
+            { 217, KC_F12           }, // kf12
+            {  76, KC_HOME          }, // khome
+            {  77, KC_INSERT        }, // kich1
+            {  79, KC_LEFT          }, // kcub1
+            {  81, KC_PAGE_DOWN     }, // knp
+            {  82, KC_PAGE_UP       }, // kpp
+            {  83, KC_RIGHT         }, // kcuf1
+            {  87, KC_UP            }, // kcuu1
+            { 164, KC_END           }, // kend
+            { 165, KC_ENTER         }, // kent
+            { 139, KC_NUM_HOME      }, // ka1
+            { 140, KC_NUM_PAGE_UP   }, // ka3
+            { 142, KC_NUM_END       }, // kc1
+            { 143, KC_NUM_PAGE_DOWN }, // kc3
+        };
+
+    } // namespace
+
+    ::std::vector<TTerminalKeys::TEntry> TTerminalKeys::parse(::std::string_view image)
     {
-        outstream << msg;
-        outstream.flush();
-        while (true) {
-            auto kc = codes.find(GetKey());
-            if (kc != codes.end()) return *kc;
+        ::std::vector<TEntry> res;
+
+        auto u16 = [&](size_t at) {
+            return static_cast<unsigned>(static_cast<unsigned char>(image[at]))
+                 | static_cast<unsigned>(static_cast<unsigned char>(image[at + 1])) << 8;
+        };
+
+        if (image.size() < 12) return res;
+
+        // 0432 - legacy format (16-bit numbers), 01036 - extended number format (32-bit numbers)
+        size_t num_size = (u16(0) == 0432) ? 2 : (u16(0) == 01036) ? 4 : 0;
+        if (num_size == 0) return res;
+
+        size_t names_size = u16( 2);
+        size_t bool_count = u16( 4);
+        size_t num_count  = u16( 6);
+        size_t str_count  = u16( 8);
+        size_t table_size = u16(10);
+
+        size_t offsets = 12 + names_size + bool_count;
+        offsets += offsets % 2; // numbers start at an even byte
+        offsets += num_count * num_size;
+
+        size_t table = offsets + str_count * 2;
+        if (table + table_size > image.size()) return res;
+
+        for (auto const& [cap, key] : terminfo_keys)
+        {
+            if (cap >= str_count or key.empty()) continue;
+
+            unsigned offset = u16(offsets + cap * 2);
+            if (offset >= table_size) continue; // 0xFFFF - absent, 0xFFFE - cancelled
+
+            auto seq = image.substr(table + offset, table_size - offset);
+            seq = seq.substr(0, seq.find('\0'));
+            if (seq.empty() or seq.size() > TKeyCode::capacity) continue;
+
+            TKeyCode raw;
+            for (char ch : seq) raw << ch;
+            if (raw != key) res.push_back({ raw.data(), key.data() });
         }
+
+        // the first capability wins for a sequence shared by several keys
+        ::std::stable_sort(res.begin(), res.end(), [](auto const& a, auto const& b) { return a.raw < b.raw; });
+        res.erase(::std::unique(res.begin(), res.end(), [](auto const& a, auto const& b) { return a.raw == b.raw; }), res.end());
+        return res;
     }
 
-    TKeyCode WaitAnyKey(
-        TString const& msg /* = {} */)
+    #if defined(_WIN32)
+
+        TTerminalKeys::TTerminalKeys(char const*, ::std::string const&) {}
+
+        TTerminalKeys::~TTerminalKeys() = default;
+
+    #else
+
+        namespace {
+
+            struct TKeysCacheHeader
+            {
+                char            magic[8];
+                ::std::uint32_t version;
+                ::std::uint32_t count;
+                ::std::int64_t  source_mtime;  // ns
+                ::std::uint64_t source_size;
+            };
+
+            constexpr char            keys_cache_magic[8] = { 'S', 'I', 'B', 'K', 'E', 'Y', 'S', '\0' };
+            constexpr ::std::uint32_t keys_cache_version  = 1;
+
+            ::std::int64_t mtime_ns(struct stat const& st)
+            {
+                #if defined(__APPLE__)
+                    return ::std::int64_t(st.st_mtimespec.tv_sec) * 1'000'000'000 + st.st_mtimespec.tv_nsec;
+                #else
+                    return ::std::int64_t(st.st_mtim.tv_sec) * 1'000'000'000 + st.st_mtim.tv_nsec;
+                #endif
+            }
+
+            // compiled entry: <dir>/<first char>/<name>, or <dir>/<hex of first char>/<name> (macOS)
+            ::std::string find_terminfo(::std::string const& term, struct stat& st)
+            {
+                ::std::vector<::std::string> dirs;
+                if (char const* dir = ::getenv("TERMINFO")) dirs.push_back(dir);
+                if (char const* home = ::getenv("HOME")) dirs.push_back(::std::string(home) + "/.terminfo");
+                if (char const* list = ::getenv("TERMINFO_DIRS"))
+                {
+                    ::std::string_view rest = list;
+                    while (not rest.empty())
+                    {
+                        auto part = rest.substr(0, rest.find(':'));
+                        dirs.push_back(part.empty() ? "/usr/share/terminfo" : ::std::string(part));
+                        rest.remove_prefix(::std::min(rest.size(), part.size() + 1));
+                    }
+                }
+                for (char const* dir : { "/etc/terminfo", "/lib/terminfo", "/usr/share/terminfo" })
+                    dirs.push_back(dir);
+
+                char hex[3];
+                ::snprintf(hex, sizeof(hex), "%02x", static_cast<unsigned char>(term[0]));
+                for (auto const& dir : dirs)
+                {
+                    for (::std::string sub : { ::std::string(1, term[0]), ::std::string(hex) })
+                    {
+                        auto path = dir + "/" + sub + "/" + term;
+                        if (::stat(path.c_str(), &st) == 0 and S_ISREG(st.st_mode)) return path;
+                    }
+                }
+                return {};
+            }
+
+            ::std::atomic<bool> keys_cache_enabled{ false };
+
+            ::std::string default_keys_cache_dir()
+            {
+                if (char const* cache = ::getenv("XDG_CACHE_HOME"); cache and *cache) return ::std::string(cache) + "/sib";
+                if (char const* home  = ::getenv("HOME");           home  and *home ) return ::std::string(home) + "/.cache/sib";
+                return {};
+            }
+
+            ::std::string read_file(::std::string const& path)
+            {
+                ::std::string res;
+                int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) return res;
+
+                char    buf[4096];
+                ssize_t bytes;
+                while ((bytes = ::read(fd, buf, sizeof(buf))) > 0) res.append(buf, static_cast<size_t>(bytes));
+                ::close(fd);
+                return res;
+            }
+
+            // written to a temporary file and renamed, so a reader never sees a partial cache
+            void write_keys_cache(::std::string const& path, TKeysCacheHeader const& header, ::std::vector<TTerminalKeys::TEntry> const& entries)
+            {
+                auto dir = path.substr(0, path.rfind('/'));
+                if (auto parent = dir.rfind('/'); parent != 0 and parent != ::std::string::npos)
+                    ::mkdir(dir.substr(0, parent).c_str(), 0755);
+                ::mkdir(dir.c_str(), 0755);
+
+                auto tmp = path + "." + ::std::to_string(::getpid());
+                int  fd  = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (fd < 0) return;
+
+                size_t data_size = entries.size() * sizeof(TTerminalKeys::TEntry);
+                bool   ok = ::write(fd, &header, sizeof(header)) == ssize_t(sizeof(header))
+                        and ::write(fd, entries.data(), data_size) == ssize_t(data_size);
+                ::close(fd);
+
+                if (not ok or ::rename(tmp.c_str(), path.c_str()) != 0) ::unlink(tmp.c_str());
+            }
+
+        } // namespace
+
+        TTerminalKeys::TTerminalKeys(char const* term_env, ::std::string const& cache_dir)
+        {
+            if (term_env == nullptr or *term_env == '\0') return;
+            ::std::string term = term_env;
+            if (term.find('/') != ::std::string::npos or term[0] == '.') return;
+
+            struct stat source{};
+            auto source_path = find_terminfo(term, source);
+            if (source_path.empty()) return;
+
+            auto cache_path = cache_dir.empty() ? ::std::string() : cache_dir + "/keys-" + term;
+            if (not cache_path.empty())
+            {
+                int fd = ::open(cache_path.c_str(), O_RDONLY | O_CLOEXEC);
+                struct stat st{};
+                if (fd >= 0 and ::fstat(fd, &st) == 0 and size_t(st.st_size) >= sizeof(TKeysCacheHeader))
+                {
+                    void* map = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (map != MAP_FAILED)
+                    {
+                        auto const& header = *static_cast<TKeysCacheHeader const*>(map);
+                        bool valid = ::std::memcmp(header.magic, keys_cache_magic, sizeof(keys_cache_magic)) == 0
+                                 and header.version      == keys_cache_version
+                                 and header.source_mtime == mtime_ns(source)
+                                 and header.source_size  == ::std::uint64_t(source.st_size)
+                                 and size_t(st.st_size)  == sizeof(header) + header.count * sizeof(TEntry);
+                        if (valid)
+                        {
+                            _begin    = reinterpret_cast<TEntry const*>(static_cast<char const*>(map) + sizeof(header));
+                            _end      = _begin + header.count;
+                            _map      = map;
+                            _map_size = size_t(st.st_size);
+                            _cached   = true;
+                        }
+                        else
+                        {
+                            ::munmap(map, size_t(st.st_size));
+                        }
+                    }
+                }
+                if (fd >= 0) ::close(fd);
+                if (_cached) return;
+            }
+
+            _parsed = parse(read_file(source_path));
+            _begin  = _parsed.data();
+            _end    = _parsed.data() + _parsed.size();
+
+            if (not cache_path.empty())
+            {
+                TKeysCacheHeader header{};
+                ::std::memcpy(header.magic, keys_cache_magic, sizeof(keys_cache_magic));
+                header.version      = keys_cache_version;
+                header.count        = static_cast<::std::uint32_t>(_parsed.size());
+                header.source_mtime = mtime_ns(source);
+                header.source_size  = ::std::uint64_t(source.st_size);
+                write_keys_cache(cache_path, header, _parsed);
+            }
+        }
+
+        TTerminalKeys::~TTerminalKeys()
+        {
+            if (_map) ::munmap(const_cast<void*>(_map), _map_size);
+        }
+
+    #endif
+
+    namespace {
+
+        ::std::atomic<TTerminalKeys const*> keys_override{ nullptr };
+
+    } // namespace
+
+    TTerminalKeys const& TTerminalKeys::current()
+    {
+        if (auto keys = keys_override.load(::std::memory_order_acquire)) return *keys;
+
+        #if defined(_WIN32)
+            static TTerminalKeys const keys(nullptr, {});
+        #else
+            static TTerminalKeys const keys(::getenv("TERM"), keys_cache_enabled ? default_keys_cache_dir() : ::std::string());
+        #endif
+        return keys;
+    }
+
+    void TTerminalKeys::enable_cache(bool enable /* = true */) noexcept
+    {
+        #if !defined(_WIN32)
+            keys_cache_enabled = enable;
+        #else
+            (void)enable;
+        #endif
+    }
+
+    TTerminalKeys const* TTerminalKeys::set_current(TTerminalKeys const* keys) noexcept
+    {
+        return keys_override.exchange(keys, ::std::memory_order_acq_rel);
+    }
+
+    TKeyCode TTerminalKeys::translate(TKeyCode code) const noexcept
+    {
+        if (_begin == _end) return code;
+
+        auto it = ::std::lower_bound(_begin, _end, code.data(), [](TEntry const& entry, TKeyCode::data_type raw) { return entry.raw < raw; });
+        return (it == _end or it->raw != code.data()) ? code : TKeyCode::from_data(it->key);
+    }
+
+    size_t TTerminalKeys::size() const noexcept
+    {
+        return static_cast<size_t>(_end - _begin);
+    }
+
+    bool TTerminalKeys::from_cache() const noexcept
+    {
+        return _cached;
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- console lib initialization
+
+    static bool is_initialized_val = false;
+
+    bool const & is_initialized_console_unit = is_initialized_val;
+
+    bool Init(bool keep_raw_mode /* = false */)
+    {
+        if (keep_raw_mode)
+        {
+            static ::std::optional<TRawModeSession> init_session;
+            if (not init_session) init_session.emplace();
+        }
+
+        if (is_initialized_val) return true;
+
+        return is_initialized_val = true;
+    }
+
+    // ----------------------------------------------------------------------------------- console input
+
+    #if defined(_POSIX_VERSION) && !defined(_WIN32)
+
+        namespace {
+
+            // bytes read from stdin and not decoded yet
+            struct TInputBuffer
+            {
+                ::std::vector<char> buf = ::std::vector<char>(64 * 1024);
+                size_t              pos = 0;
+                size_t              len = 0;
+
+                // a sequence started by one call (GetKey, an event loop) and finished by the next one
+                TKeyDecoder                             decoder          {};
+                ::std::chrono::steady_clock::time_point pending_deadline {};
+
+                bool empty() const noexcept { return pos >= len; }
+
+                ::std::string_view rest() const noexcept { return { buf.data() + pos, len - pos }; }
+
+                // false - timeout or error
+                static bool wait(int timeout_ms)
+                {
+                    pollfd pfd{ STDIN_FILENO, POLLIN, 0 };
+                    for (;;)
+                    {
+                        int ready = ::poll(&pfd, 1, timeout_ms);
+                        if (ready > 0) return true;
+                        if (ready == 0 or errno != EINTR) return false;
+                    }
+                }
+
+                // appends to the unread bytes (moved to the front), the buffer grows when full
+                // > 0 - bytes read, 0 - end of input, < 0 - error
+                ssize_t read()
+                {
+                    if (pos > 0)
+                    {
+                        ::std::memmove(buf.data(), buf.data() + pos, len - pos);
+                        len -= pos;
+                        pos  = 0;
+                    }
+                    if (len == buf.size()) buf.resize(buf.size() * 2);
+
+                    for (;;)
+                    {
+                        ssize_t bytes = ::read(STDIN_FILENO, buf.data() + len, buf.size() - len);
+                        if (bytes > 0) len += static_cast<size_t>(bytes);
+                        if (bytes >= 0 or errno != EINTR) return bytes;
+                    }
+                }
+
+                // false - timeout, end of input or error
+                bool fill(int timeout_ms)
+                {
+                    return wait(timeout_ms) and read() > 0;
+                }
+            };
+
+            thread_local TInputBuffer input{};
+
+        } // namespace
+
+    #endif
+
+
+
+    // ----------------------------------------------------------------------------------- cancellation
+
+    #if defined(_WIN32)
+
+        TCancelToken::TCancelToken()
+            : _event(CreateEventW(nullptr, TRUE, FALSE, nullptr))
+        {}
+
+        TCancelToken::~TCancelToken()
+        {
+            if (_event) CloseHandle(_event);
+        }
+
+        void TCancelToken::cancel() noexcept
+        {
+            _cancelled.store(true, ::std::memory_order_release);
+            if (_event) SetEvent(_event);
+        }
+
+        void TCancelToken::reset() noexcept
+        {
+            _cancelled.store(false, ::std::memory_order_release);
+            if (_event) ResetEvent(_event);
+        }
+
+    #else
+
+        TCancelToken::TCancelToken()
+        {
+            #if defined(__linux__)
+                _read_fd = _write_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            #else
+                int fds[2];
+                if (::pipe(fds) == 0)
+                {
+                    for (int fd : fds)
+                    {
+                        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+                        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                    }
+                    _read_fd  = fds[0];
+                    _write_fd = fds[1];
+                }
+            #endif
+        }
+
+        TCancelToken::~TCancelToken()
+        {
+            if (_read_fd >= 0) ::close(_read_fd);
+            if (_write_fd >= 0 and _write_fd != _read_fd) ::close(_write_fd);
+        }
+
+        void TCancelToken::cancel() noexcept
+        {
+            _cancelled.store(true, ::std::memory_order_release);
+            if (_write_fd < 0) return;
+
+            // a full pipe (or eventfd counter) is readable already
+            #if defined(__linux__)
+                ::std::uint64_t one = 1;
+                [[maybe_unused]] auto res = ::write(_write_fd, &one, sizeof(one));
+            #else
+                char one = 1;
+                [[maybe_unused]] auto res = ::write(_write_fd, &one, sizeof(one));
+            #endif
+        }
+
+        void TCancelToken::reset() noexcept
+        {
+            _cancelled.store(false, ::std::memory_order_release);
+            if (_read_fd < 0) return;
+
+            char buf[64];
+            while (::read(_read_fd, buf, sizeof(buf)) > 0) {}
+        }
+
+    #endif
+
+    bool TCancelToken::cancelled() const noexcept
+    {
+        return _cancelled.load(::std::memory_order_acquire);
+    }
+
+    TCancelToken::native_handle_type TCancelToken::native_handle() const noexcept
+    {
+        #if defined(_WIN32)
+            return _event;
+        #else
+            return _read_fd;
+        #endif
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- key bindings
+
+    TKeyBindings::TKeyBindings(::std::string normal_mode /* = "normal" */)
+    {
+        add_mode(::std::move(normal_mode));
+    }
+
+    TKeyBindings::TModeId TKeyBindings::add_mode(::std::string name, TModeId parent /* = NO_MODE */)
+    {
+        if (_modes.size() >= NO_MODE) throw ::std::length_error("TKeyBindings: too many modes");
+        if (parent != NO_MODE and parent >= _modes.size()) throw ::std::out_of_range("TKeyBindings: unknown parent mode");
+
+        _modes.push_back({ ::std::move(name), parent });
+        _dirty = true;
+        return static_cast<TModeId>(_modes.size() - 1);
+    }
+
+    void TKeyBindings::bind(TModeId mode, ::std::initializer_list<TKeyCode> chord, TKeyCallback action, TModeId next_mode /* = NO_MODE */)
+    {
+        if (mode >= _modes.size()) throw ::std::out_of_range("TKeyBindings: unknown mode");
+        if (next_mode != NO_MODE and next_mode >= _modes.size()) throw ::std::out_of_range("TKeyBindings: unknown next mode");
+        if (chord.size() == 0 or ::std::find(chord.begin(), chord.end(), KC_EMPTY) != chord.end())
+            throw ::std::invalid_argument("TKeyBindings: empty chord or key");
+
+        _dirty = true;
+        for (auto& binding : _bindings)
+        {
+            if (binding.mode == mode and ::std::equal(binding.chord.begin(), binding.chord.end(), chord.begin(), chord.end()))
+            {
+                binding.action    = action;
+                binding.next_mode = next_mode;
+                return;
+            }
+        }
+        _bindings.push_back({ mode, chord, action, next_mode });
+    }
+
+    void TKeyBindings::compile()
+    {
+        // every byte used by a chord gets a class of its own, the rest share class 0
+        _class.fill(0);
+        unsigned classes = 1;
+        for (auto const& binding : _bindings)
+            for (auto code : binding.chord)
+                for (size_t i = 0; i < code.size(); ++i)
+                {
+                    auto& cls = _class[static_cast<unsigned char>(code[i])];
+                    if (cls == 0) cls = static_cast<::std::uint16_t>(classes++);
+                }
+        unsigned const end_of_key = classes;
+        _width = classes + 1;
+
+        // state 0 - no transition
+        _next.assign(_width, 0);
+        _accept.assign(1, -1);
+        ::std::vector<size_t> layer(1, 0); // depth in the mode chain of the binding that made the state
+
+        auto new_state = [&](size_t depth) {
+            auto state = static_cast<::std::uint32_t>(_accept.size());
+            _next.resize(_next.size() + _width, 0);
+            _accept.push_back(-1);
+            layer.push_back(depth);
+            return state;
+        };
+
+        auto walk = [&](::std::uint32_t state, unsigned symbol, size_t depth) {
+            if (_accept[state] >= 0)
+            {
+                if (layer[state] == depth)
+                    throw ::std::logic_error("TKeyBindings: a chord continues a shorter chord of the same mode");
+                _accept[state] = -1; // shadowed by the child mode
+            }
+            size_t slot = size_t(state) * _width + symbol;
+            if (_next[slot] == 0)
+            {
+                auto next = new_state(depth);
+                _next[slot] = next;
+            }
+            return _next[slot];
+        };
+
+        for (size_t mode = 0; mode < _modes.size(); ++mode)
+        {
+            ::std::vector<TModeId> chain;
+            for (auto id = static_cast<TModeId>(mode); id != NO_MODE; id = _modes[id].parent)
+            {
+                if (chain.size() > _modes.size()) throw ::std::logic_error("TKeyBindings: cyclic modes");
+                chain.push_back(id);
+            }
+            ::std::reverse(chain.begin(), chain.end());
+
+            _modes[mode].start = new_state(0);
+            for (size_t depth = 0; depth < chain.size(); ++depth)
+            {
+                for (size_t idx = 0; idx < _bindings.size(); ++idx)
+                {
+                    auto const& binding = _bindings[idx];
+                    if (binding.mode != chain[depth]) continue;
+
+                    auto state = _modes[mode].start;
+                    for (auto code : binding.chord)
+                    {
+                        for (size_t i = 0; i < code.size(); ++i)
+                            state = walk(state, _class[static_cast<unsigned char>(code[i])], depth + 1);
+                        state = walk(state, end_of_key, depth + 1);
+                    }
+                    for (unsigned symbol = 0; symbol < _width; ++symbol)
+                    {
+                        auto next = _next[size_t(state) * _width + symbol];
+                        if (next and layer[next] == depth + 1)
+                            throw ::std::logic_error("TKeyBindings: a chord continues a shorter chord of the same mode");
+                    }
+                    _accept[state] = static_cast<::std::int32_t>(idx);
+                    layer[state]   = depth + 1;
+                }
+            }
+        }
+
+        _dirty = false;
+        _state = _modes[_mode].start;
+    }
+
+    TKeyBindings::TResult TKeyBindings::step(unsigned symbol, TKeyCode code)
+    {
+        auto next = _next[size_t(_state) * _width + symbol];
+        if (next == 0)
+        {
+            _state = _modes[_mode].start;
+            return TResult::Unbound;
+        }
+        if (_accept[next] < 0)
+        {
+            _state = next;
+            return TResult::Pending;
+        }
+
+        auto const& binding = _bindings[size_t(_accept[next])];
+        if (binding.next_mode != NO_MODE) _mode = binding.next_mode;
+        _state = _modes[_mode].start;
+
+        // a copy: the action may change the bindings
+        auto action = binding.action;
+        if (action) action(code);
+        return TResult::Done;
+    }
+
+    TKeyBindings::TResult TKeyBindings::run(TKeyCode code)
+    {
+        for (size_t i = 0; i < code.size(); ++i)
+        {
+            auto res = step(_class[static_cast<unsigned char>(code[i])], code);
+            if (res == TResult::Unbound) return res;
+        }
+        return step(_width - 1, code);
+    }
+
+    TKeyBindings::TResult TKeyBindings::key(TKeyCode code)
+    {
+        if (_dirty) compile();
+
+        bool started = _state != _modes[_mode].start;
+        auto res = run(code);
+        if (res == TResult::Unbound and started) res = run(code);
+        return res;
+    }
+
+    void TKeyBindings::set_mode(TModeId mode)
+    {
+        if (mode >= _modes.size()) throw ::std::out_of_range("TKeyBindings: unknown mode");
+        _mode = mode;
+        reset();
+    }
+
+    void TKeyBindings::reset() noexcept
+    {
+        _state = _dirty ? 0 : _modes[_mode].start;
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- event loop
+
+    TEventLoop::TEventLoop()
+    {
+        #if defined(__linux__)
+            // stdin redirected from a regular file can't be watched by epoll, poll is used then
+            _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+            if (_epoll >= 0)
+            {
+                epoll_event ev{};
+                ev.events = EPOLLIN;
+                ev.data.fd = STDIN_FILENO;
+                if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, STDIN_FILENO, &ev) != 0)
+                {
+                    ::close(_epoll);
+                    _epoll = -1;
+                }
+            }
+        #endif
+    }
+
+    TEventLoop::~TEventLoop()
+    {
+        #if defined(__linux__)
+            if (_epoll >= 0) ::close(_epoll);
+        #endif
+    }
+
+    void TEventLoop::set_reactions(TKeyCodeReactions const* reactions) noexcept
+    {
+        _reactions = reactions;
+    }
+
+    void TEventLoop::set_bindings(TKeyBindings* bindings) noexcept
+    {
+        _bindings = bindings;
+    }
+
+    void TEventLoop::on_key(TKeyFunc func)
+    {
+        _on_key = ::std::move(func);
+    }
+
+    void TEventLoop::set_cancel(TCancelToken const* token)
+    {
+        #if defined(__linux__)
+            if (_epoll >= 0)
+            {
+                if (_cancel and _cancel->native_handle() >= 0)
+                    ::epoll_ctl(_epoll, EPOLL_CTL_DEL, _cancel->native_handle(), nullptr);
+                if (token and token->native_handle() >= 0)
+                {
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = token->native_handle();
+                    ::epoll_ctl(_epoll, EPOLL_CTL_ADD, ev.data.fd, &ev);
+                }
+            }
+        #endif
+        _cancel = token;
+    }
+
+    TEventLoop::TTimerId TEventLoop::add_timer(TClock::duration delay, TTimerFunc func, TClock::duration period /* = {} */)
+    {
+        TTimerId id = ++_next_id;
+        _timers.push_back(::std::make_unique<TTimer>(TTimer{ id, TClock::now() + delay, period, ::std::move(func), true }));
+        return id;
+    }
+
+    bool TEventLoop::cancel_timer(TTimerId id) noexcept
+    {
+        for (auto& timer : _timers)
+        {
+            if (timer->id != id or not timer->active) continue;
+            // a running timer is erased when fire_timers is done
+            timer->active = false;
+            if (not _firing) ::std::erase_if(_timers, [](auto const& t) { return not t->active; });
+            return true;
+        }
+        return false;
+    }
+
+    void TEventLoop::stop() noexcept
+    {
+        _stopped = true;
+    }
+
+    bool TEventLoop::stopped() const noexcept
+    {
+        return _stopped;
+    }
+
+    bool TEventLoop::input_closed() const noexcept
+    {
+        return _input_closed;
+    }
+
+    void TEventLoop::dispatch(TKeyCode code)
+    {
+        if (_bindings and _bindings->key(code) != TKeyBindings::TResult::Unbound) return;
+        if (_reactions)
+        {
+            auto react = _reactions->find(code);
+            if (react != _reactions->end() and react->second.func) react->second.func();
+        }
+        if (_on_key) _on_key(code);
+    }
+
+    size_t TEventLoop::fire_timers()
+    {
+        size_t count = 0;
+        auto   now   = TClock::now();
+
+        _firing = true;
+        // timers added by a callback get their turn on the next call
+        for (size_t i = 0, size = _timers.size(); i < size and not _stopped; ++i)
+        {
+            TTimer& timer = *_timers[i];
+            if (not timer.active or timer.deadline > now) continue;
+
+            if (timer.period > TClock::duration::zero())
+            {
+                timer.deadline += timer.period;
+                if (timer.deadline <= now) timer.deadline = now + timer.period;
+            }
+            else
+            {
+                timer.active = false;
+            }
+
+            ++count;
+            if (timer.func) timer.func();
+        }
+        _firing = false;
+
+        ::std::erase_if(_timers, [](auto const& timer) { return not timer->active; });
+        return count;
+    }
+
+    int TEventLoop::wait_timeout(int timeout_ms) const
+    {
+        auto now = TClock::now();
+        auto limit = [&](TClock::time_point deadline) {
+            auto left = ::std::chrono::ceil<::std::chrono::milliseconds>(deadline - now).count();
+            int  ms   = static_cast<int>(::std::max<decltype(left)>(left, 0));
+            if (timeout_ms < 0 or ms < timeout_ms) timeout_ms = ms;
+        };
+
+        for (auto const& timer : _timers)
+            if (timer->active) limit(timer->deadline);
+
+        #if defined(_POSIX_VERSION) && !defined(_WIN32)
+            if (input.decoder.pending()) limit(input.pending_deadline);
+        #endif
+
+        return timeout_ms;
+    }
+
+    #if defined(_WIN32)
+
+        size_t TEventLoop::drain_input()
+        {
+            size_t count = 0;
+            while (not _stopped and _kbhit())
+            {
+                dispatch(GetKey());
+                ++count;
+            }
+            return count;
+        }
+
+        void TEventLoop::close_input()
+        {
+            _input_closed = true;
+        }
+
+        size_t TEventLoop::run_once(int timeout_ms /* = -1 */)
+        {
+            size_t count = drain_input();
+
+            int timeout = wait_timeout(count ? 0 : timeout_ms);
+            if (_cancel and _cancel->cancelled()) stop();
+            if (_stopped) return count;
+
+            HANDLE handles[2];
+            DWORD  handle_count = 0;
+            DWORD  input_index  = MAXDWORD;
+            DWORD  cancel_index = MAXDWORD;
+            if (not _input_closed)
+            {
+                input_index = handle_count;
+                handles[handle_count++] = GetStdHandle(STD_INPUT_HANDLE);
+            }
+            if (_cancel and _cancel->native_handle())
+            {
+                cancel_index = handle_count;
+                handles[handle_count++] = _cancel->native_handle();
+            }
+
+            DWORD wait_ms = (timeout < 0) ? INFINITE : static_cast<DWORD>(timeout);
+            if (handle_count == 0)
+            {
+                if (timeout < 0) return count; // nothing can happen any more
+                Sleep(wait_ms);
+            }
+            else
+            {
+                DWORD ready = WaitForMultipleObjects(handle_count, handles, FALSE, wait_ms);
+                if (ready == WAIT_OBJECT_0 + cancel_index)
+                {
+                    stop();
+                }
+                else if (ready == WAIT_OBJECT_0 + input_index)
+                {
+                    if (_kbhit())
+                    {
+                        count += drain_input();
+                    }
+                    else
+                    {
+                        // mouse, focus and resize events keep the handle signaled
+                        INPUT_RECORD record;
+                        DWORD        read = 0;
+                        ReadConsoleInput(handles[input_index], &record, 1, &read);
+                    }
+                }
+                else if (ready == WAIT_FAILED)
+                {
+                    close_input();
+                }
+            }
+
+            if (not _stopped) count += fire_timers();
+            return count;
+        }
+
+    #elif defined(_POSIX_VERSION)
+
+        size_t TEventLoop::drain_input()
+        {
+            size_t count = 0;
+            while (not _stopped and not input.empty())
+            {
+                bool started = not input.decoder.pending();
+                if (input.decoder.feed(input.buf[input.pos++]))
+                {
+                    dispatch(input.decoder.take());
+                    ++count;
+                }
+                // the timeout counts from the first byte of a sequence; calls that feed nothing
+                // (a timer woke the loop) must not move it
+                else if (started and input.decoder.pending())
+                {
+                    input.pending_deadline = TClock::now() + ::std::chrono::milliseconds(KEY_SEQUENCE_TIMEOUT_MS);
+                }
+            }
+            return count;
+        }
+
+        void TEventLoop::close_input()
+        {
+            _input_closed = true;
+            #if defined(__linux__)
+                if (_epoll >= 0) ::epoll_ctl(_epoll, EPOLL_CTL_DEL, STDIN_FILENO, nullptr);
+            #endif
+        }
+
+        size_t TEventLoop::run_once(int timeout_ms /* = -1 */)
+        {
+            // raw mode for this call, unless run() or a session keeps it already
+            ::std::optional<TRawModeSession> session;
+            if (not TRawModeSession::active()) session.emplace();
+
+            // keys left in the buffer by GetKey or by an earlier stop()
+            size_t count = drain_input();
+
+            int timeout = wait_timeout(count ? 0 : timeout_ms);
+            if (_stopped) return count;
+
+            int  cancel_fd    = _cancel ? _cancel->native_handle() : -1;
+            bool input_ready  = false;
+            bool cancel_ready = _cancel and _cancel->cancelled();
+
+            if (not cancel_ready)
+            {
+                if (_input_closed and cancel_fd < 0)
+                {
+                    if (timeout < 0) return count; // nothing can happen any more
+                    ::poll(nullptr, 0, timeout);
+                }
+                #if defined(__linux__)
+                    else if (_epoll >= 0)
+                    {
+                        epoll_event events[2];
+                        int ready = ::epoll_wait(_epoll, events, 2, timeout);
+                        for (int i = 0; i < ready; ++i)
+                            (events[i].data.fd == STDIN_FILENO ? input_ready : cancel_ready) = true;
+                    }
+                #endif
+                else
+                {
+                    pollfd fds[2] = {
+                        { _input_closed ? -1 : STDIN_FILENO, POLLIN, 0 },
+                        { cancel_fd                        , POLLIN, 0 },
+                    };
+                    if (::poll(fds, 2, timeout) > 0)
+                    {
+                        input_ready  = fds[0].revents != 0;
+                        cancel_ready = fds[1].revents != 0;
+                    }
+                }
+            }
+
+            if (cancel_ready)
+            {
+                stop();
+                return count;
+            }
+
+            if (input_ready)
+            {
+                ssize_t bytes = input.read();
+                if (bytes > 0) count += drain_input();
+                else if (bytes == 0 or errno != EAGAIN) close_input();
+            }
+
+            // the rest of a sequence didn't come in time (or never will)
+            if (not _stopped and input.decoder.pending() and (_input_closed or TClock::now() >= input.pending_deadline))
+            {
+                dispatch(input.decoder.take());
+                ++count;
+            }
+
+            if (not _stopped) count += fire_timers();
+            return count;
+        }
+
+    #endif
+
+    void TEventLoop::run()
+    {
+        #if defined(_POSIX_VERSION) && !defined(_WIN32)
+            ::std::optional<TRawModeSession> session;
+            if (not TRawModeSession::active()) session.emplace();
+        #endif
+
+        _stopped = false;
+        while (not _stopped)
+        {
+            if (_input_closed and _timers.empty()) break;
+            run_once(-1);
+        }
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- console functions
+
+    [[nodiscard]] TKeyCode GetKey() {
+        TKeyCode res;
+
+        #if defined(_WIN32)
+
+            do {
+                int i = _getch();
+                int c = static_cast<unsigned char>(i);
+                if (c != i)
+                {
+                    FlushConsoleInputBuffer(GetStdHandle(STD_INPUT_HANDLE));
+                    break;
+                }
+                res << c;
+            }
+            while (_kbhit());
+
+        #elif defined(_POSIX_VERSION)
+
+            // raw mode for this call, unless a session keeps it already
+            ::std::optional<TRawModeSession> session;
+            if (not TRawModeSession::active())
+            {
+                session.emplace();
+                if (not session->ok()) return res;
+            }
+
+            auto& decoder = input.decoder;
+            for (;;)
+            {
+                while (not input.empty())
+                {
+                    if (decoder.feed(input.buf[input.pos++])) return decoder.take();
+                }
+
+                // wait for the rest of a started sequence no longer than the timeout
+                int timeout = decoder.pending() ? KEY_SEQUENCE_TIMEOUT_MS : -1;
+                if (not input.fill(timeout)) return decoder.take();
+            }
+
+        #else
+
+            static_assert(false, "unknown platform");
+
+        #endif
+        return res;
+    }
+
+    #if defined(_WIN32)
+
+        ::std::string_view ReadBlock()
+        {
+            thread_local ::std::vector<char> block(64 * 1024);
+
+            DWORD read = 0;
+            if (not ReadFile(GetStdHandle(STD_INPUT_HANDLE), block.data(), static_cast<DWORD>(block.size()), &read, nullptr))
+                return {};
+            return { block.data(), read };
+        }
+
+        TInput GetInput()
+        {
+            if (GetFileType(GetStdHandle(STD_INPUT_HANDLE)) != FILE_TYPE_CHAR) return { {}, ReadBlock() };
+            return { GetKey(), {} };
+        }
+
+    #elif defined(_POSIX_VERSION)
+
+        ::std::string_view ReadBlock()
+        {
+            if (input.empty() and input.read() <= 0) return {};
+
+            auto res = input.rest();
+            input.pos = input.len;
+            return res;
+        }
+
+        TInput GetInput()
+        {
+            if (not ::isatty(STDIN_FILENO)) return { {}, ReadBlock() };
+
+            ::std::optional<TRawModeSession> session;
+            if (not TRawModeSession::active())
+            {
+                session.emplace();
+                if (not session->ok()) return {};
+            }
+
+            // an empty paste is skipped: no key and no text would read as the end of input
+            for (;;)
+            {
+                TKeyCode key = GetKey();
+                if (key != KC_PASTE_BEGIN) return { key, {} };
+
+                // the text is left in place and the buffer only grows when a paste doesn't fit
+                constexpr ::std::string_view end_marker = "\x1B[201~";
+                size_t scanned = 0;
+                for (;;)
+                {
+                    auto text = input.rest();
+                    auto at   = text.find(end_marker, scanned);
+                    if (at != ::std::string_view::npos)
+                    {
+                        input.pos += at + end_marker.size();
+                        if (at == 0) break;
+                        return { {}, text.substr(0, at) };
+                    }
+
+                    scanned = (text.size() < end_marker.size()) ? 0 : text.size() - end_marker.size() + 1;
+                    if (input.read() <= 0)
+                    {
+                        // input ended inside the paste
+                        text = input.rest();
+                        input.pos = input.len;
+                        return { {}, text };
+                    }
+                }
+            }
+        }
+
+    #endif
+
+    namespace {
+
+        // waits for a key accepted by the filter, the deadline or the token
+        template <typename TFilter>
+        TKeyCode wait_key(
+            TFilter                        accept,
+            TEventLoop::TClock::time_point deadline,
+            TCancelToken            const* cancel,
+            TString                 const& msg)
+        {
+            outstream << msg;
+            outstream.flush();
+
+            #if defined(_POSIX_VERSION) && !defined(_WIN32)
+                ::std::optional<TRawModeSession> session;
+                if (not TRawModeSession::active()) session.emplace();
+            #endif
+
+            TKeyCode   res;
+            TEventLoop loop;
+            loop.set_cancel(cancel);
+            loop.on_key([&](TKeyCode code) {
+                if (not accept(code)) return;
+                res = code;
+                loop.stop();
+            });
+            if (deadline != TEventLoop::TClock::time_point::max())
+                loop.add_timer(deadline - TEventLoop::TClock::now(), [&] { loop.stop(); });
+
+            while (not loop.stopped() and not loop.input_closed())
+                loop.run_once();
+            return res;
+        }
+
+        auto deadline_after(TEventLoop::TClock::duration timeout)
+        {
+            auto now = TEventLoop::TClock::now();
+            return (timeout >= TEventLoop::TClock::time_point::max() - now)
+                ? TEventLoop::TClock::time_point::max()
+                : now + timeout;
+        }
+
+    } // namespace
+
+    TKeyCode WaitKeyCodes(
+        ::std::set<TKeyCode> const& codes,
+        TString              const& msg /* = {} */)
+    {
+        return WaitKeyCodesUntil(codes, TEventLoop::TClock::time_point::max(), nullptr, msg);
+    }
+
+    TKeyCode WaitAnyKey(
+        TString const& msg /* = {} */)
+    {
+        return WaitAnyKeyUntil(TEventLoop::TClock::time_point::max(), nullptr, msg);
+    }
+
+    TKeyCode WaitKeyCodesUntil(
+        ::std::set<TKeyCode>        const& codes,
+        TEventLoop::TClock::time_point     deadline,
+        TCancelToken                const* cancel /* = nullptr */,
+        TString                     const& msg    /* = {} */)
+    {
+        auto accept = [&](TKeyCode code) { return codes.find(code) != codes.end(); };
+        return wait_key(accept, deadline, cancel, msg);
+    }
+
+    TKeyCode WaitKeyCodesFor(
+        ::std::set<TKeyCode>        const& codes,
+        TEventLoop::TClock::duration       timeout,
+        TCancelToken                const* cancel /* = nullptr */,
+        TString                     const& msg    /* = {} */)
+    {
+        return WaitKeyCodesUntil(codes, deadline_after(timeout), cancel, msg);
+    }
+
+    TKeyCode WaitAnyKeyUntil(
+        TEventLoop::TClock::time_point     deadline,
+        TCancelToken                const* cancel /* = nullptr */,
+        TString                     const& msg    /* = {} */)
+    {
+        auto accept = [](TKeyCode) { return true; };
+        return wait_key(accept, deadline, cancel, msg);
+    }
+
+    TKeyCode WaitAnyKeyFor(
+        TEventLoop::TClock::duration       timeout,
+        TCancelToken                const* cancel /* = nullptr */,
+        TString                     const& msg    /* = {} */)
     {
-        outstream << msg;
-        outstream.flush();
-        return GetKey();
+        return WaitAnyKeyUntil(deadline_after(timeout), cancel, msg);
     }
 
     TKeyCode WaitReactToKeyCodes(
@@ -5,8 +5,18 @@
 #include <set>
 #include <map>
 #include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <atomic>
+#include <string_view>
+#include <utility>
+#include <span>
+#include <cstdint>
 #include <cctype>
 #include <functional>
+#include <array>
+#include <new>
 #include "sib_type_traits.h"
 #include "sib_string.h"
 
@@ -15,7 +25,8 @@ namespace console {
 
     extern bool const & is_initialized;
 
-    bool Init();
+    // keep_raw_mode - hold a TRawModeSession until the program exits
+    bool Init(bool keep_raw_mode = false);
 
     #ifdef SIB_OUT_STREAM
         inline thread_local auto& outstream = SIB_OUT_STREAM;
@@ -34,93 +45,286 @@ namespace console {
 
     // ----------------------------------------------------------------------------------- tabs
 
-    extern thread_local int TAB_DEF_WIDTH;
-    extern thread_local ::std::vector<int> TAB_WIDTH;
+    // Widths of the first tab stops. The prefix sums for tab_pos are rebuilt on assignment only.
+    class TTabWidths
+    {
+    public:
+        TTabWidths(::std::initializer_list<int> widths) : TTabWidths(::std::vector<int>(widths)) {}
+        TTabWidths(::std::vector<int> widths);
+
+        TTabWidths& operator=(::std::initializer_list<int> widths) { return *this = TTabWidths(widths); }
+
+        size_t size () const noexcept { return _widths.size(); }
+        bool   empty() const noexcept { return _widths.empty(); }
+
+        int operator[](size_t idx) const noexcept { return _widths[idx]; }
+
+        auto begin() const noexcept { return _widths.begin(); }
+        auto end  () const noexcept { return _widths.end  (); }
+
+        // sum of the widths up to idx, inclusive (idx < size())
+        int pos(size_t idx) const noexcept { return _pos[idx]; }
+
+    private:
+        ::std::vector<int> _widths;
+        ::std::vector<int> _pos;
+    };
+
+    extern thread_local int TAB_DEF_WIDTH;     // width of the stops past TAB_WIDTH
+    extern thread_local TTabWidths TAB_WIDTH;
 
     int tab_width(size_t idx);
 
+    // end of the tab stop idx - the sum of the widths up to idx, inclusive
     int tab_pos(size_t idx);
 
 
 
+    // ----------------------------------------------------------------------------------- cursor control
+
+    // stdout is a terminal that takes VT sequences (they get enabled on Windows on the first call)
+    bool IsTerminalOutput();
+
+    // Columns of the terminal, 80 when stdout is not a terminal.
+    int TerminalWidth();
+
+    // Columns and rows of the terminal, {80, 24} when stdout is not a terminal.
+    ::std::pair<int, int> TerminalSize();
+
+    // One write straight to stdout, past outstream (flush it first if the order matters).
+    bool WriteOutput(::std::string_view data);
+
+    // Pieces of one text in as few writes as the system takes (writev), without gathering them first.
+    // `written` - characters that got through, also when the write fails.
+    bool WriteOutput(::std::span<::std::string_view const> pieces);
+    bool WriteOutput(::std::span<::std::string_view const> pieces, size_t& written);
+
+    // Appends the sequence that moves the cursor to column 1 `lines` rows up and erases
+    // everything below it - used to redraw a block of lines in place.
+    void AppendRewind(::std::string& out, int lines);
+
+
+
     // ----------------------------------------------------------------------------------- TKeyCode
 
-    class TKeyCode : private ::std::string
+    // Up to 7 bytes of a key sequence packed into one word, the length is kept in the top byte.
+    // Codes compare and hash as a single integer and are constructible at compile time.
+    class TKeyCode
     {
     private:
-        using base = ::std::string;
         using byte = ::std::byte;
     public:
-        using base::value_type;
-
-        TKeyCode() = default;
-        TKeyCode(byte v0)                            noexcept : base{ char(v0) } {}
-        TKeyCode(byte v0, byte v1)                   noexcept : base{ char(v0), char(v1) } {}
-        TKeyCode(byte v0, byte v1, byte v2)          noexcept : base{ char(v0), char(v1), char(v2) } {}
-        TKeyCode(byte v0, byte v1, byte v2, byte v3) noexcept : base{ char(v0), char(v1), char(v2), char(v3) } {}
-        TKeyCode(std::initializer_list<value_type> ilist) : base(ilist) {}
-
-        using base::size;
-        using base::operator[];
-        using base::insert;
-        using base::begin;
-        using base::end;
-
-        TKeyCode& operator<<(char ch);
-        bool operator==(TKeyCode const& other) const noexcept;
-        bool operator< (TKeyCode const& other) const noexcept;
+        using value_type = char;
+        using data_type  = ::std::uint64_t;
+
+        static constexpr size_t capacity = sizeof(data_type) - 1;
+
+        constexpr TKeyCode() noexcept = default;
+        constexpr TKeyCode(byte v0)                            noexcept { *this << char(v0); }
+        constexpr TKeyCode(byte v0, byte v1)                   noexcept { *this << char(v0) << char(v1); }
+        constexpr TKeyCode(byte v0, byte v1, byte v2)          noexcept { *this << char(v0) << char(v1) << char(v2); }
+        constexpr TKeyCode(byte v0, byte v1, byte v2, byte v3) noexcept { *this << char(v0) << char(v1) << char(v2) << char(v3); }
+        constexpr TKeyCode(std::initializer_list<value_type> ilist) noexcept { for (char ch : ilist) *this << ch; }
+
+        constexpr size_t size () const noexcept { return static_cast<size_t>(_data >> (8 * capacity)); }
+        constexpr bool   empty() const noexcept { return _data == 0; }
+        constexpr data_type data() const noexcept { return _data; }
+
+        static constexpr TKeyCode from_data(data_type data) noexcept { TKeyCode res; res._data = data; return res; }
+
+        constexpr char operator[](size_t idx) const noexcept { return static_cast<char>(_data >> (8 * idx)); }
+
+        // bytes past capacity are dropped (TKeyDecoder skips such sequences instead of taking them)
+        constexpr TKeyCode& operator<<(char ch) noexcept
+        {
+            size_t len = size();
+            if (len == capacity) return *this;
+            _data = (_data & ~(data_type(0xFF) << (8 * capacity)))
+                  | (data_type(static_cast<unsigned char>(ch)) << (8 * len))
+                  | (data_type(len + 1) << (8 * capacity));
+            return *this;
+        }
+
+        constexpr bool operator== (TKeyCode const& other) const noexcept = default;
+        constexpr auto operator<=>(TKeyCode const& other) const noexcept = default;
+
+        // built-in or KeyCodeNames name, empty if the code has none
+        ::std::string_view known_name() const noexcept;
+        // known name or the byte values, e.g. "208, 144"
         ::std::string name() const;
+
+    private:
+        data_type _data = 0;
     };
 
-    inline TKeyCode KC_EMPTY = {};
-
-    inline TKeyCode KC_ENTER            ;
-    inline TKeyCode KC_ESC              ;
-    inline TKeyCode KC_TAB              ;
-    inline TKeyCode KC_SPACE            ;
-    inline TKeyCode KC_BACKSPACE        ;
-
-    inline TKeyCode KC_CTRL_ENTER       ;
-    inline TKeyCode KC_CTRL_TAB         ;
-    inline TKeyCode KC_CTRL_BACKSPACE   ;
-
-    inline TKeyCode KC_F1               ;
-    inline TKeyCode KC_F2               ;
-    inline TKeyCode KC_F3               ;
-    inline TKeyCode KC_F4               ;
-    inline TKeyCode KC_F5               ;
-    inline TKeyCode KC_F6               ;
-    inline TKeyCode KC_F7               ;
-    inline TKeyCode KC_F8               ;
-    inline TKeyCode KC_F9               ;
-    inline TKeyCode KC_F10              ;
-    inline TKeyCode KC_F11              ;
-    inline TKeyCode KC_F12              ;
-
-    inline TKeyCode KC_NUM_INSERT       ;
-    inline TKeyCode KC_NUM_DELETE       ;
-    inline TKeyCode KC_NUM_HOME         ;
-    inline TKeyCode KC_NUM_END          ;
-    inline TKeyCode KC_NUM_PAGE_UP      ;
-    inline TKeyCode KC_NUM_PAGE_DOWN    ;
-
-    inline TKeyCode KC_INSERT           ;
-    inline TKeyCode KC_DELETE           ;
-    inline TKeyCode KC_HOME             ;
-    inline TKeyCode KC_END              ;
-    inline TKeyCode KC_PAGE_UP          ;
-    inline TKeyCode KC_PAGE_DOWN        ;
-
-    inline TKeyCode KC_NUM_LEFT         ;
-    inline TKeyCode KC_NUM_RIGHT        ;
-    inline TKeyCode KC_NUM_UP           ;
-    inline TKeyCode KC_NUM_DOWN         ;
-
-    inline TKeyCode KC_LEFT             ;
-    inline TKeyCode KC_RIGHT            ;
-    inline TKeyCode KC_UP               ;
-    inline TKeyCode KC_DOWN             ;
+    inline constexpr TKeyCode KC_EMPTY = {};
+
+    #if defined(_WIN32)
+
+        inline constexpr TKeyCode KC_ENTER            = { char( 13) };
+        inline constexpr TKeyCode KC_ESC              = { char( 27) };
+        inline constexpr TKeyCode KC_TAB              = { char(  9) };
+        inline constexpr TKeyCode KC_SPACE            = { char( 32) };
+        inline constexpr TKeyCode KC_BACKSPACE        = { char(  8) };
+
+        inline constexpr TKeyCode KC_CTRL_ENTER       = { char( 10) };
+        inline constexpr TKeyCode KC_CTRL_TAB         = { char(  0), char(148) };
+        inline constexpr TKeyCode KC_CTRL_BACKSPACE   = { char(127) };
+
+        inline constexpr TKeyCode KC_F1               = { char(  0), char( 59) };
+        inline constexpr TKeyCode KC_F2               = { char(  0), char( 60) };
+        inline constexpr TKeyCode KC_F3               = { char(  0), char( 61) };
+        inline constexpr TKeyCode KC_F4               = { char(  0), char( 62) };
+        inline constexpr TKeyCode KC_F5               = { char(  0), char( 63) };
+        inline constexpr TKeyCode KC_F6               = { char(  0), char( 64) };
+        inline constexpr TKeyCode KC_F7               = { char(  0), char( 65) };
+        inline constexpr TKeyCode KC_F8               = { char(  0), char( 66) };
+        inline constexpr TKeyCode KC_F9               = { char(  0), char( 67) };
+        inline constexpr TKeyCode KC_F10              = { char(  0), char( 68) };
+        inline constexpr TKeyCode KC_F11              = { char(224), char(133) };
+        inline constexpr TKeyCode KC_F12              = { char(224), char(134) };
+
+        inline constexpr TKeyCode KC_NUM_INSERT       = { char(  0), char( 82) };
+        inline constexpr TKeyCode KC_NUM_DELETE       = { char(  0), char( 83) };
+        inline constexpr TKeyCode KC_NUM_HOME         = { char(  0), char( 71) };
+        inline constexpr TKeyCode KC_NUM_END          = { char(  0), char( 79) };
+        inline constexpr TKeyCode KC_NUM_PAGE_UP      = { char(  0), char( 73) };
+        inline constexpr TKeyCode KC_NUM_PAGE_DOWN    = { char(  0), char( 81) };
+
+        inline constexpr TKeyCode KC_INSERT           = { char(224), char( 82) };
+        inline constexpr TKeyCode KC_DELETE           = { char(224), char( 83) };
+        inline constexpr TKeyCode KC_HOME             = { char(224), char( 71) };
+        inline constexpr TKeyCode KC_END              = { char(224), char( 79) };
+        inline constexpr TKeyCode KC_PAGE_UP          = { char(224), char( 73) };
+        inline constexpr TKeyCode KC_PAGE_DOWN        = { char(224), char( 81) };
+
+        inline constexpr TKeyCode KC_NUM_LEFT         = { char(  0), char( 75) };
+        inline constexpr TKeyCode KC_NUM_RIGHT        = { char(  0), char( 77) };
+        inline constexpr TKeyCode KC_NUM_UP           = { char(  0), char( 72) };
+        inline constexpr TKeyCode KC_NUM_DOWN         = { char(  0), char( 80) };
+
+        inline constexpr TKeyCode KC_LEFT             = { char(224), char( 75) };
+        inline constexpr TKeyCode KC_RIGHT            = { char(224), char( 77) };
+        inline constexpr TKeyCode KC_UP               = { char(224), char( 72) };
+        inline constexpr TKeyCode KC_DOWN             = { char(224), char( 80) };
+
+    #elif defined(__unix__) || defined(__APPLE__)
+
+        inline constexpr TKeyCode KC_ENTER            = { '\n' };
+        inline constexpr TKeyCode KC_ESC              = { '\x1B' };
+        inline constexpr TKeyCode KC_TAB              ;
+        inline constexpr TKeyCode KC_SPACE            ;
+        inline constexpr TKeyCode KC_BACKSPACE        ;
+
+        inline constexpr TKeyCode KC_CTRL_ENTER       ;
+        inline constexpr TKeyCode KC_CTRL_TAB         ;
+        inline constexpr TKeyCode KC_CTRL_BACKSPACE   ;
+
+        inline constexpr TKeyCode KC_F1               = { '\x1B', char(79), char(80) };
+        inline constexpr TKeyCode KC_F2               = { '\x1B', char(79), char(81) };
+        inline constexpr TKeyCode KC_F3               = { '\x1B', char(79), char(82) };
+        inline constexpr TKeyCode KC_F4               = { '\x1B', char(79), char(83) };
+        inline constexpr TKeyCode KC_F5               = { '\x1B', char(91), char(49), char(53), char(126) };
+        inline constexpr TKeyCode KC_F6               = { '\x1B', char(91), char(49), char(55), char(126) };
+        inline constexpr TKeyCode KC_F7               = { '\x1B', char(91), char(49), char(56), char(126) };
+        inline constexpr TKeyCode KC_F8               = { '\x1B', char(91), char(49), char(57), char(126) };
+        inline constexpr TKeyCode KC_F9               = { '\x1B', char(91), char(50), char(48), char(126) };
+        inline constexpr TKeyCode KC_F10              = { '\x1B', char(91), char(50), char(49), char(126) };
+        inline constexpr TKeyCode KC_F11              = { '\x1B', char(91), char(50), char(51), char(126) };
+        inline constexpr TKeyCode KC_F12              = { '\x1B', char(91), char(50), char(52), char(126) };
+
+        inline constexpr TKeyCode KC_NUM_INSERT       = { '\x1B', char(91), char(50), char(126) };
+        inline constexpr TKeyCode KC_NUM_DELETE       = { '\x1B', char(91), char(51), char(126) };
+        inline constexpr TKeyCode KC_NUM_HOME         = { '\x1B', char(91), char(72) };
+        inline constexpr TKeyCode KC_NUM_END          = { '\x1B', char(91), char(76) };
+        inline constexpr TKeyCode KC_NUM_PAGE_UP      = { '\x1B', char(91), char(53), char(126) };
+        inline constexpr TKeyCode KC_NUM_PAGE_DOWN    = { '\x1B', char(91), char(54), char(126) };
+
+        inline constexpr TKeyCode KC_INSERT           = { '\x1B', char(91), char(50), char(126) };
+        inline constexpr TKeyCode KC_DELETE           = { '\x1B', char(91), char(51), char(126) };
+        inline constexpr TKeyCode KC_HOME             = { '\x1B', char(91), char(72) };
+        inline constexpr TKeyCode KC_END              = { '\x1B', char(91), char(70) };
+        inline constexpr TKeyCode KC_PAGE_UP          = { '\x1B', char(91), char(53), char(126) };
+        inline constexpr TKeyCode KC_PAGE_DOWN        = { '\x1B', char(91), char(54), char(126) };
+
+        // the keypad arrows send the same sequences as the main ones
+        inline constexpr TKeyCode KC_NUM_LEFT         = { '\x1B', char(91), char(68) };
+        inline constexpr TKeyCode KC_NUM_RIGHT        = { '\x1B', char(91), char(67) };
+        inline constexpr TKeyCode KC_NUM_UP           = { '\x1B', char(91), char(65) };
+        inline constexpr TKeyCode KC_NUM_DOWN         = { '\x1B', char(91), char(66) };
+
+        inline constexpr TKeyCode KC_LEFT             = { '\x1B', char(91), char(68) };
+        inline constexpr TKeyCode KC_RIGHT            = { '\x1B', char(91), char(67) };
+        inline constexpr TKeyCode KC_UP               = { '\x1B', char(91), char(65) };
+        inline constexpr TKeyCode KC_DOWN             = { '\x1B', char(91), char(66) };
 
+    #else
+
+        #ifndef DISABLE_SIB_WARNINGS
+        #ifndef DISABLE_WARNING_UNKNOWN_KEY_CODES
+
+            #pragma message (                                                                       \
+                "Warning [SIB]: Unknown platform. KC_<> values are not set. "                       \
+                "To suppress this warning, define the DISABLE_WARNING_UNKNOWN_KEY_CODES macros."    \
+            )                                                                                       \
+
+        #endif
+        #endif
+
+        inline constexpr TKeyCode KC_ENTER            ;
+        inline constexpr TKeyCode KC_ESC              ;
+        inline constexpr TKeyCode KC_TAB              ;
+        inline constexpr TKeyCode KC_SPACE            ;
+        inline constexpr TKeyCode KC_BACKSPACE        ;
+
+        inline constexpr TKeyCode KC_CTRL_ENTER       ;
+        inline constexpr TKeyCode KC_CTRL_TAB         ;
+        inline constexpr TKeyCode KC_CTRL_BACKSPACE   ;
+
+        inline constexpr TKeyCode KC_F1               ;
+        inline constexpr TKeyCode KC_F2               ;
+        inline constexpr TKeyCode KC_F3               ;
+        inline constexpr TKeyCode KC_F4               ;
+        inline constexpr TKeyCode KC_F5               ;
+        inline constexpr TKeyCode KC_F6               ;
+        inline constexpr TKeyCode KC_F7               ;
+        inline constexpr TKeyCode KC_F8               ;
+        inline constexpr TKeyCode KC_F9               ;
+        inline constexpr TKeyCode KC_F10              ;
+        inline constexpr TKeyCode KC_F11              ;
+        inline constexpr TKeyCode KC_F12              ;
+
+        inline constexpr TKeyCode KC_NUM_INSERT       ;
+        inline constexpr TKeyCode KC_NUM_DELETE       ;
+        inline constexpr TKeyCode KC_NUM_HOME         ;
+        inline constexpr TKeyCode KC_NUM_END          ;
+        inline constexpr TKeyCode KC_NUM_PAGE_UP      ;
+        inline constexpr TKeyCode KC_NUM_PAGE_DOWN    ;
+
+        inline constexpr TKeyCode KC_INSERT           ;
+        inline constexpr TKeyCode KC_DELETE           ;
+        inline constexpr TKeyCode KC_HOME             ;
+        inline constexpr TKeyCode KC_END              ;
+        inline constexpr TKeyCode KC_PAGE_UP          ;
+        inline constexpr TKeyCode KC_PAGE_DOWN        ;
+
+        inline constexpr TKeyCode KC_NUM_LEFT         ;
+        inline constexpr TKeyCode KC_NUM_RIGHT        ;
+        inline constexpr TKeyCode KC_NUM_UP           ;
+        inline constexpr TKeyCode KC_NUM_DOWN         ;
+
+        inline constexpr TKeyCode KC_LEFT             ;
+        inline constexpr TKeyCode KC_RIGHT            ;
+        inline constexpr TKeyCode KC_UP               ;
+        inline constexpr TKeyCode KC_DOWN             ;
+
+    #endif
+
+    static_assert(KC_EMPTY.size() == 0 && TKeyCode{ 'a', 'b' }.size() == 2 && TKeyCode{ 'a', 'b' }[1] == 'b');
+    static_assert(TKeyCode{ 'a' } != TKeyCode{ 'a', '\0' }, "the length takes part in comparison");
+
+    // names of the platform keys and printable ASCII are built in,
+    // KeyCodeNames holds only user additions and overrides
     using TKeyCodeNames = ::std::map<TKeyCode, ::std::string>;
 
     namespace detail {
@@ -147,6 +351,399 @@ namespace console {
     inline TKeyCodeReactions DefaultKeyCodeReactions {};
     
 
+    // ----------------------------------------------------------------------------------- raw mode session
+
+    /*
+        Keeps the console in raw mode (no echo, no line editing, no signal keys) while alive,
+        so GetKey and the Wait* functions skip switching the mode on every call.
+        Sessions may nest: the mode is set by the first one and restored when the last one ends.
+        The terminal is also restored at exit() and on fatal signals (TERM, HUP, QUIT, ABRT,
+        SEGV, BUS, FPE, ILL), after which the signal gets its previous handling.
+        No-op on Windows (_getch reads unbuffered anyway).
+    */
+    class TRawModeSession
+    {
+    public:
+        TRawModeSession();
+        ~TRawModeSession();
+
+        TRawModeSession(TRawModeSession const &) = delete;
+        TRawModeSession& operator=(TRawModeSession const &) = delete;
+
+        // the session has switched (or joined) raw mode
+        bool ok() const noexcept;
+
+        // some session keeps raw mode now
+        static bool active() noexcept;
+
+    private:
+        bool _ok = false;
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- bracketed paste
+
+    // Sent by the terminal around pasted text while bracketed paste is on.
+    inline constexpr TKeyCode KC_PASTE_BEGIN = { '\x1B', '[', '2', '0', '0', '~' };
+    inline constexpr TKeyCode KC_PASTE_END   = { '\x1B', '[', '2', '0', '1', '~' };
+
+    /*
+        Turns on bracketed paste (ESC [ ? 2004 h) while alive, so GetInput returns a paste as one
+        piece of text instead of a key per character. Sessions may nest like TRawModeSession.
+        Does nothing when stdin or stdout is not a terminal, and on Windows.
+    */
+    class TBracketedPaste
+    {
+    public:
+        TBracketedPaste();
+        ~TBracketedPaste();
+
+        TBracketedPaste(TBracketedPaste const &) = delete;
+        TBracketedPaste& operator=(TBracketedPaste const &) = delete;
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- key decoder
+
+    // Maximal wait (ms) for the rest of an escape or UTF-8 sequence after its first byte.
+    // A lone ESC is returned after this timeout.
+    extern thread_local int KEY_SEQUENCE_TIMEOUT_MS;
+
+    /*
+        Splits a console input byte stream into key codes:
+            ESC [ <params> <final 0x40..0x7E>  - CSI sequence (ESC [ [ x - Linux console F1..F5);
+                                                 longer than TKeyCode::capacity - skipped as a whole
+            ESC O x                            - SS3 sequence
+            ESC x                              - Alt + x
+            UTF-8 lead byte + continuations    - one character
+            any other byte                     - one key
+    */
+    class TKeyDecoder
+    {
+    public:
+        // true - the key is complete and can be taken
+        bool feed(char ch);
+
+        // true - a sequence is started but not complete
+        bool pending() const noexcept;
+
+        // complete key (translated by TTerminalKeys), or the incomplete one on timeout
+        TKeyCode take();
+
+    private:
+        enum class TState { Ground, Esc, Csi, CsiLinux, Ss3, Utf8 };
+
+        TState   _state    = TState::Ground;
+        unsigned _need     = 0;     // UTF-8 continuation bytes left
+        bool     _overlong = false; // the sequence did not fit into _code
+        TKeyCode _code     {};
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- terminal keys
+
+    /*
+        Key sequences of the current terminal mapped to the canonical KC_ codes (xterm sequences),
+        so e.g. ESC O A from a terminal in keypad transmit mode, or ESC [ [ A from the Linux
+        console, still reads as KC_UP / KC_F1.
+        POSIX: built from the compiled terminfo entry of $TERM on first use. After enable_cache()
+        the table is also cached as $XDG_CACHE_HOME/sib/keys-<TERM> (default ~/.cache), which
+        later runs map into memory instead of parsing; the cache is rebuilt when the terminfo
+        file changes. Nothing is written without it.
+        Without a terminfo entry, and on Windows, the table is empty and keys pass as they are.
+        TKeyDecoder::take applies the table to every key; set_current puts another table (e.g.
+        of a terminal under test) in its place.
+    */
+    class TTerminalKeys
+    {
+    public:
+        struct TEntry
+        {
+            TKeyCode::data_type raw;
+            TKeyCode::data_type key;
+        };
+
+        // table for $TERM, loaded once
+        static TTerminalKeys const& current();
+
+        // opt-in cache of current(), takes effect if called before the first key is read
+        static void enable_cache(bool enable = true) noexcept;
+
+        // replaces the table current() returns on every thread (nullptr - the $TERM one again),
+        // returns the table replaced before; `keys` is not copied and must outlive its use
+        static TTerminalKeys const* set_current(TTerminalKeys const* keys) noexcept;
+
+        // table for `term`, cached in `cache_dir` unless it is empty
+        TTerminalKeys(char const* term, ::std::string const& cache_dir);
+        ~TTerminalKeys();
+
+        // entries of a compiled terminfo image (legacy 16-bit and 32-bit number formats), sorted by raw
+        static ::std::vector<TEntry> parse(::std::string_view image);
+
+        TKeyCode translate(TKeyCode code) const noexcept;
+
+        size_t size() const noexcept;
+        bool   from_cache() const noexcept;
+
+        TTerminalKeys(TTerminalKeys const &) = delete;
+        TTerminalKeys& operator=(TTerminalKeys const &) = delete;
+
+    private:
+        TEntry const*         _begin    = nullptr;
+        TEntry const*         _end      = nullptr;
+        ::std::vector<TEntry> _parsed   {};
+        void const*           _map      = nullptr; // the mapped cache file
+        size_t                _map_size = 0;
+        bool                  _cached   = false;
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- cancellation
+
+    /*
+        Wakes a waiting TEventLoop (and the Wait*For / Wait*Until functions) from another thread.
+        Backed by an eventfd on Linux, a non-blocking pipe on other POSIX systems and a manual-reset
+        event on Windows, so the waiting side sleeps in poll/epoll instead of checking a flag.
+        Stays cancelled until reset().
+    */
+    class TCancelToken
+    {
+    public:
+        #if defined(_WIN32)
+            using native_handle_type = void*; // HANDLE
+        #else
+            using native_handle_type = int;
+        #endif
+
+        TCancelToken();
+        ~TCancelToken();
+
+        TCancelToken(TCancelToken const &) = delete;
+        TCancelToken& operator=(TCancelToken const &) = delete;
+
+        // safe to call from any thread
+        void cancel() noexcept;
+        void reset() noexcept;
+        bool cancelled() const noexcept;
+
+        // readable (POSIX) or signaled (Windows) after cancel()
+        native_handle_type native_handle() const noexcept;
+
+    private:
+        ::std::atomic<bool> _cancelled{ false };
+
+        #if defined(_WIN32)
+            void* _event = nullptr;
+        #else
+            int   _read_fd  = -1;
+            int   _write_fd = -1;
+        #endif
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- key bindings
+
+    /*
+        Callable for key bindings, kept inline: no allocation, no indirection but one call.
+        Takes trivially copyable callables up to `capacity` bytes - function pointers and lambdas
+        capturing a few pointers or references. Called with the last key of the chord, or without
+        arguments if the callable does not take a TKeyCode.
+    */
+    class TKeyCallback
+    {
+    public:
+        static constexpr size_t capacity = 3 * sizeof(void*);
+
+        TKeyCallback() noexcept = default;
+
+        template <typename F>
+            requires(::std::is_trivially_copyable_v<::std::decay_t<F>> and sizeof(::std::decay_t<F>) <= capacity
+                and (::std::is_invocable_v<::std::decay_t<F>&, TKeyCode> or ::std::is_invocable_v<::std::decay_t<F>&>))
+        TKeyCallback(F&& func) noexcept
+        {
+            using TFunc = ::std::decay_t<F>;
+            static_assert(alignof(TFunc) <= alignof(void*));
+            ::new (static_cast<void*>(_storage)) TFunc(::std::forward<F>(func));
+            _call = [](void* storage, TKeyCode key) {
+                auto& fn = *::std::launder(static_cast<TFunc*>(storage));
+                if constexpr (::std::is_invocable_v<TFunc&, TKeyCode>) fn(key);
+                else                                                  fn();
+            };
+        }
+
+        void operator()(TKeyCode key) const { _call(_storage, key); }
+
+        explicit operator bool() const noexcept { return _call != nullptr; }
+
+    private:
+        alignas(void*) mutable unsigned char _storage[capacity]{};
+        void (*_call)(void*, TKeyCode) = nullptr;
+    };
+
+    /*
+        Key bindings compiled into a DFA over the bytes of keys.
+        A binding is a chord - one or several keys, e.g. { KC_CTRL_X, KC_CTRL_S } - in a mode.
+        A mode may have a parent: its bindings work in the child too unless the child rebinds
+        the chord (layers like "debug" over "normal"). A binding may switch the mode.
+        compile() (or the first key after a change) merges the layers and builds one transition
+        table: bytes used by the chords get their own classes, the rest share one, plus an end of
+        key class after every key. A key then costs a table step per byte and, at the end of a
+        chord, one call through TKeyCallback.
+        The decoder (TKeyDecoder, TEventLoop) finds where keys end; the bytes of every key and the
+        end of key drive the DFA. A key that breaks a started chord drops it and is looked up from
+        the start of the mode once more.
+    */
+    class TKeyBindings
+    {
+    public:
+        using TModeId = ::std::uint16_t;
+
+        static constexpr TModeId NO_MODE = 0xFFFF; // no parent / stay in the mode
+
+        enum class TResult { Unbound, Pending, Done };
+
+        // mode 0 is created with the given name and is the current one
+        explicit TKeyBindings(::std::string normal_mode = "normal");
+
+        TModeId add_mode(::std::string name, TModeId parent = NO_MODE);
+
+        // the same chord in the same mode is replaced; next_mode - mode after the action
+        void bind(TModeId mode, ::std::initializer_list<TKeyCode> chord, TKeyCallback action, TModeId next_mode = NO_MODE);
+
+        // throws ::std::logic_error if a chord continues a shorter one of the same mode
+        void compile();
+
+        // Done - an action was called, Pending - a chord is started, Unbound - the key is not bound
+        TResult key(TKeyCode code);
+
+        TModeId mode() const noexcept { return _mode; }
+        void    set_mode(TModeId mode);  // drops a started chord
+        void    reset() noexcept;        // drops a started chord
+
+        ::std::string const& mode_name(TModeId mode) const { return _modes.at(mode).name; }
+        size_t               states   () const noexcept    { return _accept.size(); }
+
+    private:
+        struct TMode
+        {
+            ::std::string   name;
+            TModeId         parent;
+            ::std::uint32_t start = 0;
+        };
+
+        struct TBinding
+        {
+            TModeId                 mode;
+            ::std::vector<TKeyCode> chord;
+            TKeyCallback            action;
+            TModeId                 next_mode;
+        };
+
+        TResult step(unsigned symbol, TKeyCode code);
+        TResult run (TKeyCode code);
+
+        ::std::vector<TMode>    _modes    {};
+        ::std::vector<TBinding> _bindings {};
+
+        // compiled: _next[state * _width + class], state 0 - no transition
+        ::std::array<::std::uint16_t, 256> _class  {};
+        unsigned                           _width  = 1;
+        ::std::vector<::std::uint32_t>     _next   {};
+        ::std::vector<::std::int32_t>      _accept {}; // binding per state, -1 - none
+        bool                               _dirty  = true;
+
+        TModeId         _mode  = 0;
+        ::std::uint32_t _state = 0;
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- event loop
+
+    /*
+        Single-threaded loop over console input and timers.
+        Keys are split by TKeyDecoder and go to the key bindings (set_bindings); keys they do not
+        take run their reaction (set_reactions) and then the key handler (on_key). Timers run in the same thread between keys, so an application can redraw
+        or do work while no key is pressed. Key dispatch does not allocate.
+        Input is waited with epoll on Linux, poll on other POSIX systems and WaitForMultipleObjects on
+        the console input handle on Windows. A cancelled token (set_cancel) stops the loop. Raw mode is held while run() or run_once() is inside,
+        unless a TRawModeSession keeps it already.
+    */
+    class TEventLoop
+    {
+    public:
+        using TClock     = ::std::chrono::steady_clock;
+        using TTimerId   = unsigned;
+        using TTimerFunc = ::std::function<void()>;
+        using TKeyFunc   = ::std::function<void(TKeyCode)>;
+
+        TEventLoop();
+        ~TEventLoop();
+
+        TEventLoop(TEventLoop const &) = delete;
+        TEventLoop& operator=(TEventLoop const &) = delete;
+
+        // the table is not copied and must outlive its use by the loop
+        void set_reactions(TKeyCodeReactions const* reactions) noexcept;
+        // keys go to the bindings first, only Unbound ones reach the reactions and on_key
+        void set_bindings(TKeyBindings* bindings) noexcept;
+        void on_key(TKeyFunc func);
+
+        // the token is watched together with the input; nullptr - no token
+        void set_cancel(TCancelToken const* token);
+
+        // first run after delay, then every period (zero period - one-shot timer)
+        TTimerId add_timer(TClock::duration delay, TTimerFunc func, TClock::duration period = {});
+        bool cancel_timer(TTimerId id) noexcept;
+
+        // dispatches events until stop(), or until the input is closed and no timers are left
+        void run();
+
+        // waits no longer than timeout_ms (-1 - until some event) and dispatches the ready events
+        // returns: number of dispatched keys and timers
+        size_t run_once(int timeout_ms = -1);
+
+        void stop() noexcept;
+        bool stopped() const noexcept;
+
+        // end of input was read (redirected stdin)
+        bool input_closed() const noexcept;
+
+    private:
+        struct TTimer
+        {
+            TTimerId           id;
+            TClock::time_point deadline;
+            TClock::duration   period;
+            TTimerFunc         func;
+            bool               active;
+        };
+
+        size_t drain_input();
+        size_t fire_timers();
+        void   dispatch(TKeyCode code);
+        int    wait_timeout(int timeout_ms) const;
+        void   close_input();
+
+        int                                      _epoll            = -1;
+        bool                                     _stopped          = false;
+        bool                                     _input_closed     = false;
+        bool                                     _firing           = false;
+        TTimerId                                 _next_id          = 0;
+        TKeyCodeReactions const*                 _reactions        = nullptr;
+        TKeyBindings*                            _bindings         = nullptr;
+        TCancelToken const*                      _cancel           = nullptr;
+        TKeyFunc                                 _on_key           {};
+        ::std::vector<::std::unique_ptr<TTimer>> _timers           {};
+    };
+
+
+
     // ----------------------------------------------------------------------------------- console functions
 
     /*
@@ -157,12 +754,12 @@ namespace console {
         Returns: TKeyCode
             Sequential set of console key codes (char).
         Notes:
-            - Blocking call: from the first key press until the
-              console buffer is empty.
-            - For POSIX version, key presses are considered
-              simultaneous if they occur within ~0.1 sec interval.
-              Waits for the first press + 0.1 sec and reads the entire
-              console buffer in chunks until empty.
+            - Blocking call: until one complete key is read.
+            - For POSIX version, the input is split into keys by
+              TKeyDecoder as bytes arrive (poll). Only an incomplete
+              sequence (e.g. a lone ESC) waits, and not longer than
+              KEY_SEQUENCE_TIMEOUT_MS. Bytes after the key stay
+              buffered for the next call.
             - Suitable for reading arrow keys, function keys, etc.
             - !!! Intercepts signal keys such as Ctrl+C, Esc, etc.
             - Only captures keys not intercepted by the window
@@ -176,11 +773,12 @@ namespace console {
         Результат: TKeyCode
             Последовательный набор кодов клавиш (char) консоли.
         Примечания:
-            - Вызов блокирующий: от первого нажатия до опустошения
-              буфера консоли.
-            - Для POSIX версии одновременным считается нажатие в
-              интервале ~0,1 сек. Ждёт первого нажатия + 0,1 сек и
-              считывает порциями весь буфер консоли до опустошения.
+            - Вызов блокирующий: до чтения одной целой клавиши.
+            - Для POSIX версии ввод делится на клавиши TKeyDecoder
+              по мере поступления байтов (poll). Ждёт только
+              незавершённая последовательность (например одиночный
+              ESC), и не дольше KEY_SEQUENCE_TIMEOUT_MS. Байты после
+              клавиши остаются в буфере до следующего вызова.
             - Подходит для чтения стрелок, функциональных клавиш и т.п.
             - !!! Перехватывает сигнальные клавиши Ctrl+C, Esc и т.д.
             - Перехватывает только клавиши не перехваченные оконным
@@ -190,6 +788,28 @@ namespace console {
     */
     [[nodiscard]] TKeyCode GetKey();
 
+    // One key, or a whole paste (TBracketedPaste) / block of redirected stdin as text.
+    struct TInput
+    {
+        TKeyCode           key;  // KC_EMPTY for text
+        ::std::string_view text; // valid until the next read of the console input on this thread
+
+        bool is_text() const noexcept { return not text.empty(); }
+        bool is_end () const noexcept { return key.empty() and text.empty(); } // end of input
+    };
+
+    /*
+        GetKey that also takes text in bulk. A paste is returned at once, as a view into the input
+        buffer, without decoding keys or copying. When stdin is not a terminal, whole blocks are
+        returned the same way (see ReadBlock).
+    */
+    [[nodiscard]] TInput GetInput();
+
+    // Next block of stdin as is, no decoding; empty at the end of input.
+    // Valid until the next read of the console input on this thread.
+    [[nodiscard]] ::std::string_view ReadBlock();
+
+    // Blocking wrappers over a TEventLoop. KC_EMPTY is returned when the input ends.
     TKeyCode WaitKeyCodes(
         ::std::set<TKeyCode> const& codes,
         TString              const& msg = {}
@@ -199,6 +819,35 @@ namespace console {
         TString const& msg = {}
     );
 
+    // Same as above, but give up at the deadline or when the token is cancelled and return KC_EMPTY.
+    // Keys pressed before the call are still taken, even with a passed deadline. A key sequence cut
+    // by the deadline or the token stays decoded up to there and is finished by the next read.
+    TKeyCode WaitKeyCodesUntil(
+        ::std::set<TKeyCode>        const& codes,
+        TEventLoop::TClock::time_point     deadline,
+        TCancelToken                const* cancel = nullptr,
+        TString                     const& msg    = {}
+    );
+
+    TKeyCode WaitKeyCodesFor(
+        ::std::set<TKeyCode>        const& codes,
+        TEventLoop::TClock::duration       timeout,
+        TCancelToken                const* cancel = nullptr,
+        TString                     const& msg    = {}
+    );
+
+    TKeyCode WaitAnyKeyUntil(
+        TEventLoop::TClock::time_point     deadline,
+        TCancelToken                const* cancel = nullptr,
+        TString                     const& msg    = {}
+    );
+
+    TKeyCode WaitAnyKeyFor(
+        TEventLoop::TClock::duration       timeout,
+        TCancelToken                const* cancel = nullptr,
+        TString                     const& msg    = {}
+    );
+
     TKeyCode WaitReactToKeyCodes(
         ::std::set<TKeyCode> const& codes,
         TKeyCodeReactions    const& reactions = DefaultKeyCodeReactions,
@@ -212,3 +861,12 @@ namespace console {
 
 } // namespace console
 } // namespace sib
+
+template <>
+struct std::hash<::sib::console::TKeyCode>
+{
+    size_t operator()(::sib::console::TKeyCode const& code) const noexcept
+    {
+        return ::std::hash<::sib::console::TKeyCode::data_type>{}(code.data());
+    }
+};
@@ -0,0 +1,583 @@
+﻿#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include "sib_type_traits.h"
+#include "sib_string.h"
+
+/*
+    format<Ch>(fmt, args...) and format_to(out, fmt, args...) - std::format-like formatting of promiscuous
+    strings. The format string is parsed and checked against the argument types at compile time; a wrong
+    field is a compile error naming detail::format_string_error. The parsed pieces (literal runs, and fields
+    with their argument and spec) are kept in format_string, so a call only walks them and formats each
+    argument through a table of formatters - the format string is not parsed again at run time.
+
+    The format string may be of any character type and the result of any other (as with SIB_MAKE_LITERAL):
+    literal text and string arguments are transcoded (see sib_utf.h), like promiscuous_string does.
+
+        field  ::= '{' [index] [':' spec] '}'           "{{" and "}}" are the braces themselves
+        spec   ::= [[fill] align] [sign] ['#'] ['0'] [width] ['.' precision] [type]
+        align  ::= '<' | '>' | '^'                      text - left, numbers - right by default
+        sign   ::= '+' | '-' | ' '                      of numbers: '+' or ' ' before non-negative ones
+        type   ::= strings   s                          precision cuts the text to so many columns
+                   chars     c d x X b o                d x X b o - the value of the character type, signed or not
+                   bool      s d x X b o                "true" / "false" by default
+                   integers  d x X b o c                '#' adds 0x / 0b / 0 prefix
+                   floats    f F e E g G                shortest round trip by default, precision 6 for f/e/g
+                   pointers  p                          0x...
+                   anything else streamable - no type, goes through promiscuous_stringstream
+
+    Width and precision count terminal columns (see display_width).
+*/
+
+namespace sib {
+
+    // ----------------------------------------------------------------------------------- format spec
+
+    struct TFormatSpec
+    {
+        char32_t fill      = U' ';
+        char     align     = 0;      // '<', '>', '^' or 0 - the default of the argument
+        char     sign      = '-';    // '+', '-' or ' '
+        bool     alternate = false;  // '#'
+        bool     zero      = false;  // '0', zeros between the sign and the digits
+        unsigned width     = 0;
+        int      precision = -1;
+        char     type      = 0;
+    };
+
+    enum class TFormatKind : ::std::uint8_t { Text, Char, Bool, Integer, Floating, Pointer, Other };
+
+    // literal text [begin, end) of the format string or a field
+    struct TFormatSegment
+    {
+        static constexpr ::std::uint32_t TEXT = 0xFFFFFFFF;
+
+        ::std::uint32_t index = TEXT;  // argument of the field
+        ::std::uint32_t begin = 0;
+        ::std::uint32_t end   = 0;
+        TFormatSpec     spec{};
+    };
+
+    namespace detail {
+
+        // not constexpr: reaching it during the compile time check makes the error
+        inline void format_string_error(char const* what) { throw ::std::logic_error(what); }
+
+        template <typename T>
+        consteval TFormatKind format_kind()
+        {
+            using U = ::std::remove_cvref_t<T>;
+            if      constexpr (::std::is_same_v<U, bool>)                                          return TFormatKind::Bool;
+            else if constexpr (is_char_v<U>)                                                       return TFormatKind::Char;
+            else if constexpr (::std::is_integral_v<U>)                                            return TFormatKind::Integer;
+            else if constexpr (::std::is_floating_point_v<U>)                                      return TFormatKind::Floating;
+            else if constexpr (::std::is_array_v<U> and is_char_v<::std::remove_extent_t<U>>)      return TFormatKind::Text;
+            else if constexpr (::std::is_pointer_v<U> and is_char_v<::std::remove_pointer_t<U>>)   return TFormatKind::Text;
+            else if constexpr (LikeString<U>)                                                      return TFormatKind::Text;
+            else if constexpr (::std::is_pointer_v<U> or ::std::is_same_v<U, ::std::nullptr_t>)   return TFormatKind::Pointer;
+            else                                                                                   return TFormatKind::Other;
+        }
+
+        constexpr bool is_integer_presentation(TFormatKind kind, char type) noexcept
+        {
+            switch (kind)
+            {
+                case TFormatKind::Integer: return type != 'c';
+                case TFormatKind::Char:
+                case TFormatKind::Bool:    return type != 0 and type != 'c' and type != 's';
+                default:                   return false;
+            }
+        }
+
+        constexpr void check_format_spec(TFormatKind kind, TFormatSpec const& spec)
+        {
+            constexpr char const* types[] = { "s", "cdxXbo", "sdxXbo", "dxXboc", "fFeEgG", "p", "" };
+
+            if (spec.type != 0)
+            {
+                char const* allowed = types[static_cast<size_t>(kind)];
+                while (*allowed and *allowed != spec.type) ++allowed;
+                if (*allowed == 0) format_string_error("format type does not fit the argument");
+            }
+            if (spec.precision >= 0 and kind != TFormatKind::Text and kind != TFormatKind::Floating)
+                format_string_error("precision is only for strings and floating point arguments");
+            if (spec.sign != '-' and not is_integer_presentation(kind, spec.type) and kind != TFormatKind::Floating)
+                format_string_error("sign is only for numbers");
+            if (spec.alternate and not is_integer_presentation(kind, spec.type))
+                format_string_error("'#' is only for integer presentations");
+            if (spec.zero and not is_integer_presentation(kind, spec.type) and kind != TFormatKind::Floating)
+                format_string_error("'0' is only for numbers");
+        }
+
+        template <Char FCh>
+        constexpr bool is_format_digit(FCh ch) noexcept { return ch >= FCh('0') and ch <= FCh('9'); }
+
+        template <Char FCh>
+        constexpr FCh const* parse_format_number(FCh const* ptr, FCh const* end, unsigned& value)
+        {
+            value = 0;
+            for (; ptr != end and is_format_digit(*ptr); ++ptr)
+            {
+                value = value * 10 + static_cast<unsigned>(*ptr - FCh('0'));
+                if (value > 0xFFFF) format_string_error("number in the format string is too big");
+            }
+            return ptr;
+        }
+
+        template <Char FCh>
+        constexpr FCh const* parse_format_spec(FCh const* ptr, FCh const* end, TFormatSpec& spec)
+        {
+            auto is_align = [](FCh ch) { return ch == FCh('<') or ch == FCh('>') or ch == FCh('^'); };
+
+            if (end - ptr >= 2 and is_align(ptr[1]))
+            {
+                if (ptr[0] == FCh('{') or ptr[0] == FCh('}')) format_string_error("'{' and '}' cannot be a fill");
+                if constexpr (sizeof(FCh) == 1)
+                    if (static_cast<unsigned char>(ptr[0]) >= 0x80) format_string_error("fill must be a single character");
+                if constexpr (sizeof(FCh) == 2)
+                    if (ptr[0] >= FCh(0xD800) and ptr[0] < FCh(0xE000)) format_string_error("fill must be a single character");
+                spec.fill  = static_cast<char32_t>(ptr[0]);
+                spec.align = static_cast<char>(ptr[1]);
+                ptr += 2;
+            }
+            else if (ptr != end and is_align(*ptr))
+            {
+                spec.align = static_cast<char>(*ptr++);
+            }
+
+            if (ptr != end and (*ptr == FCh('+') or *ptr == FCh('-') or *ptr == FCh(' '))) spec.sign = static_cast<char>(*ptr++);
+            if (ptr != end and *ptr == FCh('#')) { spec.alternate = true; ++ptr; }
+            if (ptr != end and *ptr == FCh('0')) { spec.zero      = true; ++ptr; }
+
+            ptr = parse_format_number(ptr, end, spec.width);
+
+            if (ptr != end and *ptr == FCh('.'))
+            {
+                ++ptr;
+                if (ptr == end or not is_format_digit(*ptr)) format_string_error("missing precision after '.'");
+                unsigned precision = 0;
+                ptr = parse_format_number(ptr, end, precision);
+                spec.precision = static_cast<int>(precision);
+            }
+
+            if (ptr != end and ((*ptr >= FCh('a') and *ptr <= FCh('z')) or (*ptr >= FCh('A') and *ptr <= FCh('Z'))))
+                spec.type = static_cast<char>(*ptr++);
+
+            return ptr;
+        }
+
+        // Walks the format string: on_text(begin, end) for literal runs, on_field(index, spec) for fields.
+        template <Char FCh, typename OnText, typename OnField>
+        constexpr void parse_format(FCh const* ptr, FCh const* end, OnText&& on_text, OnField&& on_field)
+        {
+            size_t next_index = 0;
+            bool   automatic  = false;
+            bool   manual     = false;
+
+            FCh const* text = ptr;
+            while (ptr != end)
+            {
+                if (*ptr == FCh('}'))
+                {
+                    if (ptr + 1 == end or ptr[1] != FCh('}')) format_string_error("unmatched '}' in the format string");
+                    on_text(text, ptr + 1);
+                    text = ptr += 2;
+                    continue;
+                }
+                if (*ptr != FCh('{')) { ++ptr; continue; }
+                if (ptr + 1 != end and ptr[1] == FCh('{'))
+                {
+                    on_text(text, ptr + 1);
+                    text = ptr += 2;
+                    continue;
+                }
+
+                on_text(text, ptr);
+                ++ptr;
+
+                size_t index = 0;
+                if (ptr != end and is_format_digit(*ptr))
+                {
+                    unsigned value = 0;
+                    ptr = parse_format_number(ptr, end, value);
+                    index  = value;
+                    manual = true;
+                }
+                else
+                {
+                    index     = next_index++;
+                    automatic = true;
+                }
+                if (automatic and manual) format_string_error("automatic and manual field numbering are mixed");
+
+                TFormatSpec spec;
+                if (ptr != end and *ptr == FCh(':')) ptr = parse_format_spec(ptr + 1, end, spec);
+                if (ptr == end or *ptr != FCh('}')) format_string_error("expected '}' in the format string");
+
+                text = ++ptr;
+                on_field(index, spec);
+            }
+            on_text(text, end);
+        }
+
+    } // namespace detail
+
+
+
+    // ----------------------------------------------------------------------------------- format_string
+
+    /*
+        A format string of any character type checked against Args at compile time. The segments
+        are parsed there too; a string of more than MAX_SEGMENTS of them (many "{{" or repeated
+        fields) keeps only the check and is parsed again by each call.
+    */
+    template <typename... Args>
+    class format_string
+    {
+    public:
+        static constexpr size_t MAX_SEGMENTS = 2 * sizeof...(Args) + 8;
+
+        template <Char FCh>
+        consteval format_string(FCh const* str)
+            : _data(str), _size(::std::char_traits<FCh>::length(str)), _char(char_index<FCh>())
+        {
+            constexpr TFormatKind kinds[] = { detail::format_kind<Args>()..., TFormatKind::Other };
+
+            auto add = [&](TFormatSegment const& segment)
+            {
+                if (_count < MAX_SEGMENTS) _segments[_count] = segment;
+                ++_count;
+            };
+            detail::parse_format(str, str + _size,
+                [&](FCh const* first, FCh const* last)
+                {
+                    if (first != last) add({ TFormatSegment::TEXT, ::std::uint32_t(first - str), ::std::uint32_t(last - str), {} });
+                },
+                [&](size_t index, TFormatSpec const& spec)
+                {
+                    if (index >= sizeof...(Args)) detail::format_string_error("format field refers to a missing argument");
+                    detail::check_format_spec(kinds[index], spec);
+                    add({ ::std::uint32_t(index), 0, 0, spec });
+                });
+        }
+
+        size_t size() const noexcept { return _size; }
+
+        // false - too many segments to keep, the string has to be parsed
+        bool resolved() const noexcept { return _count <= MAX_SEGMENTS; }
+
+        ::std::span<TFormatSegment const> segments() const noexcept { return { _segments, resolved() ? _count : 0 }; }
+
+        // fn(FCh const* begin, FCh const* end) with the original character type
+        template <typename Fn>
+        void visit(Fn&& fn) const
+        {
+            switch (_char)
+            {
+                case 0: fn(static_cast<char     const*>(_data), static_cast<char     const*>(_data) + _size); break;
+                case 1: fn(static_cast<wchar_t  const*>(_data), static_cast<wchar_t  const*>(_data) + _size); break;
+                case 2: fn(static_cast<char8_t  const*>(_data), static_cast<char8_t  const*>(_data) + _size); break;
+                case 3: fn(static_cast<char16_t const*>(_data), static_cast<char16_t const*>(_data) + _size); break;
+                case 4: fn(static_cast<char32_t const*>(_data), static_cast<char32_t const*>(_data) + _size); break;
+            }
+        }
+
+    private:
+
+        void const*    _data;
+        size_t         _size;
+        ::std::uint8_t _char;
+        size_t         _count = 0;
+        TFormatSegment _segments[MAX_SEGMENTS]{};
+
+        template <Char FCh>
+        static consteval ::std::uint8_t char_index()
+        {
+            using C = ::std::remove_cv_t<FCh>;
+            if      constexpr (::std::is_same_v<C, char    >) return 0;
+            else if constexpr (::std::is_same_v<C, wchar_t >) return 1;
+            else if constexpr (::std::is_same_v<C, char8_t >) return 2;
+            else if constexpr (::std::is_same_v<C, char16_t>) return 3;
+            else if constexpr (::std::is_same_v<C, char32_t>) return 4;
+            else static_assert(::std::is_same_v<C, char>, "format strings are char, wchar_t, char8_t, char16_t or char32_t");
+        }
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- formatters
+
+    namespace detail {
+
+        template <BasicString Str>
+        void append_ascii(Str& out, ::std::string_view text) { append_transcoded(out, text); }
+
+        template <BasicString Str, typename Body>
+        void append_padded(Str& out, TFormatSpec const& spec, char align, size_t width, Body&& body)
+        {
+            using Ch = typename Str::value_type;
+            size_t fill = (spec.width > width) ? spec.width - width : 0;
+            if (spec.align) align = spec.align;
+            size_t left = (align == '>') ? fill : (align == '^') ? fill / 2 : 0;
+            Ch     unit[4];
+            size_t len = encode_utf(spec.fill, unit);       // the fill is a code point of the format string
+            if (len == 1)
+            {
+                out.append(left, unit[0]);
+                body();
+                out.append(fill - left, unit[0]);
+                return;
+            }
+            for (size_t i = 0; i < left; ++i) out.append(unit, len);
+            body();
+            for (size_t i = left; i < fill; ++i) out.append(unit, len);
+        }
+
+        template <BasicString Str>
+        void append_number(Str& out, TFormatSpec const& spec, ::std::string_view sign, ::std::string_view digits)
+        {
+            using Ch = typename Str::value_type;
+            size_t width = sign.size() + digits.size();
+            if (spec.zero and not spec.align)
+            {
+                append_ascii(out, sign);
+                out.append((spec.width > width) ? spec.width - width : 0, Ch('0'));
+                append_ascii(out, digits);
+                return;
+            }
+            append_padded(out, spec, '>', width, [&] { append_ascii(out, sign); append_ascii(out, digits); });
+        }
+
+        // the longest prefix that fits into `cols` columns
+        template <Char Src>
+        ::std::basic_string_view<Src> truncate_columns(::std::basic_string_view<Src> text, size_t cols) noexcept
+        {
+            size_t used = 0;
+            size_t pos  = 0;
+            while (pos < text.size())
+            {
+                size_t len = 1;
+                if constexpr (sizeof(Src) == 1)
+                    while (pos + len < text.size() and (static_cast<unsigned char>(text[pos + len]) & 0xC0) == 0x80) ++len;
+                if constexpr (sizeof(Src) == 2)
+                    if (text[pos] >= Src(0xD800) and text[pos] < Src(0xDC00) and pos + 1 < text.size()) len = 2;
+                size_t width = display_width(text.substr(pos, len));
+                if (used + width > cols) break;
+                used += width;
+                pos  += len;
+            }
+            return text.substr(0, pos);
+        }
+
+        template <BasicString Str, Char Src>
+        void format_text(Str& out, TFormatSpec const& spec, ::std::basic_string_view<Src> text)
+        {
+            if (spec.precision >= 0) text = truncate_columns(text, static_cast<size_t>(spec.precision));
+            size_t width = (spec.width == 0) ? 0 : display_width(text);
+            append_padded(out, spec, '<', width, [&] { append_transcoded(out, text); });
+        }
+
+        template <BasicString Str, typename T>
+        void format_integer(Str& out, TFormatSpec const& spec, T value)
+        {
+            using U = ::std::make_unsigned_t<T>;
+
+            char buf[8 * sizeof(T) + 4];   // binary digits, sign and prefix
+            char* sign_end = buf;
+            U magnitude = static_cast<U>(value);
+            bool negative = false;
+            if constexpr (::std::is_signed_v<T>)
+                if (value < 0) { negative = true; magnitude = U(0) - magnitude; }
+            if (negative or spec.sign != '-') *sign_end++ = negative ? '-' : spec.sign;
+
+            int base = 10;
+            switch (spec.type)
+            {
+                case 'x': case 'X': base = 16; break;
+                case 'b':           base = 2;  break;
+                case 'o':           base = 8;  break;
+            }
+            if (spec.alternate)
+            {
+                if (base == 16)                        { *sign_end++ = '0'; *sign_end++ = spec.type; }
+                else if (base == 2)                    { *sign_end++ = '0'; *sign_end++ = 'b'; }
+                else if (base == 8 and magnitude != 0) { *sign_end++ = '0'; }
+            }
+
+            char* end = ::std::to_chars(sign_end, buf + sizeof(buf), magnitude, base).ptr;
+            if (spec.type == 'X')
+                for (char* ptr = sign_end; ptr != end; ++ptr)
+                    if (*ptr >= 'a' and *ptr <= 'f') *ptr = static_cast<char>(*ptr - 'a' + 'A');
+
+            append_number(out, spec, { buf, sign_end }, { sign_end, end });
+        }
+
+        template <BasicString Str, typename T>
+        void format_floating(Str& out, TFormatSpec const& spec, T value)
+        {
+            int  precision = spec.precision;
+            char type      = spec.type;
+            bool upper     = type >= 'A' and type <= 'Z';
+            if (upper) type = static_cast<char>(type - 'A' + 'a');
+
+            auto convert = [&](char* first, char* last)
+            {
+                switch (type)
+                {
+                    case 'f': return ::std::to_chars(first, last, value, ::std::chars_format::fixed     , precision < 0 ? 6 : precision);
+                    case 'e': return ::std::to_chars(first, last, value, ::std::chars_format::scientific, precision < 0 ? 6 : precision);
+                    case 'g': return ::std::to_chars(first, last, value, ::std::chars_format::general   , precision < 0 ? 6 : precision);
+                }
+                return (precision < 0)
+                    ? ::std::to_chars(first, last, value)
+                    : ::std::to_chars(first, last, value, ::std::chars_format::general, precision);
+            };
+
+            char small[128];
+            ::std::string large;
+            char* first  = small;
+            auto  result = convert(small, small + sizeof(small));
+            if (result.ec != ::std::errc{})
+            {
+                // fixed notation of huge values or a long precision
+                large.resize(static_cast<size_t>(precision < 0 ? 0 : precision) + 5000);
+                first  = large.data();
+                result = convert(first, first + large.size());
+            }
+            if (upper)
+                for (char* ptr = first; ptr != result.ptr; ++ptr)
+                    if (*ptr >= 'a' and *ptr <= 'z') *ptr = static_cast<char>(*ptr - 'a' + 'A');
+
+            ::std::string_view text(first, static_cast<size_t>(result.ptr - first));
+            ::std::string_view sign = (text.front() == '-') ? "-" : (spec.sign == '+') ? "+" : (spec.sign == ' ') ? " " : "";
+            if (text.front() == '-') text.remove_prefix(1);
+            if (not ::std::isfinite(value))
+            {
+                append_padded(out, spec, '>', sign.size() + text.size(), [&] { append_ascii(out, sign); append_ascii(out, text); });
+                return;
+            }
+            append_number(out, spec, sign, text);
+        }
+
+        template <BasicString Str, typename T>
+        void format_arg(Str& out, TFormatSpec const& spec, T const& arg)
+        {
+            using Ch = typename Str::value_type;
+            constexpr TFormatKind kind = format_kind<T>();
+
+            if constexpr (kind == TFormatKind::Text)
+            {
+                with_chars(arg, [&](auto text) { format_text(out, spec, text); });
+            }
+            else if constexpr (kind == TFormatKind::Char)
+            {
+                // as std::format: the value of the type, so a signed char stays negative
+                using TValue = ::std::conditional_t<::std::is_signed_v<T>, long long, unsigned long long>;
+                if (is_integer_presentation(kind, spec.type))
+                    format_integer(out, spec, static_cast<TValue>(arg));
+                else
+                    format_text(out, spec, ::std::basic_string_view<T>(&arg, 1));
+            }
+            else if constexpr (kind == TFormatKind::Bool)
+            {
+                if (is_integer_presentation(kind, spec.type))
+                    format_integer(out, spec, static_cast<unsigned>(arg));
+                else
+                    format_text(out, spec, arg ? ::std::string_view("true") : ::std::string_view("false"));
+            }
+            else if constexpr (kind == TFormatKind::Integer)
+            {
+                if (spec.type == 'c')
+                {
+                    Ch ch = static_cast<Ch>(arg);
+                    format_text(out, spec, ::std::basic_string_view<Ch>(&ch, 1));
+                }
+                else
+                    format_integer(out, spec, arg);
+            }
+            else if constexpr (kind == TFormatKind::Floating)
+            {
+                format_floating(out, spec, arg);
+            }
+            else if constexpr (kind == TFormatKind::Pointer)
+            {
+                TFormatSpec hex = spec;
+                hex.type      = 'x';
+                hex.alternate = true;
+                if constexpr (::std::is_same_v<T, ::std::nullptr_t>)
+                    format_integer(out, hex, ::std::uintptr_t(0));
+                else
+                    format_integer(out, hex, reinterpret_cast<::std::uintptr_t>(arg));
+            }
+            else
+            {
+                using TBuf = promiscuous_stringstream<Ch, typename Str::traits_type, typename Str::allocator_type>;
+                static_assert(requires(TBuf& buf) { buf << arg; }, "the format argument is not streamable");
+                TBuf buf;
+                buf << arg;
+                format_text(out, spec, ::std::basic_string_view<Ch>(buf.view().data(), buf.view().size()));
+            }
+        }
+
+        // format_arg behind a common signature, one per output and argument type
+        template <BasicString Str, typename T>
+        void format_erased(Str& out, TFormatSpec const& spec, void const* arg)
+        {
+            format_arg(out, spec, *static_cast<T const*>(arg));
+        }
+
+    } // namespace detail
+
+
+
+    // ----------------------------------------------------------------------------------- format
+
+    // Appends the formatted text to `out`.
+    template <BasicString Str, typename... Args>
+    Str& format_to(Str& out, format_string<::std::type_identity_t<Args>...> fmt, Args const&... args)
+    {
+        using TFormatter = void (*)(Str&, TFormatSpec const&, void const*);
+        static constexpr TFormatter formatters[] = { &detail::format_erased<Str, Args>..., nullptr };
+        void const* const           values    [] = { static_cast<void const*>(::std::addressof(args))..., nullptr };
+
+        fmt.visit([&]<typename FCh>(FCh const* begin, FCh const* end)
+        {
+            auto text = [&](FCh const* first, FCh const* last)
+            {
+                append_transcoded(out, ::std::basic_string_view<FCh>(first, static_cast<size_t>(last - first)));
+            };
+            if (fmt.resolved())
+            {
+                for (auto const& segment : fmt.segments())
+                {
+                    if (segment.index == TFormatSegment::TEXT) text(begin + segment.begin, begin + segment.end);
+                    else formatters[segment.index](out, segment.spec, values[segment.index]);
+                }
+                return;
+            }
+            detail::parse_format(begin, end, text,
+                [&](size_t index, TFormatSpec const& spec) { formatters[index](out, spec, values[index]); });
+        });
+        return out;
+    }
+
+    template <Char Ch = char, typename... Args>
+    promiscuous_string<Ch> format(format_string<::std::type_identity_t<Args>...> fmt, Args const&... args)
+    {
+        promiscuous_string<Ch> out;
+        out.reserve(fmt.size() + 16 * sizeof...(Args));
+        format_to(out, fmt, args...);
+        return out;
+    }
+
+} // namespace sib
@@ -0,0 +1,217 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "sib_string.h"
+
+/*
+    promiscuous_rope - text made of chunks, each chunk an immutable slice of storage it shares or borrows:
+      - append(rope) and copies of a rope share the chunks, the characters are not copied;
+      - append(string&&) adopts the string as a chunk of its own;
+      - append_shared(owner, text) keeps `owner` alive while the slice is in use;
+      - append_borrowed(text) only points at the text - it has to outlive the rope;
+      - append(text) and push_back copy small pieces into blocks of the rope (a block is never
+        reallocated, so the slices already handed out stay valid).
+    The chunks go to the output as they are (see chunks and operator<<), str() flattens them into one string.
+*/
+
+namespace sib {
+
+    // ----------------------------------------------------------------------------------- promiscuous_rope
+
+    template <Char Ch, typename Tr = ::std::char_traits<Ch>, typename Al = ::std::allocator<Ch>>
+    class promiscuous_rope
+    {
+    public:
+        using value_type  = Ch;
+        using traits_type = Tr;
+        using view_type   = ::std::basic_string_view<Ch, Tr>;
+        using string_type = promiscuous_string<Ch, Tr, Al>;
+
+        struct chunk
+        {
+            ::std::shared_ptr<void const> owner; // empty for borrowed text
+            view_type                     text;
+        };
+
+        // characters of a block for the copied pieces
+        static constexpr size_t BLOCK_SIZE = 4096;
+
+        promiscuous_rope() = default;
+        explicit promiscuous_rope(view_type text) { append(text); }
+        explicit promiscuous_rope(Ch const* text) { append(text); }
+        explicit promiscuous_rope(string_type&& text) { append(::std::move(text)); }
+
+        // the copy shares the chunks, but not the free room of the last block
+        promiscuous_rope(promiscuous_rope const& other) : _chunks(other._chunks), _size(other._size) {}
+        promiscuous_rope(promiscuous_rope&& other) noexcept
+            : _chunks(::std::move(other._chunks))
+            , _size  (::std::exchange(other._size, 0))
+            , _block (::std::move(other._block))
+            , _next  (::std::exchange(other._next, nullptr))
+            , _free  (::std::exchange(other._free, 0))
+        {}
+
+        promiscuous_rope& operator=(promiscuous_rope const& other)
+        {
+            if (this != &other) { _chunks = other._chunks; _size = other._size; _block.reset(); _free = 0; }
+            return *this;
+        }
+        promiscuous_rope& operator=(promiscuous_rope&& other) noexcept
+        {
+            if (this != &other)
+            {
+                _chunks = ::std::move(other._chunks);
+                _size   = ::std::exchange(other._size, 0);
+                _block  = ::std::move(other._block);
+                _next   = ::std::exchange(other._next, nullptr);
+                _free   = ::std::exchange(other._free, 0);
+            }
+            return *this;
+        }
+
+        size_t size () const noexcept { return _size; }
+        bool   empty() const noexcept { return _size == 0; }
+
+        ::std::span<chunk const> chunks() const noexcept { return _chunks; }
+
+        void clear() noexcept { _chunks.clear(); _size = 0; } // the free room of the block stays
+
+        void reserve_chunks(size_t count) { _chunks.reserve(count); }
+
+        promiscuous_rope& append(view_type text)
+        {
+            if (text.empty()) return *this;
+            Ch* dst = room(text.size());
+            Tr::copy(dst, text.data(), text.size());
+            return add_copied(dst, text.size());
+        }
+
+        promiscuous_rope& append(Ch const* text) { return append(view_type(text)); }
+
+        promiscuous_rope& append(size_t count, Ch ch)
+        {
+            if (count == 0) return *this;
+            Ch* dst = room(count);
+            Tr::assign(dst, count, ch);
+            return add_copied(dst, count);
+        }
+
+        promiscuous_rope& append(string_type&& text)
+        {
+            if (text.empty()) return *this;
+            auto owner = ::std::make_shared<string_type const>(::std::move(text));
+            view_type view(*owner);
+            return add(chunk{ ::std::move(owner), view });
+        }
+
+        promiscuous_rope& append(promiscuous_rope const& other)
+        {
+            _chunks.insert(_chunks.end(), other._chunks.begin(), other._chunks.end());
+            _size += other._size;
+            return *this;
+        }
+
+        template <typename T>
+        promiscuous_rope& append_shared(::std::shared_ptr<T> owner, view_type text)
+        {
+            if (text.empty()) return *this;
+            return add(chunk{ ::std::shared_ptr<void const>(::std::move(owner)), text });
+        }
+
+        promiscuous_rope& append_borrowed(view_type text)
+        {
+            if (text.empty()) return *this;
+            return add(chunk{ {}, text });
+        }
+
+        void push_back(Ch ch) { append(1, ch); }
+
+        promiscuous_rope& operator+=(view_type text)                { return append(text); }
+        promiscuous_rope& operator+=(Ch const* text)                { return append(text); }
+        promiscuous_rope& operator+=(Ch ch)                         { push_back(ch); return *this; }
+        promiscuous_rope& operator+=(string_type&& text)            { return append(::std::move(text)); }
+        promiscuous_rope& operator+=(promiscuous_rope const& other) { return append(other); }
+
+        // slices of the same chunks
+        promiscuous_rope substr(size_t pos, size_t count = view_type::npos) const
+        {
+            promiscuous_rope res;
+            count = ::std::min(count, (pos < _size) ? _size - pos : 0);
+            for (auto const& ch : _chunks)
+            {
+                if (count == 0) break;
+                if (pos >= ch.text.size()) { pos -= ch.text.size(); continue; }
+                auto part = ch.text.substr(pos, count);
+                res.add(chunk{ ch.owner, part });
+                count -= part.size();
+                pos    = 0;
+            }
+            return res;
+        }
+
+        string_type str() const
+        {
+            string_type res;
+            res.reserve(_size);
+            for (auto const& ch : _chunks) res.append(ch.text);
+            return res;
+        }
+
+        friend ::std::basic_ostream<Ch, Tr>& operator<<(::std::basic_ostream<Ch, Tr>& os, promiscuous_rope const& rope)
+        {
+            for (auto const& ch : rope._chunks) os.write(ch.text.data(), static_cast<::std::streamsize>(ch.text.size()));
+            return os;
+        }
+
+    private:
+        ::std::vector<chunk>         _chunks{};
+        size_t                       _size = 0;
+        ::std::shared_ptr<Ch const>  _block{};   // the block the copies go to
+        Ch*                          _next = nullptr;
+        size_t                       _free = 0;
+
+        promiscuous_rope& add(chunk&& ch)
+        {
+            _size += ch.text.size();
+            _chunks.push_back(::std::move(ch));
+            return *this;
+        }
+
+        // room for `count` copied characters, a new block when the current one is full
+        Ch* room(size_t count)
+        {
+            if (count <= _free) return _next;
+            size_t size = ::std::max(count, BLOCK_SIZE);
+            auto   data = ::std::make_shared_for_overwrite<Ch[]>(size);
+            _next  = data.get();
+            _free  = size;
+            _block = ::std::shared_ptr<Ch const>(::std::move(data), _next);
+            return _next;
+        }
+
+        // the copy continues the last chunk when it follows it in the block
+        promiscuous_rope& add_copied(Ch* dst, size_t count)
+        {
+            _next += count;
+            _free -= count;
+            if (not _chunks.empty())
+            {
+                auto& last = _chunks.back();
+                if (last.owner == _block and last.text.data() + last.text.size() == dst)
+                {
+                    last.text = view_type(last.text.data(), last.text.size() + count);
+                    _size    += count;
+                    return *this;
+                }
+            }
+            return add(chunk{ _block, view_type(dst, count) });
+        }
+    };
+
+} // namespace sib
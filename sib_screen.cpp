@@ -0,0 +1,299 @@
+﻿#include "sib_screen.h"
+#include "sib_console.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+
+namespace sib {
+namespace console {
+
+    // ----------------------------------------------------------------------------------- helpers
+
+    namespace {
+
+        constexpr char32_t REPLACEMENT = U'�';
+
+        // next code point of UTF-8 text, REPLACEMENT for invalid bytes
+        char32_t decode_utf8(::std::string_view text, size_t& pos) noexcept
+        {
+            auto lead = static_cast<unsigned char>(text[pos++]);
+            if (lead < 0x80) return lead;
+
+            unsigned need = (lead >= 0xF0 and lead <= 0xF4) ? 3 : (lead >= 0xE0) ? 2 : (lead >= 0xC2) ? 1 : 0;
+            if (need == 0 or lead > 0xF4) return REPLACEMENT;
+
+            char32_t cp = lead & (0x3F >> need);
+            for (unsigned i = 0; i < need; ++i)
+            {
+                if (pos >= text.size()) return REPLACEMENT;
+                auto next = static_cast<unsigned char>(text[pos]);
+                if ((next & 0xC0) != 0x80) return REPLACEMENT;
+                cp = (cp << 6) | (next & 0x3F);
+                ++pos;
+            }
+            return cp;
+        }
+
+        void encode_utf8(::std::string& out, char32_t cp)
+        {
+            if (cp < 0x80)
+            {
+                out += static_cast<char>(cp);
+            }
+            else if (cp < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+
+        void append_num(::std::string& out, int value)
+        {
+            char buf[12];
+            auto res = ::std::to_chars(buf, buf + sizeof(buf), value);
+            out.append(buf, res.ptr);
+        }
+
+        void append_color(::std::string& out, ::std::uint16_t color, int base, int bright_base, char const* ext)
+        {
+            if (color >= COLOR_DEFAULT) return;
+            out += ';';
+            if      (color < 8 ) append_num(out, base + color);
+            else if (color < 16) append_num(out, bright_base + color - 8);
+            else { out += ext; append_num(out, color); }
+        }
+
+    } // namespace
+
+
+
+    // ----------------------------------------------------------------------------------- TScreen
+
+    TScreen::TScreen(int width, int height)
+    {
+        resize(width, height);
+    }
+
+    TScreen::~TScreen()
+    {
+        if (_presented and not _shown_visible)
+        {
+            outstream.flush();
+            WriteOutput("\x1B[?25h");
+        }
+    }
+
+    void TScreen::resize(int width, int height)
+    {
+        _width  = ::std::max(width , 0);
+        _height = ::std::max(height, 0);
+        _front.assign(size_t(_width) * size_t(_height), TCell{});
+        _back .assign(size_t(_width) * size_t(_height), TCell{});
+        _full = true;
+    }
+
+    void TScreen::invalidate() noexcept
+    {
+        _full = true;
+    }
+
+    void TScreen::clear(TAttr attr /* = {} */)
+    {
+        ::std::fill(_back.begin(), _back.end(), TCell{ U' ', attr });
+    }
+
+    TCell* TScreen::at(int x, int y) noexcept
+    {
+        if (x < 0 or y < 0 or x >= _width or y >= _height) return nullptr;
+        return &_back[size_t(y) * size_t(_width) + size_t(x)];
+    }
+
+    TCell const* TScreen::at(int x, int y) const noexcept
+    {
+        return const_cast<TScreen*>(this)->at(x, y);
+    }
+
+    int TScreen::print(int x, int y, ::std::string_view text, TAttr attr /* = {} */)
+    {
+        size_t pos = 0;
+        while (pos < text.size() and x < _width)
+        {
+            char32_t cp = decode_utf8(text, pos);
+            if (cp < 0x20 or cp == 0x7F) cp = REPLACEMENT; // control codes would move the real cursor
+            if (auto cell = at(x, y)) *cell = TCell{ cp, attr };
+            ++x;
+        }
+        return x;
+    }
+
+    void TScreen::fill(int x, int y, int width, int height, char32_t ch, TAttr attr /* = {} */)
+    {
+        for (int row = ::std::max(y, 0); row < ::std::min(y + height, _height); ++row)
+            for (int col = ::std::max(x, 0); col < ::std::min(x + width, _width); ++col)
+                *at(col, row) = TCell{ ch, attr };
+    }
+
+    void TScreen::cursor(int x, int y, bool visible /* = true */) noexcept
+    {
+        _cursor_x       = x;
+        _cursor_y       = y;
+        _cursor_visible = visible;
+    }
+
+    void TScreen::move_to(int x, int y)
+    {
+        if (x == _cur_x and y == _cur_y) return;
+
+        size_t const start = _frame.size();
+        _frame += "\x1B[";
+        append_num(_frame, y + 1);
+        _frame += ';';
+        append_num(_frame, x + 1);
+        _frame += 'H';
+
+        // from a known position the relative moves go after the CUP and replace it when shorter
+        if (_cur_x >= 0 and _cur_y >= 0)
+        {
+            size_t const absolute = _frame.size() - start;
+
+            auto step = [&](int count, char up, char down) {
+                if (count == 0) return;
+                _frame += "\x1B[";
+                if (count != 1 and count != -1) append_num(_frame, ::std::abs(count));
+                _frame += (count < 0) ? up : down;
+            };
+            step(y - _cur_y, 'A', 'B');
+            if (x == 0 and _cur_x != 0) _frame += '\r';
+            else                        step(x - _cur_x, 'D', 'C');
+
+            if (_frame.size() - start - absolute < absolute) _frame.erase(start, absolute);
+            else                                             _frame.resize(start + absolute);
+        }
+        _cur_x = x;
+        _cur_y = y;
+    }
+
+    void TScreen::set_attr(TAttr attr)
+    {
+        if (_attr_known and attr == _cur_attr) return;
+
+        _frame += "\x1B[0";
+        if (attr.style & STYLE_BOLD     ) _frame += ";1";
+        if (attr.style & STYLE_DIM      ) _frame += ";2";
+        if (attr.style & STYLE_ITALIC   ) _frame += ";3";
+        if (attr.style & STYLE_UNDERLINE) _frame += ";4";
+        if (attr.style & STYLE_REVERSE  ) _frame += ";7";
+        append_color(_frame, attr.fg, 30,  90, "38;5;");
+        append_color(_frame, attr.bg, 40, 100, "48;5;");
+        _frame += 'm';
+
+        _cur_attr   = attr;
+        _attr_known = true;
+    }
+
+    void TScreen::put(TCell const& cell)
+    {
+        set_attr(cell.attr);
+        encode_utf8(_frame, cell.ch);
+        // past the last column the terminal waits to wrap, so the position is unknown
+        if (++_cur_x >= _width) _cur_x = -1;
+    }
+
+    ::std::string_view TScreen::render()
+    {
+        // the cursor is hidden while the frame is drawn
+        _frame.assign("\x1B[?25l");
+        size_t const header = _frame.size();
+
+        _cur_x      = -1;
+        _cur_y      = -1;
+        _cur_attr   = {};
+        _attr_known = true; // every frame ends with default attributes
+
+        if (_full)
+        {
+            _frame += "\x1B[0m\x1B[H\x1B[2J";
+            ::std::fill(_front.begin(), _front.end(), TCell{});
+            _cur_x = 0;
+            _cur_y = 0;
+            _full  = false;
+        }
+
+        // rewriting a few unchanged cells is shorter than a cursor move
+        constexpr int MAX_GAP = 3;
+
+        for (int y = 0; y < _height; ++y)
+        {
+            TCell* back  = &_back [size_t(y) * size_t(_width)];
+            TCell* front = &_front[size_t(y) * size_t(_width)];
+
+            for (int x = 0; x < _width; ++x)
+            {
+                if (back[x] == front[x]) continue;
+
+                if (_cur_y == y and _cur_x >= 0 and x > _cur_x and x - _cur_x <= MAX_GAP)
+                {
+                    bool same_attr = true;
+                    for (int gap = _cur_x; gap < x; ++gap)
+                        same_attr = same_attr and back[gap].attr == _cur_attr and back[gap].ch < 0x80;
+                    if (same_attr)
+                        for (int gap = _cur_x; gap < x; ++gap) put(back[gap]);
+                }
+
+                move_to(x, y);
+                put(back[x]);
+                front[x] = back[x];
+            }
+        }
+
+        bool const drawn = _frame.size() > header;
+        bool const same_cursor = (_cursor_visible == _shown_visible)
+                             and (not _cursor_visible or (_cursor_x == _shown_x and _cursor_y == _shown_y));
+        if (not drawn and same_cursor)
+        {
+            _frame.clear();
+            return {};
+        }
+
+        _shown_x       = _cursor_x;
+        _shown_y       = _cursor_y;
+        _shown_visible = _cursor_visible;
+
+        if (not (_cur_attr == TAttr{})) _frame += "\x1B[0m";
+        if (_cursor_visible)
+        {
+            move_to(::std::clamp(_cursor_x, 0, ::std::max(_width - 1, 0)), ::std::clamp(_cursor_y, 0, ::std::max(_height - 1, 0)));
+            _frame += "\x1B[?25h";
+        }
+        return _frame;
+    }
+
+    size_t TScreen::present()
+    {
+        auto frame = render();
+        if (frame.empty()) return 0;
+
+        // earlier stream output goes first
+        outstream.flush();
+
+        WriteOutput(frame);
+        _presented = true;
+        return _frame.size();
+    }
+
+} // namespace console
+} // namespace sib
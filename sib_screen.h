@@ -0,0 +1,121 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sib {
+namespace console {
+
+    // ----------------------------------------------------------------------------------- cell attributes
+
+    inline constexpr ::std::uint16_t COLOR_DEFAULT = 256; // terminal default, 0..255 - xterm palette
+
+    enum TStyle : ::std::uint8_t
+    {
+        STYLE_NONE      = 0,
+        STYLE_BOLD      = 1 << 0,
+        STYLE_DIM       = 1 << 1,
+        STYLE_ITALIC    = 1 << 2,
+        STYLE_UNDERLINE = 1 << 3,
+        STYLE_REVERSE   = 1 << 4,
+    };
+
+    struct TAttr
+    {
+        ::std::uint16_t fg    = COLOR_DEFAULT;
+        ::std::uint16_t bg    = COLOR_DEFAULT;
+        ::std::uint8_t  style = STYLE_NONE;
+
+        constexpr bool operator==(TAttr const&) const noexcept = default;
+    };
+
+    struct TCell
+    {
+        char32_t ch = U' ';
+        TAttr    attr{};
+
+        constexpr bool operator==(TCell const&) const noexcept = default;
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- TScreen
+
+    /*
+        Double-buffered console screen. Drawing goes to the back grid of cells (one code point and
+        one attribute per cell); present() compares it with the front grid (what the terminal shows),
+        emits cursor moves, SGR attributes and text only for the changed cells and writes the whole
+        frame with one write call. Unchanged frames cost nothing.
+        The cursor goes to a changed cell by a relative move (CUU/CUD, CUF/CUB, CR) or an absolute
+        CUP, whichever is shorter; short gaps between changed cells on a row are rewritten instead
+        when that is shorter still. Cells are one column wide.
+        A screen that presented a frame with the cursor hidden shows it again when destroyed.
+    */
+    class TScreen
+    {
+    public:
+        TScreen(int width, int height);
+        ~TScreen();
+
+        TScreen(TScreen const&) = delete;
+        TScreen& operator=(TScreen const&) = delete;
+
+        int width () const noexcept { return _width ; }
+        int height() const noexcept { return _height; }
+
+        // the next frame is drawn from a cleared screen
+        void resize(int width, int height);
+        void invalidate() noexcept;
+
+        void clear(TAttr attr = {});
+
+        // nullptr out of the screen
+        TCell*       at(int x, int y)       noexcept;
+        TCell const* at(int x, int y) const noexcept;
+
+        // UTF-8 text clipped by the screen; returns the column after the text
+        int  print(int x, int y, ::std::string_view text, TAttr attr = {});
+        void fill (int x, int y, int width, int height, char32_t ch, TAttr attr = {});
+
+        // cursor shown at (x, y) after the frame, hidden if not visible
+        void cursor(int x, int y, bool visible = true) noexcept;
+
+        // escape sequences of the next frame, the front grid is updated
+        ::std::string_view render();
+
+        // render() written to the terminal; returns the frame size in bytes
+        size_t present();
+
+    private:
+        void move_to(int x, int y);
+        void set_attr(TAttr attr);
+        void put(TCell const& cell);
+
+        int                  _width  = 0;
+        int                  _height = 0;
+        ::std::vector<TCell> _front  {};
+        ::std::vector<TCell> _back   {};
+        ::std::string        _frame  {};
+        bool                 _full   = true;
+
+        // terminal state while rendering, -1 - unknown
+        int   _cur_x    = -1;
+        int   _cur_y    = -1;
+        TAttr _cur_attr {};
+        bool  _attr_known = false;
+
+        int  _cursor_x       = 0;
+        int  _cursor_y       = 0;
+        bool _cursor_visible = false;
+
+        // cursor left by the last frame
+        int  _shown_x        = -1;
+        int  _shown_y        = -1;
+        bool _shown_visible  = true;
+        bool _presented      = false; // a frame went to the terminal
+    };
+
+} // namespace console
+} // namespace sib
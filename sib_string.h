@@ -1,28 +1,540 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+#include <initializer_list>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <charconv>
+#include <ranges>
+#include <tuple>
 #include "sib_type_traits.h"
+#include "sib_utf.h"
 
 namespace sib {
 
+    // ----------------------------------------------------------------------------------- display width
+
+    namespace detail {
+
+        struct TCodePointRange { char32_t first, last; };
+
+        // combining marks and other code points drawn over the previous one
+        inline constexpr TCodePointRange zero_width_ranges[] = {
+            { 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD }, { 0x0610, 0x061A },
+            { 0x064B, 0x065F }, { 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E },
+            { 0x1AB0, 0x1AFF }, { 0x1DC0, 0x1DFF }, { 0x200B, 0x200F }, { 0x202A, 0x202E },
+            { 0x2060, 0x2064 }, { 0x20D0, 0x20FF }, { 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F },
+            { 0xFEFF, 0xFEFF }, { 0xE0100, 0xE01EF },
+        };
+
+        // East Asian wide and fullwidth forms, emoji
+        inline constexpr TCodePointRange double_width_ranges[] = {
+            { 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A }, { 0x23E9, 0x23EC },
+            { 0x25FD, 0x25FE }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 }, { 0x26AA, 0x26AB },
+            { 0x26BD, 0x26BE }, { 0x26F5, 0x26F5 }, { 0x26FA, 0x26FA }, { 0x2705, 0x2705 },
+            { 0x270A, 0x270B }, { 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x2753, 0x2755 },
+            { 0x2795, 0x2797 }, { 0x2B1B, 0x2B1C }, { 0x2E80, 0x303E }, { 0x3041, 0x33FF },
+            { 0x3400, 0x4DBF }, { 0x4E00, 0x9FFF }, { 0xA000, 0xA4CF }, { 0xA960, 0xA97F },
+            { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF }, { 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6F },
+            { 0xFF00, 0xFF60 }, { 0xFFE0, 0xFFE6 }, { 0x1F300, 0x1F64F }, { 0x1F680, 0x1F6FF },
+            { 0x1F900, 0x1F9FF }, { 0x1FA70, 0x1FAFF }, { 0x20000, 0x2FFFD }, { 0x30000, 0x3FFFD },
+        };
+
+        template <size_t N>
+        constexpr bool in_ranges(TCodePointRange const (&ranges)[N], char32_t cp) noexcept
+        {
+            auto it = ::std::upper_bound(ranges, ranges + N, cp,
+                [](char32_t value, TCodePointRange const& range) { return value < range.first; });
+            return it != ranges and cp <= (it - 1)->last;
+        }
+
+    } // namespace detail
+
+    // Terminal columns of a code point: 0 - combining and zero width, 2 - wide, 1 - the rest.
+    constexpr int code_point_width(char32_t cp) noexcept
+    {
+        if (cp < 0x0300) return 1;
+        if (detail::in_ranges(detail::zero_width_ranges  , cp)) return 0;
+        if (detail::in_ranges(detail::double_width_ranges, cp)) return 2;
+        return 1;
+    }
+
+    /*
+        Terminal columns taken by the text. char and char8_t are UTF-8, char16_t is UTF-16, other
+        character types hold one code point per character. Any ASCII character counts as one column;
+        ASCII runs of UTF-8 are skipped eight bytes per step, only the rest is decoded. Invalid
+        UTF-8 bytes count one column each.
+    */
+    template <Char Ch, typename Tr = ::std::char_traits<Ch>>
+    size_t display_width(::std::basic_string_view<Ch, Tr> text) noexcept
+    {
+        size_t width = 0;
+        if constexpr (sizeof(Ch) == 1)
+        {
+            auto ptr = reinterpret_cast<unsigned char const*>(text.data());
+            auto end = ptr + text.size();
+            while (ptr < end)
+            {
+                // ASCII run, a word at a time
+                ::std::uint64_t word;
+                while (end - ptr >= 8)
+                {
+                    ::std::memcpy(&word, ptr, 8);
+                    if (word & 0x8080808080808080ull) break;
+                    ptr   += 8;
+                    width += 8;
+                }
+                while (ptr < end and *ptr < 0x80) { ++ptr; ++width; }
+                if (ptr == end) break;
+
+                unsigned char lead = *ptr++;
+                unsigned need = (lead >= 0xF0 and lead <= 0xF4) ? 3 : (lead >= 0xE0) ? 2 : (lead >= 0xC2) ? 1 : 0;
+                if (need == 0 or lead > 0xF4) { ++width; continue; }
+
+                char32_t cp = lead & (0x3F >> need);
+                unsigned i = 0;
+                for (; i < need and ptr < end and (*ptr & 0xC0) == 0x80; ++i, ++ptr)
+                    cp = (cp << 6) | (*ptr & 0x3F);
+                width += (i == need) ? code_point_width(cp) : 1;
+            }
+        }
+        else if constexpr (sizeof(Ch) == 2)
+        {
+            for (size_t i = 0; i < text.size(); ++i)
+            {
+                char32_t cp = static_cast<char16_t>(text[i]);
+                if (cp >= 0xD800 and cp < 0xDC00 and i + 1 < text.size())
+                {
+                    char32_t low = static_cast<char16_t>(text[i + 1]);
+                    if (low >= 0xDC00 and low < 0xE000) { cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00); ++i; }
+                }
+                width += code_point_width(cp);
+            }
+        }
+        else
+        {
+            for (auto ch : text) width += code_point_width(static_cast<char32_t>(ch));
+        }
+        return width;
+    }
+
     template <BasicString Str>
-    Str aligned_string(Str const& content, unsigned const length, TPositionHor const aligned_string, typename Str::value_type const filling)
+    size_t display_width(Str const& text) noexcept
     {
+        return display_width(::std::basic_string_view<typename Str::value_type, typename Str::traits_type>(text));
+    }
 
-        Str result;
 
+
+    // ----------------------------------------------------------------------------------- aligned_string
+
+    // Appends the content padded with `filling` up to `length` columns (see display_width).
+    // Wider content is appended as is. Center puts the odd filling character on the right.
+    template <BasicString Str>
+    void append_aligned(
+        Str&                                                                              out,
+        ::std::basic_string_view<typename Str::value_type, typename Str::traits_type> content,
+        unsigned const                                                                    length,
+        TPositionHor const                                                                aligned,
+        typename Str::value_type const                                                    filling = ' ')
+    {
+        size_t width = display_width(content);
+        size_t free  = (width < length) ? length - width : 0;
+        size_t left  = (aligned == TPositionHor::Right) ? free : (aligned == TPositionHor::Center) ? free / 2 : 0;
+
+        out.reserve(out.size() + content.size() + free);
+        out.append(left, filling);
+        out.append(content);
+        out.append(free - left, filling);
+    }
+
+    template <BasicString Str>
+    Str aligned_string(Str const& content, unsigned const length, TPositionHor const aligned, typename Str::value_type const filling)
+    {
+        Str result;
+        append_aligned(result, content, length, aligned, filling);
         return result;
     }
 
+
+
+    // ----------------------------------------------------------------------------------- table_layout
+
+    struct TTableColumn
+    {
+        unsigned     width   = 0;
+        TPositionHor aligned = TPositionHor::Left;
+    };
+
+    /*
+        Rows of a text table: prefix, cells aligned in their columns, separators between them.
+        Cells wider than the column are not cut. New lines of the last cell continue under it, after
+        a blank row that is built once. Column offsets are computed once too, so the size of a row
+        is known before rendering (row_size) and a whole table goes into one reserved buffer.
+    */
+    template <BasicString Str>
+    class table_layout
+    {
+    public:
+        using value_type = typename Str::value_type;
+        using view_type  = ::std::basic_string_view<value_type, typename Str::traits_type>;
+
+        table_layout(::std::vector<TTableColumn> columns, view_type prefix = {}, view_type separator = {})
+            : _columns(::std::move(columns))
+            , _prefix(prefix)
+            , _separator(separator)
+        {
+            size_t pos = display_width(_prefix);
+            _blank.assign(_prefix);
+            for (size_t i = 0; i < _columns.size(); ++i)
+            {
+                if (i) { _blank.append(_separator); pos += display_width(_separator); }
+                _offset.push_back(pos);
+                pos += _columns[i].width;
+                if (i + 1 < _columns.size()) _blank.append(_columns[i].width, value_type(' '));
+            }
+        }
+
+        size_t columns() const noexcept { return _columns.size(); }
+
+        // column where the cell starts, the prefix included
+        size_t offset(size_t column) const noexcept { return _offset[column]; }
+
+        // blank row up to the last cell - the start of its continuation lines
+        view_type blank() const noexcept { return _blank; }
+
+        // characters append_row adds for these cells (the new line included)
+        size_t row_size(::std::initializer_list<view_type> cells) const noexcept
+        {
+            size_t size = _prefix.size() + 1;
+            size_t i    = 0;
+            for (auto cell : cells)
+            {
+                if (i) size += _separator.size();
+                if (i + 1 < _columns.size() or i + 1 < cells.size())
+                {
+                    size_t width = display_width(cell);
+                    size += cell.size() + ((width < width_of(i)) ? width_of(i) - width : 0);
+                }
+                else
+                {
+                    size += cell.size() + continuation_count(cell) * _blank.size();
+                    if (not cell.empty() and cell.back() == value_type('\n')) --size;
+                }
+                ++i;
+            }
+            return size;
+        }
+
+        void append_row(Str& out, ::std::initializer_list<view_type> cells) const
+        {
+            out.append(_prefix);
+            size_t i = 0;
+            for (auto cell : cells)
+            {
+                if (i) out.append(_separator);
+                if (i + 1 < _columns.size() or i + 1 < cells.size())
+                {
+                    append_aligned(out, cell, static_cast<unsigned>(width_of(i)), aligned_of(i));
+                }
+                else
+                {
+                    append_last(out, cell);
+                }
+                ++i;
+            }
+            out.push_back(value_type('\n'));
+        }
+
+        // append_row in parts, for outputs that keep the last cell as is (ropes):
+        // the row up to the last cell, then fn(piece) for the pieces of the last cell - its lines and
+        // the blank() rows before the continuations - all of them views of the cell or of the layout
+        void append_head(Str& out, ::std::initializer_list<view_type> cells) const
+        {
+            out.append(_prefix);
+            size_t i = 0;
+            for (auto cell : cells)
+            {
+                if (i) out.append(_separator);
+                if (i + 1 == cells.size()) break;
+                append_aligned(out, cell, static_cast<unsigned>(width_of(i)), aligned_of(i));
+                ++i;
+            }
+        }
+
+        template <typename Fn>
+        void for_last_cell(view_type cell, Fn&& fn) const
+        {
+            for (size_t pos = 0; pos < cell.size(); )
+            {
+                auto end = cell.find(value_type('\n'), pos);
+                if (end == view_type::npos or end + 1 == cell.size())
+                {
+                    fn(cell.substr(pos, (end == view_type::npos) ? view_type::npos : end - pos));
+                    break;
+                }
+                fn(cell.substr(pos, end + 1 - pos));
+                fn(view_type(_blank));
+                pos = end + 1;
+            }
+        }
+
+    private:
+        ::std::vector<TTableColumn> _columns;
+        ::std::vector<size_t>       _offset{};
+        Str                         _prefix;
+        Str                         _separator;
+        Str                         _blank{};
+
+        size_t       width_of  (size_t i) const noexcept { return (i < _columns.size()) ? _columns[i].width   : 0; }
+        TPositionHor aligned_of(size_t i) const noexcept { return (i < _columns.size()) ? _columns[i].aligned : TPositionHor(TPositionHor::Left); }
+
+        // new lines followed by more text
+        static size_t continuation_count(view_type cell) noexcept
+        {
+            if (cell.empty()) return 0;
+            cell.remove_suffix(1);
+            return static_cast<size_t>(::std::count(cell.begin(), cell.end(), value_type('\n')));
+        }
+
+        // the last cell ends a line and may take several
+        void append_last(Str& out, view_type cell) const
+        {
+            for_last_cell(cell, [&](view_type piece) { out.append(piece); });
+        }
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- like-string access
+
+    namespace detail {
+
+        // fn(basic_string_view<Src>) over the characters of a like string, char array or char pointer
+        // (arrays and pointers end at the terminator); non-contiguous containers are gathered first
+        template <typename T, typename Fn>
+        decltype(auto) with_chars(T const& arg, Fn&& fn)
+        {
+            if constexpr (::std::is_array_v<T>)
+            {
+                using Src = ::std::remove_cv_t<::std::remove_extent_t<T>>;
+                return fn(::std::basic_string_view<Src>(arg));
+            }
+            else if constexpr (::std::is_pointer_v<T>)
+            {
+                using Src = ::std::remove_cv_t<::std::remove_pointer_t<T>>;
+                return fn(arg ? ::std::basic_string_view<Src>(arg) : ::std::basic_string_view<Src>());
+            }
+            else if constexpr (::std::ranges::contiguous_range<T const> and ::std::ranges::sized_range<T const>)
+            {
+                using Src = ::std::remove_cvref_t<::std::ranges::range_reference_t<T const>>;
+                return fn(::std::basic_string_view<Src>(::std::ranges::data(arg), ::std::ranges::size(arg)));
+            }
+            else
+            {
+                using Src = ::std::remove_cvref_t<container_elem_t<T const>>;
+                ::std::basic_string<Src> text(::std::begin(arg), ::std::end(arg));
+                return fn(::std::basic_string_view<Src>(text));
+            }
+        }
+
+    } // namespace detail
+
+
+
+    // ----------------------------------------------------------------------------------- promiscuous_stringbuf
+
+    namespace detail {
+
+        // Per-thread free list of string buffers. A buffer taken by a stream goes back on destruction
+        // with its capacity, so short-lived streams stop allocating once the thread has warmed up.
+        template <typename Str>
+        class TStringArena
+        {
+        public:
+
+            static constexpr size_t max_count    = 8;
+            static constexpr size_t max_capacity = 64 * 1024;
+
+            static Str take()
+            {
+                if (closed()) return {};
+                auto& free = pool().free;
+                if (free.empty()) return {};
+                Str str = ::std::move(free.back());
+                free.pop_back();
+                return str;
+            }
+
+            static void give(Str&& str) noexcept
+            {
+                if (closed() or str.capacity() > max_capacity) return;
+                auto& free = pool().free;
+                if (free.size() == max_count) return;
+                try { free.push_back(::std::move(str)); }
+                catch (...) {}
+            }
+
+        private:
+
+            struct TPool
+            {
+                ::std::vector<Str> free{};
+                ~TPool() { closed() = true; }
+            };
+
+            static TPool& pool() { thread_local TPool value; return value; }
+
+            // streams destroyed after the pool at thread or program exit just free their buffers
+            static bool& closed() noexcept { thread_local bool value = false; return value; }
+        };
+
+    } // namespace detail
+
+    // The stream buffer of promiscuous_stringstream: writes straight into a string taken from a per-thread
+    // arena and shows the written text as a view without copying it.
+    template <::sib::Char Ch, typename Tr = ::std::char_traits<Ch>, typename Al = std::allocator<Ch>>
+    class promiscuous_stringbuf : public ::std::basic_streambuf<Ch, Tr>
+    {
+    private:
+
+        using base_type   = ::std::basic_streambuf<Ch, Tr>;
+        using string_type = ::std::basic_string<Ch, Tr, Al>;
+        using view_type   = ::std::basic_string_view<Ch, Tr>;
+        using arena       = detail::TStringArena<string_type>;
+
+    public:
+
+        using char_type = Ch;
+        using traits_type = Tr;
+        using allocator_type = Al;
+        using int_type = typename Tr::int_type;
+        using pos_type = typename Tr::pos_type;
+        using off_type = typename Tr::off_type;
+
+        promiscuous_stringbuf() : _buf(arena::take()) { reset(0); }
+
+        promiscuous_stringbuf(promiscuous_stringbuf const&) = delete;
+        promiscuous_stringbuf& operator= (promiscuous_stringbuf const&) = delete;
+
+        ~promiscuous_stringbuf() override { arena::give(::std::move(_buf)); }
+
+        size_t size() const noexcept { return static_cast<size_t>(this->pptr() - this->pbase()); }
+
+        view_type view() const noexcept { return { this->pbase(), size() }; }
+
+        string_type str() const & { return string_type(view()); }
+
+        // hands the buffer over instead of copying it, the next writes start with a new one
+        string_type str() &&
+        {
+            _buf.resize(size());
+            string_type out = ::std::move(_buf);
+            _buf = string_type();
+            reset(0);
+            return out;
+        }
+
+        void str(view_type text)
+        {
+            _buf.assign(text);
+            reset(text.size());
+        }
+
+    protected:
+
+        int_type overflow(int_type ch) override
+        {
+            if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+            grow(1);
+            *this->pptr() = traits_type::to_char_type(ch);
+            this->pbump(1);
+            return ch;
+        }
+
+        ::std::streamsize xsputn(char_type const* ptr, ::std::streamsize count) override
+        {
+            if (count <= 0) return 0;
+            auto len = static_cast<size_t>(count);
+            if (static_cast<size_t>(this->epptr() - this->pptr()) < len) grow(len);
+            traits_type::copy(this->pptr(), ptr, len);
+            advance(len);
+            return count;
+        }
+
+        // reading back what was written
+        int_type underflow() override
+        {
+            size_t pos = this->eback() ? static_cast<size_t>(this->gptr() - this->eback()) : 0;
+            this->setg(this->pbase(), this->pbase() + pos, this->pptr());
+            return (this->gptr() < this->egptr()) ? traits_type::to_int_type(*this->gptr()) : traits_type::eof();
+        }
+
+    private:
+
+        string_type _buf;
+
+        // the whole capacity is the put area, 'used' characters are already written
+        void reset(size_t used)
+        {
+            _buf.resize(_buf.capacity());
+            this->setp(_buf.data(), _buf.data() + _buf.size());
+            this->setg(nullptr, nullptr, nullptr);
+            advance(used);
+        }
+
+        void grow(size_t extra)
+        {
+            size_t used = size();
+            size_t pos  = this->eback() ? static_cast<size_t>(this->gptr() - this->eback()) : 0;
+            _buf.resize(::std::max({ used + extra, 2 * _buf.size(), size_t(64) }));
+            _buf.resize(_buf.capacity());
+            this->setp(_buf.data(), _buf.data() + _buf.size());
+            advance(used);
+            if (pos) this->setg(this->pbase(), this->pbase() + pos, this->pptr());
+            else     this->setg(nullptr, nullptr, nullptr);
+        }
+
+        // pbump takes an int
+        void advance(size_t count)
+        {
+            for (; count > INT_MAX; count -= INT_MAX) this->pbump(INT_MAX);
+            this->pbump(static_cast<int>(count));
+        }
+    };
+
+
+
     // ----------------------------------------------------------------------------------- promiscuous_stringstream
 
+    namespace detail {
+
+        // constructed before the stream base that gets a pointer to it
+        template <typename Buf>
+        struct TStreambufHolder { Buf _strbuf{}; };
+
+    } // namespace detail
+
+    // Output of the standard stream plus like strings of other char types, transcoded (see sib_utf.h).
+    // Cheap to create: the text lives in a recycled arena buffer and view() reads it without a copy.
     template <::sib::Char Ch, typename Tr = ::std::char_traits<Ch>, typename Al = std::allocator<Ch>>
-    class promiscuous_stringstream : public ::std::basic_stringstream<Ch, Tr, Al>
+    class promiscuous_stringstream
+        : private detail::TStreambufHolder<promiscuous_stringbuf<Ch, Tr, Al>>
+        , public  ::std::basic_iostream<Ch, Tr>
     {
     private:
 
-        using base_type = ::std::basic_stringstream<Ch, Tr, Al>;
-        using string_type = ::std::basic_string      <Ch, Tr, Al>;
+        using base_type   = ::std::basic_iostream<Ch, Tr>;
+        using string_type = ::std::basic_string     <Ch, Tr, Al>;
+        using view_type   = ::std::basic_string_view<Ch, Tr>;
+        using buf_type    = promiscuous_stringbuf   <Ch, Tr, Al>;
 
     public:
 
@@ -33,10 +545,17 @@ namespace sib {
         using pos_type = typename Tr::pos_type;
         using off_type = typename Tr::off_type;
 
-        promiscuous_stringstream() = default;
+        promiscuous_stringstream() : base_type(&this->_strbuf) {}
+
+        promiscuous_stringstream(promiscuous_stringstream const&) = delete;
+        promiscuous_stringstream& operator= (promiscuous_stringstream const&) = delete;
 
-        promiscuous_stringstream(base_type const& sstr) : base_type(sstr) {}
-        promiscuous_stringstream(base_type&& sstr) : base_type(std::move(sstr)) {}
+        buf_type* rdbuf() const noexcept { return const_cast<buf_type*>(&this->_strbuf); }
+
+        view_type   view() const noexcept { return this->_strbuf.view(); }
+        string_type str () const &        { return this->_strbuf.str(); }
+        string_type str () &&             { return ::std::move(this->_strbuf).str(); }
+        void        str (view_type text)  { this->_strbuf.str(text); }
 
         template <typename Arg>
             requires(requires(base_type& bos, Arg arg) { bos << arg; })
@@ -52,13 +571,152 @@ namespace sib {
         and is_castable_from_to_v<container_elem_t<Str>, char_type>)
             promiscuous_stringstream& operator<< (Str&& str)&
         {
-            decltype(auto) bos = static_cast<base_type&>(*this);
-            for (container_elem_t<Str> ch : str) bos << static_cast<char_type>(ch);
+            detail::with_chars(str, [this](auto text)
+            {
+                transcode<char_type>(text, [this](char_type const* ptr, size_t len)
+                {
+                    this->write(ptr, static_cast<::std::streamsize>(len));
+                });
+            });
             return *this;
         }
 
     };
 
+    // ----------------------------------------------------------------------------------- string pieces
+
+    // promiscuous_string(args...) formats each argument as promiscuous_stringstream would, but measures
+    // all of them first and writes the result into a single allocation.
+
+    namespace detail {
+
+        // characters of a contiguous range, transcoded when the target char type differs
+        template <Char Src>
+        struct TCharsPiece
+        {
+            Src const* data;
+            size_t     len;
+
+            template <Char Dst>
+            size_t size() const noexcept { return transcoded_length<Dst>(::std::basic_string_view<Src>(data, len)); }
+
+            template <typename Str>
+            void append_to(Str& out) const { append_transcoded(out, ::std::basic_string_view<Src>(data, len)); }
+        };
+
+        // a number written by to_chars (plain ASCII in every locale the stream is used with)
+        struct TNumberPiece
+        {
+            char   buf[64];
+            size_t len;
+
+            template <Char Dst>
+            size_t size() const noexcept { return len; }
+
+            template <typename Str>
+            void append_to(Str& out) const { TCharsPiece<char>{ buf, len }.append_to(out); }
+        };
+
+        // a non-contiguous like-string container, gathered first
+        template <Char Src>
+        struct TRangePiece
+        {
+            ::std::basic_string<Src> text;
+
+            template <Char Dst>
+            size_t size() const noexcept { return TCharsPiece<Src>{ text.data(), text.size() }.template size<Dst>(); }
+
+            template <typename Str>
+            void append_to(Str& out) const { TCharsPiece<Src>{ text.data(), text.size() }.append_to(out); }
+        };
+
+        // anything else goes through the stream
+        template <typename Str>
+        struct TStreamPiece
+        {
+            Str text;
+
+            template <Char Dst>
+            size_t size() const noexcept { return text.size(); }
+
+            void append_to(Str& out) const { out.append(text); }
+        };
+
+        template <typename T, typename Ch, typename Tr>
+        consteval bool is_string_of()
+        {
+            if constexpr (::std::is_same_v<T, ::std::basic_string_view<Ch, Tr>>) return true;
+            else if constexpr (BasicString<T>)
+            {
+                using S = as_basic_string_t<T>;
+                return ::std::is_same_v<typename S::value_type, Ch> and ::std::is_same_v<typename S::traits_type, Tr>;
+            }
+            else return false;
+        }
+
+        template <Char Ch, typename Tr, typename Al, typename Arg>
+        auto make_piece(Arg const& arg)
+        {
+            using T = ::std::remove_cv_t<Arg>;
+
+            if constexpr (::std::is_same_v<T, Ch>)
+                return TCharsPiece<Ch>{ &arg, 1 };
+            else if constexpr (::std::is_same_v<Ch, char> and is_any_of_v<T, signed char, unsigned char>)
+                return TCharsPiece<T>{ &arg, 1 };                               // ostream<char> prints them as characters
+            else if constexpr (::std::is_same_v<T, bool>)
+                return TCharsPiece<char>{ arg ? "1" : "0", 1 };                 // a fresh stream has no boolalpha
+            else if constexpr (::std::is_integral_v<T> and not is_char_v<T>)
+            {
+                TNumberPiece piece;
+                piece.len = static_cast<size_t>(::std::to_chars(piece.buf, piece.buf + sizeof(piece.buf), arg).ptr - piece.buf);
+                return piece;
+            }
+            else if constexpr (::std::is_floating_point_v<T>)
+            {
+                TNumberPiece piece;                                             // the stream default: %g, precision 6
+                piece.len = static_cast<size_t>(::std::to_chars(piece.buf, piece.buf + sizeof(piece.buf), arg,
+                    ::std::chars_format::general, 6).ptr - piece.buf);
+                return piece;
+            }
+            else if constexpr (::std::is_array_v<T> and is_char_v<::std::remove_extent_t<T>>)
+            {
+                using Src = ::std::remove_cv_t<::std::remove_extent_t<T>>;      // a literal ends at its terminator
+                return TCharsPiece<Src>{ arg, ::std::char_traits<Src>::length(arg) };
+            }
+            else if constexpr (::std::is_pointer_v<T> and is_char_v<::std::remove_pointer_t<T>>)
+            {
+                using Src = ::std::remove_cv_t<::std::remove_pointer_t<T>>;
+                return TCharsPiece<Src>{ arg, arg ? ::std::char_traits<Src>::length(arg) : 0 };
+            }
+            else if constexpr (is_string_of<T, Ch, Tr>())
+                return TCharsPiece<Ch>{ arg.data(), arg.size() };
+            else if constexpr (LikeString<T> and not requires(::std::basic_ostream<Ch, Tr>& os) { os << arg; })
+            {
+                if constexpr (::std::ranges::contiguous_range<T const> and ::std::ranges::sized_range<T const>)
+                {
+                    using Src = ::std::remove_cvref_t<::std::ranges::range_reference_t<T const>>;
+                    return TCharsPiece<Src>{ ::std::ranges::data(arg), ::std::ranges::size(arg) };
+                }
+                else
+                {
+                    using Src = ::std::remove_cvref_t<container_elem_t<T const>>;
+                    return TRangePiece<Src>{ ::std::basic_string<Src>(::std::begin(arg), ::std::end(arg)) };
+                }
+            }
+            else
+            {
+                promiscuous_stringstream<Ch, Tr, Al> buf;
+                buf << arg;
+                return TStreamPiece<::std::basic_string<Ch, Tr, Al>>{ ::std::move(buf).str() };
+            }
+        }
+
+    } // namespace detail
+
+
+
+    // ----------------------------------------------------------------------------------- promiscuous_string
+
     template <Char Ch, typename Tr = ::std::char_traits<Ch>, typename Al = std::allocator<Ch>>
     class promiscuous_string : public ::std::basic_string<Ch, Tr, Al>
     {
@@ -66,17 +724,20 @@ namespace sib {
 
         using base_type = ::std::basic_string<Ch, Tr, Al>;
 
-        using support_bufer_type = promiscuous_stringstream<Ch, Tr, Al>;
-
-        template <Char _Ch>
-        using simple_string = ::std::basic_string<_Ch>;
-
         template <typename... Args>
-        promiscuous_string init(Args&&... args)
+        static base_type build(Args const&... args)
         {
-            support_bufer_type buf;
-            (buf << ... << ::std::forward<Args>(args));
-            return buf.str();
+            base_type out;
+            if constexpr (sizeof...(Args) != 0)
+            {
+                ::std::tuple pieces{ detail::make_piece<Ch, Tr, Al>(args)... };
+                ::std::apply([&out](auto const&... piece)
+                {
+                    out.reserve((piece.template size<Ch>() + ...));
+                    (piece.append_to(out), ...);
+                }, pieces);
+            }
+            return out;
         }
 
     public:
@@ -104,15 +765,21 @@ namespace sib {
         promiscuous_string(base_type&& str) : base_type(std::move(str)) {}
 
         template <::sib::LikeString Str>
-        promiscuous_string(Str const& str) : base_type(str.begin(), str.end()) {}
+        promiscuous_string(Str const& str)
+        {
+            detail::with_chars(str, [this](auto text) { append_transcoded(*this, text); });
+        }
 
         template <::sib::Char _Ch>
-        promiscuous_string(_Ch const* ptr) : promiscuous_string(simple_string<_Ch>(ptr)) {}
+        promiscuous_string(_Ch const* ptr)
+        {
+            append_transcoded(*this, ::std::basic_string_view<_Ch>(ptr));
+        }
 
         promiscuous_string(Ch ch) : base_type{ ch } {}
 
         template <typename... Args>
-        promiscuous_string(Args&&... args) : base_type(init(std::forward<Args>(args) ...)) {}
+        promiscuous_string(Args&&... args) : base_type(build(args...)) {}
     };
 
 
@@ -1,6 +1,12 @@
 ﻿#include "sib_support.h"
 
 #include <random>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
 
 namespace sib {
 
@@ -13,4 +19,150 @@ namespace sib {
     /* random in [0, 1) */ inline double rand() { return __dis(__gen); }
     /* random in [0, X) */ inline double rand(double X) { return rand() * X; }
 
+
+
+    // ----------------------------------------------------------------------------------- scope_timer
+
+    namespace {
+
+        struct scope_timer_entry
+        {
+            ::std::string                        name;
+            ::std::unique_ptr<latency_histogram> hist;
+        };
+
+        struct scope_timer_thread;
+
+        struct scope_timer_registry
+        {
+            ::std::mutex                      mtx{};
+            ::std::vector<scope_timer_thread*> threads{};
+
+            // histograms of the threads that exited, merged by name
+            ::std::map<::std::string, latency_histogram> retired{};
+
+            // ticks to nanoseconds, measured at the first registration
+            ::std::once_flag calibrated{};
+            double           ns_per_tick = 1.0;
+        };
+
+        scope_timer_registry& timers()
+        {
+            static scope_timer_registry registry{};
+            return registry;
+        }
+
+        // histograms of one thread, handed over to the registry when the thread exits
+        struct scope_timer_thread
+        {
+            ::std::vector<scope_timer_entry> entries{}; // changed under the registry lock
+
+            scope_timer_thread()
+            {
+                auto& reg = timers(); // the registry outlives every thread_local constructed after it
+                ::std::lock_guard lock(reg.mtx);
+                reg.threads.push_back(this);
+            }
+
+            ~scope_timer_thread()
+            {
+                auto& reg = timers();
+                ::std::lock_guard lock(reg.mtx);
+                for (auto const& entry : entries) reg.retired[entry.name].merge(*entry.hist);
+                reg.threads.erase(::std::find(reg.threads.begin(), reg.threads.end(), this));
+            }
+        };
+
+        // ticks counted over a 2 ms spin of the steady clock
+        double calibrate_ns_per_tick()
+        {
+            auto const start_time  = ::std::chrono::steady_clock::now();
+            auto const start_ticks = detail::scope_timer_ticks();
+            auto       now         = start_time;
+            while (now - start_time < ::std::chrono::milliseconds(2)) now = ::std::chrono::steady_clock::now();
+
+            auto ticks = detail::scope_timer_ticks() - start_ticks;
+            auto ns    = ::std::chrono::duration<double, ::std::nano>(now - start_time).count();
+            return ticks ? ns / static_cast<double>(ticks) : 1.0;
+        }
+
+        ::std::string time_to_str(double ns)
+        {
+            ::std::ostringstream buf;
+            buf << ::std::fixed << ::std::setprecision(1);
+            if      (ns < 1e3) buf << ns        << " ns";
+            else if (ns < 1e6) buf << ns / 1e3 << " us";
+            else if (ns < 1e9) buf << ns / 1e6 << " ms";
+            else               buf << ns / 1e9 << " s" ;
+            return buf.str();
+        }
+
+    } // namespace
+
+    latency_histogram& scope_timer_histogram(char const * name)
+    {
+        static thread_local scope_timer_thread this_thread{};
+        auto& reg = timers();
+        ::std::call_once(reg.calibrated, [&reg] { reg.ns_per_tick = calibrate_ns_per_tick(); });
+        ::std::lock_guard lock(reg.mtx);
+        this_thread.entries.push_back({ name, ::std::make_unique<latency_histogram>() });
+        return *this_thread.entries.back().hist;
+    }
+
+    ::std::vector<scope_timer_summary> scope_timers_summary()
+    {
+        ::std::map<::std::string, latency_histogram> merged;
+        double scale = 1.0;
+        {
+            auto& reg = timers();
+            ::std::lock_guard lock(reg.mtx);
+            scale = reg.ns_per_tick;
+            for (auto const & [name, hist] : reg.retired) merged[name].merge(hist);
+            for (auto const * thread : reg.threads)
+                for (auto const & entry : thread->entries) merged[entry.name].merge(*entry.hist);
+        }
+
+        ::std::vector<scope_timer_summary> res;
+        for (auto const & [name, hist] : merged)
+        {
+            scope_timer_summary sum{ name, hist.total(), 0, 0, 0, 0, 0 };
+            if (sum.count == 0) { res.push_back(sum); continue; }
+
+            auto at = [&](double q) { return static_cast<double>(hist.percentile(q)) * scale; };
+
+            sum.p50  = at(0.5  );
+            sum.p90  = at(0.9  );
+            sum.p99  = at(0.99 );
+            sum.p999 = at(0.999);
+            sum.max  = at(1.0  );
+            res.push_back(sum);
+        }
+        return res;
+    }
+
+    ::std::string scope_timers_text()
+    {
+        auto sums = scope_timers_summary();
+        if (sums.empty()) return {};
+
+        ::std::ostringstream buf;
+        buf << ::std::left
+            << "  ---------------------------------------------------------------------------------------------\n"
+            << "  | Timer                    | Count      | p50        | p90        | p99        | p999       | max\n"
+            << "  ---------------------------------------------------------------------------------------------\n";
+        for (auto const & sum : sums)
+        {
+            buf << "  | " << ::std::setw(24) << sum.name
+                << " | " << ::std::setw(10) << sum.count
+                << " | " << ::std::setw(10) << time_to_str(sum.p50 )
+                << " | " << ::std::setw(10) << time_to_str(sum.p90 )
+                << " | " << ::std::setw(10) << time_to_str(sum.p99 )
+                << " | " << ::std::setw(10) << time_to_str(sum.p999)
+                << " | " << time_to_str(sum.max)
+                << "\n";
+        }
+        buf << "  ---------------------------------------------------------------------------------------------\n";
+        return buf.str();
+    }
+
 }  // namespace sib
@@ -4,6 +4,16 @@
 #include <type_traits>
 #include <cstdint>
 #include <stdexcept>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
 
 
 namespace sib {
@@ -192,6 +202,148 @@ namespace sib {
         auto SIB_CONCAT(sib_object_guard_, __COUNTER__) = __VA_ARGS__;  \
 
 
+
+    // ----------------------------------------------------------------------------------- scope_timer
+
+    /*
+        Log-linear (HDR-like) latency histogram.
+        Values below 2^SUB_BITS are counted exactly, every next power of two is split into
+        2^SUB_BITS linear sub-buckets, so the relative error of a bucket is below 1/2^SUB_BITS.
+        One writer (the owning thread) and any number of readers: record() is a relaxed
+        load/store pair on a single counter, no locks, no allocation.
+    */
+    class latency_histogram
+    {
+    public:
+        static constexpr unsigned SUB_BITS     = 4;
+        static constexpr unsigned SUB_COUNT    = 1u << SUB_BITS;
+        static constexpr unsigned BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+        static constexpr unsigned bucket_of(::std::uint64_t val) noexcept
+        {
+            if (val < SUB_COUNT) return static_cast<unsigned>(val);
+            unsigned shift = static_cast<unsigned>(::std::bit_width(val)) - 1 - SUB_BITS;
+            return ((shift + 1) << SUB_BITS) + static_cast<unsigned>((val >> shift) - SUB_COUNT);
+        }
+
+        // smallest value that falls into the bucket
+        static constexpr ::std::uint64_t bucket_low(unsigned idx) noexcept
+        {
+            if (idx < SUB_COUNT) return idx;
+            unsigned shift = (idx >> SUB_BITS) - 1;
+            return ::std::uint64_t(SUB_COUNT + (idx & (SUB_COUNT - 1))) << shift;
+        }
+
+        // largest value that falls into the bucket
+        static constexpr ::std::uint64_t bucket_high(unsigned idx) noexcept
+        {
+            if (idx < SUB_COUNT) return idx;
+            unsigned shift = (idx >> SUB_BITS) - 1;
+            return bucket_low(idx) + ((::std::uint64_t(1) << shift) - 1);
+        }
+
+        void record(::std::uint64_t val) noexcept
+        {
+            auto& cnt = _counts[bucket_of(val)];
+            cnt.store(cnt.load(::std::memory_order_relaxed) + 1, ::std::memory_order_relaxed);
+        }
+
+        ::std::uint64_t count(unsigned idx) const noexcept
+        {
+            return _counts[idx].load(::std::memory_order_relaxed);
+        }
+
+        ::std::uint64_t total() const noexcept
+        {
+            ::std::uint64_t sum = 0;
+            for (auto const& cnt : _counts) sum += cnt.load(::std::memory_order_relaxed);
+            return sum;
+        }
+
+        // adds the counts of `other` (the caller keeps the writers of this histogram out)
+        void merge(latency_histogram const& other) noexcept
+        {
+            for (unsigned i = 0; i < BUCKET_COUNT; ++i)
+                if (auto cnt = other.count(i)) _counts[i].store(count(i) + cnt, ::std::memory_order_relaxed);
+        }
+
+        // upper bound of the bucket holding the q-quantile (q in [0, 1]), 0 for an empty histogram
+        ::std::uint64_t percentile(double q) const noexcept
+        {
+            auto sum = total();
+            if (sum == 0) return 0;
+            auto rank = static_cast<::std::uint64_t>(q * static_cast<double>(sum - 1)) + 1;
+            ::std::uint64_t acc = 0;
+            for (unsigned i = 0; i < BUCKET_COUNT; ++i)
+            {
+                acc += count(i);
+                if (acc >= rank) return bucket_high(i);
+            }
+            return bucket_high(BUCKET_COUNT - 1);
+        }
+
+    private:
+        ::std::array<::std::atomic<::std::uint64_t>, BUCKET_COUNT> _counts{};
+    };
+
+    static_assert(latency_histogram::bucket_of(0)      == 0);
+    static_assert(latency_histogram::bucket_of(15)     == 15);
+    static_assert(latency_histogram::bucket_of(16)     == 16);
+    static_assert(latency_histogram::bucket_of(33)     == 32);
+    static_assert(latency_histogram::bucket_of(UINT64_MAX) == latency_histogram::BUCKET_COUNT - 1);
+    static_assert(latency_histogram::bucket_low (latency_histogram::bucket_of(1000)) <= 1000);
+    static_assert(latency_histogram::bucket_high(latency_histogram::bucket_of(1000)) >= 1000);
+    static_assert(latency_histogram::bucket_high(latency_histogram::BUCKET_COUNT - 1) == UINT64_MAX);
+
+    namespace detail {
+
+        // Raw timestamp for SIB_SCOPE_TIMER: TSC where available (a few ns), steady_clock otherwise.
+        // Ticks are converted to nanoseconds only when a report is built.
+        inline ::std::uint64_t scope_timer_ticks() noexcept
+        {
+            #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+                return __rdtsc();
+            #elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+                return __builtin_ia32_rdtsc();
+            #else
+                return static_cast<::std::uint64_t>(::std::chrono::steady_clock::now().time_since_epoch().count());
+            #endif
+        }
+
+    } // namespace detail
+
+    // Histogram of the calling thread for the timer <name>.
+    // The first call per thread and site registers it (lock + allocation). When the thread exits,
+    // its histograms are merged into the registry by name and freed - a timer must not run in
+    // thread_local destructors of that thread after that.
+    latency_histogram& scope_timer_histogram(char const * name);
+
+    struct scope_timer_summary
+    {
+        ::std::string   name;
+        ::std::uint64_t count;
+        double          p50, p90, p99, p999, max; // ns
+    };
+
+    // Merges the histograms of all threads by timer name.
+    ::std::vector<scope_timer_summary> scope_timers_summary();
+
+    // Table with p50/p90/p99/p999 for every timer, empty if no timer was registered.
+    ::std::string scope_timers_text();
+
+    #define SIB_SCOPE_TIMER(name) SIB_SCOPE_TIMER_IMPL(name, __COUNTER__)
+
+    #define SIB_SCOPE_TIMER_IMPL(name, id)                                                         \
+        static thread_local ::sib::latency_histogram& SIB_CONCAT(sib_scope_timer_hist_, id) =      \
+            ::sib::scope_timer_histogram(name);                                                    \
+        ::std::uint64_t const SIB_CONCAT(sib_scope_timer_start_, id) =                             \
+            ::sib::detail::scope_timer_ticks();                                                    \
+        SIB_SCOPE_GUARD(                                                                           \
+            SIB_CONCAT(sib_scope_timer_hist_, id).record(                                          \
+                ::sib::detail::scope_timer_ticks() - SIB_CONCAT(sib_scope_timer_start_, id));      \
+        )                                                                                          \
+
+
     // ----------------------------------------------------------------------------------- forward_like
 
     template<class T, class U>
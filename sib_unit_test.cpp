@@ -1,7 +1,120 @@
 ﻿#include "sib_unit_test.h"
 
 #include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <fstream>
 #include <iomanip>
+#include <cstdlib>
+#include <new>
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <tuple>
+
+#include "sib_support.h"
+#include "sib_format.h"
+
+#if defined(__linux__)
+    #include <unistd.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <linux/perf_event.h>
+#endif
+
+// ----------------------------------------------------------------------------------- allocation counter
+
+#ifndef SIB_DEBUG_NO_ALLOC_COUNTER
+
+    namespace sib { namespace debug { namespace detail {
+        thread_local long long alloc_accum = 0;
+    } } }
+
+    // The whole replaceable family goes through these two pairs, so every allocation is counted
+    // and every pointer is freed by the function that matches its allocation.
+    namespace sib { namespace debug { namespace detail {
+
+        void* counted_alloc(::std::size_t size, ::std::size_t align, bool nothrow)
+        {
+            ++alloc_accum;
+            if (size == 0) size = 1;
+            for (;;)
+            {
+                void* ptr = nullptr;
+                if (align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                    ptr = ::std::malloc(size);
+                else
+                    #if defined(_WIN32)
+                        ptr = ::_aligned_malloc(size, align);
+                    #else
+                        ptr = ::std::aligned_alloc(align, (size + align - 1) / align * align);
+                    #endif
+                if (ptr) return ptr;
+
+                auto handler = ::std::get_new_handler();
+                if (not handler)
+                {
+                    if (nothrow) return nullptr;
+                    throw ::std::bad_alloc();
+                }
+                if (nothrow)
+                {
+                    try { handler(); } catch (...) { return nullptr; }
+                }
+                else handler();
+            }
+        }
+
+        void counted_free(void* ptr, ::std::size_t align) noexcept
+        {
+            #if defined(_WIN32)
+                if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) { ::_aligned_free(ptr); return; }
+            #endif
+            (void)align;
+            ::std::free(ptr);
+        }
+
+        constexpr ::std::size_t default_align = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+    } } }
+
+    #if defined(__GNUC__) && !defined(__clang__)
+        // GCC pairs free() in these replacements with the operator new it sees inlined at the call site
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+    #endif
+
+    using ::sib::debug::detail::counted_alloc;
+    using ::sib::debug::detail::counted_free;
+    using ::sib::debug::detail::default_align;
+
+    void* operator new  (::std::size_t size)                                            { return counted_alloc(size, default_align, false); }
+    void* operator new[](::std::size_t size)                                            { return counted_alloc(size, default_align, false); }
+    void* operator new  (::std::size_t size, ::std::nothrow_t const&) noexcept          { return counted_alloc(size, default_align, true ); }
+    void* operator new[](::std::size_t size, ::std::nothrow_t const&) noexcept          { return counted_alloc(size, default_align, true ); }
+    void* operator new  (::std::size_t size, ::std::align_val_t al)                     { return counted_alloc(size, ::std::size_t(al), false); }
+    void* operator new[](::std::size_t size, ::std::align_val_t al)                     { return counted_alloc(size, ::std::size_t(al), false); }
+    void* operator new  (::std::size_t size, ::std::align_val_t al, ::std::nothrow_t const&) noexcept { return counted_alloc(size, ::std::size_t(al), true); }
+    void* operator new[](::std::size_t size, ::std::align_val_t al, ::std::nothrow_t const&) noexcept { return counted_alloc(size, ::std::size_t(al), true); }
+
+    void operator delete  (void* ptr) noexcept                                          { counted_free(ptr, default_align); }
+    void operator delete[](void* ptr) noexcept                                          { counted_free(ptr, default_align); }
+    void operator delete  (void* ptr, ::std::size_t) noexcept                           { counted_free(ptr, default_align); }
+    void operator delete[](void* ptr, ::std::size_t) noexcept                           { counted_free(ptr, default_align); }
+    void operator delete  (void* ptr, ::std::nothrow_t const&) noexcept                 { counted_free(ptr, default_align); }
+    void operator delete[](void* ptr, ::std::nothrow_t const&) noexcept                 { counted_free(ptr, default_align); }
+    void operator delete  (void* ptr, ::std::align_val_t al) noexcept                   { counted_free(ptr, ::std::size_t(al)); }
+    void operator delete[](void* ptr, ::std::align_val_t al) noexcept                   { counted_free(ptr, ::std::size_t(al)); }
+    void operator delete  (void* ptr, ::std::size_t, ::std::align_val_t al) noexcept    { counted_free(ptr, ::std::size_t(al)); }
+    void operator delete[](void* ptr, ::std::size_t, ::std::align_val_t al) noexcept    { counted_free(ptr, ::std::size_t(al)); }
+    void operator delete  (void* ptr, ::std::align_val_t al, ::std::nothrow_t const&) noexcept { counted_free(ptr, ::std::size_t(al)); }
+    void operator delete[](void* ptr, ::std::align_val_t al, ::std::nothrow_t const&) noexcept { counted_free(ptr, ::std::size_t(al)); }
+
+    #if defined(__GNUC__) && !defined(__clang__)
+        #pragma GCC diagnostic pop
+    #endif
+
+#endif // SIB_DEBUG_NO_ALLOC_COUNTER
 
 namespace sib {
 namespace debug {
@@ -14,6 +127,11 @@ namespace debug {
 
         thread_local TBufer output_bufer {};
 
+        // Log of the running test and the start of the current BEG block for the static checks.
+        thread_local TTestLog*    current_log = nullptr;
+        thread_local char const * block_file  = nullptr;
+        thread_local unsigned     block_line  = 0;
+
     } // namespace detail
 
     static bool is_initialized_val = false;
@@ -38,13 +156,70 @@ namespace debug {
 
     ::std::mutex mtx{};
 
-    void under_lock_print(TString const& str)
+    namespace {
+        // set by RunAllTest(TProgressOptions), takes the transcript instead of outstream
+        ::std::basic_ostream<OutStrmCh, OutStrmTr>* transcript_sink = nullptr;
+
+        // transcript of the test this thread runs in parallel with others, written out as one block
+        thread_local TBufer* test_transcript = nullptr;
+    }
+
+    void under_lock_print(TStringView str)
     {
+        if (test_transcript)
+        {
+            *test_transcript << str;
+            return;
+        }
         ::std::lock_guard lock(mtx);
+        if (transcript_sink)
+        {
+            *transcript_sink << str;
+            return;
+        }
         outstream << str;
         outstream.flush();
     }
 
+    namespace {
+        // stdout buffer of std::cout before anyone swaps it
+        ::std::streambuf* const stdout_buf = ::std::cout.rdbuf();
+    }
+
+    void under_lock_print(TRope const& text)
+    {
+        if (test_transcript)
+        {
+            *test_transcript << text;
+            return;
+        }
+        ::std::lock_guard lock(mtx);
+        if (transcript_sink)
+        {
+            *transcript_sink << text;
+            return;
+        }
+        if constexpr (::std::is_same_v<TOutStream, ::std::ostream>)
+        {
+            // straight to stdout: one writev over the chunks instead of a copy into the stream buffer
+            if (&outstream == &::std::cout and ::std::cout.rdbuf() == stdout_buf)
+            {
+                ::std::vector<::std::string_view> pieces;
+                pieces.reserve(text.chunks().size());
+                for (auto const& chunk : text.chunks()) pieces.emplace_back(chunk.text.data(), chunk.text.size());
+                outstream.flush();
+                size_t written = 0;
+                if (::sib::console::WriteOutput(pieces, written)) return;
+                // the rest goes through the stream, which keeps the failure in its state
+                outstream << text.substr(written);
+                outstream.flush();
+                return;
+            }
+        }
+        outstream << text;
+        outstream.flush();
+    }
+
 
 
     // ----------------------------------------------------------------------------------- debug tests
@@ -54,79 +229,371 @@ namespace debug {
         for (auto& it: Tests) it.second.run();
     }
 
-    TString ReportText()
+    namespace {
+
+        // status block of RunAllTest(TProgressOptions), redrawn by its own thread
+        class TProgressLine
+        {
+        public:
+            using TClock = ::std::chrono::steady_clock;
+
+            TProgressLine(size_t total, unsigned workers, unsigned fps)
+                : _total   (total)
+                , _workers (workers)
+                , _start   (TClock::now())
+                , _period  (::std::chrono::microseconds(1000000 / ::std::max(fps, 1u)))
+                , _terminal(console::IsTerminalOutput())
+                , _tab0    (console::tab_width(0))
+                , _tab1    (console::tab_width(1))
+            {
+                if (_terminal) _thread = ::std::thread([this] { redraw_loop(); });
+            }
+
+            ~TProgressLine()
+            {
+                {
+                    ::std::lock_guard lock(_mtx);
+                    _stop = true;
+                }
+                _cv.notify_one();
+                if (_thread.joinable()) _thread.join();
+
+                ::std::unique_lock lock(_mtx);
+                auto frame = compose(true);
+                lock.unlock();
+                frame += '\n';
+                console::WriteOutput(frame);
+            }
+
+            void started(unsigned worker, TString const& name)
+            {
+                ::std::lock_guard lock(_mtx);
+                _workers[worker] = { name, TClock::now() };
+            }
+
+            void finished(unsigned worker, bool failed)
+            {
+                ::std::lock_guard lock(_mtx);
+                _workers[worker].name.clear();
+                ++_done;
+                if (failed) ++_failed;
+            }
+
+        private:
+            struct TWorker
+            {
+                TString            name{};
+                TClock::time_point since{};
+            };
+
+            ::std::mutex              _mtx{};
+            ::std::condition_variable _cv{};
+            bool                      _stop = false;
+
+            size_t               _total;
+            size_t               _done   = 0;
+            size_t               _failed = 0;
+            ::std::vector<TWorker> _workers;
+            TClock::time_point   _start;
+            TClock::duration     _period;
+
+            bool _terminal;
+            int  _tab0, _tab1;      // tab widths of the calling thread, they are thread_local
+            int  _shown_lines = 0;  // lines of the block on the screen
+            ::std::string _shown{}; // last written block
+
+            ::std::thread _thread{};
+
+            static TString clock_text(TClock::duration duration)
+            {
+                auto sec = ::std::chrono::duration_cast<::std::chrono::seconds>(duration).count();
+                TString text;
+                format_to(text, SIB_DEGUG_LITERAL("{}:{:02}"), sec / 60, sec % 60);
+                return text;
+            }
+
+            // cut to the terminal width, a wrapped line would break the rewind
+            static void append_line(::std::string& out, ::std::string_view line, int width)
+            {
+                size_t end = 0;
+                for (int cols = 0; end < line.size(); ++end)
+                {
+                    if ((static_cast<unsigned char>(line[end]) & 0xC0) == 0x80) continue;
+                    if (cols++ == width) break;
+                }
+                out.append(line.substr(0, end));
+            }
+
+            // under _mtx
+            ::std::string compose(bool final)
+            {
+                auto now   = TClock::now();
+                int  width = console::TerminalWidth() - 1;
+
+                TBufer status;
+                status << ::std::left << ::std::setw(_tab0 + _tab1)
+                       << TString(_done, "/", _total)
+                       << "failed: " << _failed;
+                if (final)
+                    status << "   time: " << clock_text(now - _start);
+                else if (_done > 0 and _done < _total)
+                    status << "   eta: " << clock_text((now - _start) * (_total - _done) / _done);
+
+                ::std::string frame;
+                int lines = 1;
+                append_line(frame, status.view(), width);
+                if (not final)
+                {
+                    for (size_t i = 0; i < _workers.size(); ++i)
+                    {
+                        auto& worker = _workers[i];
+                        TBufer line;
+                        line << ::std::left
+                             << ::std::setw(_tab0) << TString("#", i + 1)
+                             << ::std::setw(_tab1) << (worker.name.empty() ? TString() : clock_text(now - worker.since))
+                             << worker.name;
+                        frame += '\n';
+                        append_line(frame, line.view(), width);
+                        ++lines;
+                    }
+                }
+
+                if (not _terminal) return frame;
+
+                ::std::string out;
+                if (_shown_lines) console::AppendRewind(out, _shown_lines - 1);
+                out += frame;
+                _shown_lines = lines;
+                return out;
+            }
+
+            void redraw_loop()
+            {
+                ::std::unique_lock lock(_mtx);
+                for (auto next = TClock::now(); not _stop; )
+                {
+                    auto frame = compose(false);
+                    lock.unlock();
+                    if (frame != _shown)
+                    {
+                        console::WriteOutput(frame);
+                        _shown = ::std::move(frame);
+                    }
+                    lock.lock();
+
+                    // the cap: one frame per period whatever the tests do
+                    next += _period;
+                    _cv.wait_until(lock, next, [this] { return _stop; });
+                }
+            }
+        };
+
+        bool has_errors(TTest const& test)
+        {
+            return ::std::any_of(test.log().begin(), test.log().end(),
+                [](TTestLogRec const& rec) { return rec.type == TTestLogType::error; });
+        }
+
+    } // namespace
+
+    void RunAllTest(TProgressOptions const& progress, ::std::map<TString, TTest>& tests /* = Tests */)
     {
-        TBufer buf;
-        TString border = "********************************************************************************************************\n";
-        buf << border << "                                                REPORT                                                  \n";
-        for (auto test_it : Tests)
-        {
-            buf << border;
-            buf << "  TEST: " << test_it.first << "\n";
-            auto& test = test_it.second;
-
-            switch (test.state()) {
-            case TTestState::NotInitialized: buf << "  Not initialized" << "\n"; break;
-            case TTestState::NotCompleted  : buf << "  Not completed"   << "\n"; break;
-            case TTestState::Completed     : buf << "  Completed"       << "\n"; break;
-            default: buf << "  Unknown state" << "\n";
+        ::std::basic_ofstream<OutStrmCh, OutStrmTr> transcript(progress.transcript_path);
+        if (not transcript) throw EDebug(TString("Cannot open the transcript file: ", progress.transcript_path));
+
+        ::std::basic_ostream<OutStrmCh, OutStrmTr>* outer_sink;
+        {
+            ::std::lock_guard lock(mtx);
+            outer_sink = ::std::exchange(transcript_sink, &transcript);
+        }
+        SIB_SCOPE_GUARD(
+            ::std::lock_guard lock(mtx);
+            transcript_sink = outer_sink;
+        );
+
+        auto break_level = current_break_level;
+        current_break_level = BP_NONE;
+        SIB_SCOPE_GUARD( current_break_level = break_level; );
+
+        ::std::vector<decltype(Tests)::value_type*> queue;
+        for (auto& it : tests) queue.push_back(&it);
+
+        auto workers = static_cast<unsigned>(::std::clamp<size_t>(progress.workers, 1, ::std::max<size_t>(queue.size(), 1)));
+
+        // outstream output of the run is lost behind the status block otherwise
+        outstream.flush();
+
+        TProgressLine line(queue.size(), workers, progress.fps);
+
+        ::std::atomic<size_t> next = 0;
+        auto tab_def = console::TAB_DEF_WIDTH;
+        auto tabs    = console::TAB_WIDTH;
+
+        auto work = [&](unsigned worker)
+        {
+            console::TAB_DEF_WIDTH = tab_def;
+            console::TAB_WIDTH     = tabs;
+            for (size_t i; (i = next++) < queue.size(); )
+            {
+                auto& [name, test] = *queue[i];
+                line.started(worker, name);
+                TString header("******** TEST: ", name, "\n");
+                if (workers == 1)
+                {
+                    under_lock_print(header);
+                    test.run();
+                }
+                else
+                {
+                    // tests running at the same time would mix their lines under one header
+                    TBufer block;
+                    block << header;
+                    {
+                        auto outer_block = ::std::exchange(test_transcript, &block);
+                        SIB_SCOPE_GUARD( test_transcript = outer_block; );
+                        test.run();
+                    }
+                    under_lock_print(block.view());
+                }
+                line.finished(worker, has_errors(test));
             }
+        };
 
-            int l = 0, m = 0, w = 0, e = 0;
-            buf << "  ---------------------------------------------------\n"
-                << "  | Type     | Blok | Line | Description\n"
-                << "  ---------------------------------------------------\n";
-            for (auto rec_it : test.log()) {
-                auto mes = rec_it.united_message();
-                buf << mes;
-                if (*mes.rbegin() != '\n') buf << "\n";
+        ::std::vector<::std::thread> threads;
+        for (unsigned worker = 1; worker < workers; ++worker) threads.emplace_back(work, worker);
+        work(0);
+        for (auto& thread : threads) thread.join();
+    }
+
+    namespace {
+
+        using TView = ::std::basic_string_view<OutStrmCh, OutStrmTr>;
+
+        // "  | Type     | Blok | Line | Description"
+        table_layout<TString> const& log_layout()
+        {
+            static table_layout<TString> const layout({ { 8 }, { 4 }, { 4 }, {} }, SIB_DEGUG_LITERAL("  | "), SIB_DEGUG_LITERAL(" | "));
+            return layout;
+        }
+
+        // empty for 0
+        TView number_cell(OutStrmCh (&buf)[24], size_t num)
+        {
+            size_t len = 0;
+            for (; num; num /= 10) buf[23 - len++] = OutStrmCh('0' + num % 10);
+            return { buf + 24 - len, len };
+        }
+
+        template <typename Func>
+        void for_log_row(TTestLogRec const& rec, Func&& func)
+        {
+            OutStrmCh beg[24], lin[24];
+            func({ TView(test_log_type_name[static_cast<int>(rec.type)]), number_cell(beg, rec.beg_num), number_cell(lin, rec.lin_num), TView(rec.description) });
+        }
+
+    } // namespace
+
+    TRope ReportRope()
+    {
+        auto& layout = log_layout();
+
+        static TString const border       = "********************************************************************************************************\n";
+        static TString const line         = "--------------------------------------------------------------------------------------------------------\n";
+        static TString const title        = "                                                REPORT                                                  \n";
+        static TString const header       = "  ---------------------------------------------------\n"
+                                            "  | Type     | Blok | Line | Description\n"
+                                            "  ---------------------------------------------------\n";
+        static TString const divider      = "  ---------------------------------------------------\n";
+        static TString const test_title   = "  TEST: ";
+        static TString const timers_title = "  SCOPE TIMERS\n";
+        static TString const states[]     = { "  Not initialized\n", "  Not completed\n", "  Completed\n", "  Unknown state\n" };
+
+        // constant parts, test names and log descriptions are borrowed; only the row heads and counts are copied
+        size_t chunks = 5;
+        for (auto const& [name, tst] : Tests) chunks += 8 + 3 * tst.log().size();
+
+        TRope res;
+        res.reserve_chunks(chunks);
+        res.append_borrowed(border);
+        res.append_borrowed(title);
+
+        TString const* sep = &border;
+        TString        head;
+        for (auto const& [name, tst] : Tests)
+        {
+            res.append_borrowed(*sep);
+            res.append_borrowed(test_title);
+            res.append_borrowed(TView(name));
+            res.push_back(OutStrmCh('\n'));
+
+            switch (tst.state()) {
+            case TTestState::NotInitialized: res.append_borrowed(states[0]); break;
+            case TTestState::NotCompleted  : res.append_borrowed(states[1]); break;
+            case TTestState::Completed     : res.append_borrowed(states[2]); break;
+            default: res.append_borrowed(states[3]);
+            }
+
+            size_t l = 0, m = 0, w = 0, e = 0;
+            res.append_borrowed(header);
+            for (auto const& rec : tst.log()) {
+                for_log_row(rec, [&](::std::initializer_list<TView> cells) {
+                    head.clear();
+                    layout.append_head(head, cells);
+                    res.append(TView(head));
+                    layout.for_last_cell(cells.end()[-1], [&](TView piece) { res.append_borrowed(piece); });
+                    res.push_back(OutStrmCh('\n'));
+                });
                 ++l;
-                switch (rec_it.type) {
+                switch (rec.type) {
                     case TTestLogType::message: ++m; break;
                     case TTestLogType::warning: ++w; break;
                     case TTestLogType::error  : ++e; break;
                 }
             }
-            buf << "  ---------------------------------------------------\n";
-            buf << "  log count: " << l
-                << "  messages: "  << m
-                << "  warnings: "  << w
-                << "  errors: "    << e
-                << "\n";
+            res.append_borrowed(divider);
+            head.clear();
+            format_to(head, SIB_DEGUG_LITERAL("  log count: {}  messages: {}  warnings: {}  errors: {}\n"), l, m, w, e);
+            res.append(TView(head));
 
-            border = "--------------------------------------------------------------------------------------------------------\n";
+            sep = &line;
         }
-        buf << "********************************************************************************************************\n";
-        return buf.str();
+
+        if (TString timers(::sib::scope_timers_text()); not timers.empty())
+        {
+            res.append_borrowed(*sep);
+            res.append_borrowed(timers_title);
+            res.append(::std::move(timers));
+        }
+
+        res.append_borrowed(border);
+        return res;
     }
 
+    TString ReportText()
+    {
+        return ReportRope().str();
+    }
+
+    void PrintReport()
+    {
+        auto report = ReportRope();
+        report.push_back(OutStrmCh('\n'));
+        under_lock_print(report);
+    }
+
+
 
-    
     // ----------------------------------------------------------------------------------- TTestLogRec
 
     TString TTestLogRec::united_message() const
     {
-        TBufer res;
-        auto tidx = static_cast<int>(type);
-        res << std::left
-            << "  | "
-            << std::setw(8) << test_log_type_name[tidx]
-            << " | "
-            << std::setw(4) << (beg_num ? TString(beg_num) : TString())
-            << " | "
-            << std::setw(4) << (lin_num ? TString(lin_num) : TString())
-            << " | ";
-
-        if (!description.empty())
-        {
-            auto last = std::prev(description.end());
-            for (auto it = description.begin(); it != description.end(); ++it) {
-                res << *it;
-                if ((*it != '\n') or (it == last)) continue;
-                res << "  |          |      |      | ";
-            }
-        }
-        return res.str();
+        TString res;
+        for_log_row(*this, [&](::std::initializer_list<TView> cells) {
+            res.reserve(log_layout().row_size(cells));
+            log_layout().append_row(res, cells);
+        });
+        if (description.empty() or description.back() != '\n') res.pop_back(); // the new line of the row
+        return res;
     }
 
 
@@ -145,6 +612,14 @@ namespace debug {
     
     void TTest::run()
     {
+        // a test that runs tests of its own (as the runner tests do) gets its counters back after them
+        auto outer = ::std::tuple(detail::beg_accum, detail::lin_accum, detail::nes_accum,
+                                  detail::current_log, detail::block_file, detail::block_line);
+        SIB_SCOPE_GUARD(
+            ::std::tie(detail::beg_accum, detail::lin_accum, detail::nes_accum,
+                       detail::current_log, detail::block_file, detail::block_line) = outer;
+        );
+
         _state = TTestState::NotInitialized;
         try
         {   
@@ -155,6 +630,9 @@ namespace debug {
             detail::lin_accum = 0;
             detail::nes_accum = 0;
 
+            detail::current_log = &_log;
+            detail::block_file  = nullptr;
+
             //::sib::debug::detail::output_bufer
             //    << "****************************************************************************************************"
             //    <<             MSG("                                            sib_console                                             ");
@@ -182,19 +660,176 @@ namespace debug {
     }
     
 
+    namespace detail {
+
+        // " (file.cpp:123)" for log records
+        static TString location(TMacroSite const & site)
+        {
+            ::std::string_view file = site.loc.file_name();
+            auto slash = file.find_last_of("/\\");
+            if (slash != ::std::string_view::npos) file.remove_prefix(slash + 1);
+            return TString(" (", file, ":", site.loc.line(), ")");
+        }
+
+    } // namespace detail
+
+    // ----------------------------------------------------------------------------------- performance budgets
+
+    double perf_calibration()
+    {
+        if (PERF_CALIBRATION > 0) return PERF_CALIBRATION;
+
+        if (auto env = ::std::getenv("SIB_PERF_CALIBRATION"))
+        {
+            double val = ::std::atof(env);
+            if (val > 0) return PERF_CALIBRATION = val;
+        }
+
+        // reference workload: dependent chain of integer multiply-add (LCG)
+        ::std::uint64_t x = 1;
+        auto measure = detail::perf_measure([&]() {
+            for (int i = 0; i < 16; ++i) x = x * 6364136223846793005ull + 1442695040888963407ull;
+            do_not_optimize(x);
+        });
+
+        return PERF_CALIBRATION = measure.ns_per_op / 16 / PERF_REFERENCE_NS;
+    }
+
+    namespace detail {
+
+        long long alloc_count() noexcept
+        {
+            #ifndef SIB_DEBUG_NO_ALLOC_COUNTER
+                return alloc_accum;
+            #else
+                return -1;
+            #endif
+        }
+
+        #if defined(__linux__)
+
+            TInstrCounter::TInstrCounter()
+            {
+                perf_event_attr attr{};
+                attr.type           = PERF_TYPE_HARDWARE;
+                attr.size           = sizeof(attr);
+                attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+                attr.disabled       = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv     = 1;
+                _fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+
+            TInstrCounter::~TInstrCounter() { if (_fd >= 0) ::close(_fd); }
+
+            bool TInstrCounter::available() const noexcept { return _fd >= 0; }
+
+            void TInstrCounter::start() noexcept
+            {
+                if (_fd < 0) return;
+                ::ioctl(_fd, PERF_EVENT_IOC_RESET , 0);
+                ::ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+
+            long long TInstrCounter::stop() noexcept
+            {
+                if (_fd < 0) return -1;
+                ::ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+                long long cnt = 0;
+                if (::read(_fd, &cnt, sizeof(cnt)) != sizeof(cnt)) return -1;
+                return cnt;
+            }
+
+        #else
+
+            TInstrCounter::TInstrCounter() {}
+            TInstrCounter::~TInstrCounter() {}
+            bool TInstrCounter::available() const noexcept { return false; }
+            void TInstrCounter::start() noexcept {}
+            long long TInstrCounter::stop() noexcept { return -1; }
+
+        #endif
+
+        void prf_macro(TTestLog & log, TMacroSite const & site, TPerfBudget const & budget, TPerfMeasure const & measure)
+        {
+            double calibration = (budget.ns_per_op < 0) ? 1.0 : perf_calibration();
+
+            bool    pass = true;
+            TBufer  values;
+            TBufer  violations;
+            values << ::std::fixed << ::std::setprecision(2);
+            violations << ::std::fixed << ::std::setprecision(2);
+
+            values << measure.ns_per_op << " ns/op";
+            if (budget.ns_per_op >= 0)
+            {
+                double limit = budget.ns_per_op * calibration;
+                values << " (budget " << limit << ")";
+                if (measure.ns_per_op > limit)
+                {
+                    pass = false;
+                    violations << "\n" << measure.ns_per_op << " ns/op > " << limit
+                               << " ns/op (" << budget.ns_per_op << " x" << calibration << " calibration)";
+                }
+            }
+
+            auto check = [&](double val, double limit, char const * unit) {
+                if (val < 0)
+                {
+                    values << ", " << unit << " n/a";
+                    if (limit >= 0)
+                    {
+                        log.emplace_back(TTestLogType::warning, BEG_ACCUM, LIN_ACCUM,
+                            TString("Performance budget not checked: ", unit, " counter is not available"));
+                    }
+                    return;
+                }
+                values << ", " << val << " " << unit;
+                if (limit < 0) return;
+                values << " (budget " << limit << ")";
+                if (val > limit)
+                {
+                    pass = false;
+                    violations << "\n" << val << " " << unit << " > " << limit << " " << unit;
+                }
+            };
+            check(measure.allocs_per_op, budget.allocs_per_op, "allocs/op");
+            check(measure.instr_per_op , budget.instr_per_op , "instr/op" );
+
+            output_bufer << (pass ? "[pass] PERF(" : "[FAIL] PERF(") << site.text << ") " << values.view();
+
+            if (pass)
+            {
+                log.emplace_back(TTestLogType::message, BEG_ACCUM, LIN_ACCUM,
+                    TString("Performance budget: ", values.view()));
+            }
+            else
+            {
+                log.emplace_back(TTestLogType::error, BEG_ACCUM, LIN_ACCUM,
+                    TString("Performance budget exceeded", location(site), ":", violations.view()));
+                stop_macro(STOP_FLAG_ASSERTION_FAIL, "\n    - performance budget exceeded -");
+            }
+
+            finish_macro(BP_ALL);
+        }
+
+    } // namespace detail
+
+
+
     // ----------------------------------------------------------------------------------- debugging step by step
     
     console::TKeyCode SetBreakPoint(TBreakPointLevel bp_level /*= BP_CUSTOM*/, TString msg /*= {}*/)
     {
+        if (current_break_level > bp_level) return console::KC_EMPTY;
+        if (current_break_level == BP_END and bp_level == BP_BEGIN) return console::KC_EMPTY;
+
         ::std::set<::sib::console::TKeyCode> debugging_keys;
         for (auto it = debugging_reactions_to_keys.begin(); it != debugging_reactions_to_keys.end(); ++it)
         {
             debugging_keys.insert(it->first);
         }
         
-        if (current_break_level > bp_level) return console::KC_EMPTY;
-        if (current_break_level == BP_END and bp_level == BP_BEGIN) return console::KC_EMPTY;
-        
         if (bp_level == BP_CUSTOM)
         {
             if (msg != TString()) { under_lock_print(msg + TString("\n")); }
@@ -213,7 +848,7 @@ namespace debug {
                 }
                 buf << "\n";
 
-                under_lock_print(buf.str());
+                under_lock_print(buf.view());
             }
         }
         
@@ -226,7 +861,7 @@ namespace debug {
     namespace detail {
 
         void start_macro(
-            TString const & prefix,
+            char const * prefix,
             bool new_lin                   /* = true    */,
             bool brk_lin                   /* = false   */,
             char const * nesting_error_msg /* = nullptr */)
@@ -252,7 +887,7 @@ namespace debug {
 
         void to_drop_bufer()
         {
-            under_lock_print(output_bufer.str());
+            under_lock_print(output_bufer.view());
             output_bufer.str({});
             output_bufer.clear();
         }
@@ -286,6 +921,148 @@ namespace debug {
             lin_accum = 0;
         }
 
+        // ------------------------------------------------------------------- static assertion registry
+
+        struct TStaticChecks
+        {
+            ::std::vector<TStaticCheck> checks;
+            ::std::once_flag            sorted;
+        };
+
+        static TStaticChecks & static_checks()
+        {
+            static TStaticChecks reg;
+            return reg;
+        }
+
+        bool register_static_check(TStaticCheck const & check)
+        {
+            static_checks().checks.push_back(check);
+            return true;
+        }
+
+        static bool static_check_less(TStaticCheck const & a, TStaticCheck const & b)
+        {
+            if (int cmp = ::std::strcmp(a.file, b.file)) return cmp < 0;
+            if (a.line != b.line) return a.line < b.line;
+            return ::std::strcmp(a.text, b.text) < 0;
+        }
+
+        // Checks of the file with lines in (first, last], in source order.
+        static ::std::span<TStaticCheck const> static_checks_between(char const * file, unsigned first, unsigned last)
+        {
+            auto & reg = static_checks();
+            ::std::call_once(reg.sorted, [&reg]
+            {
+                // the same SAS in a template gives one site per instantiation
+                ::std::sort(reg.checks.begin(), reg.checks.end(), static_check_less);
+                reg.checks.erase(::std::unique(reg.checks.begin(), reg.checks.end(),
+                    [](TStaticCheck const & a, TStaticCheck const & b)
+                    { return not static_check_less(a, b) and not static_check_less(b, a); }),
+                    reg.checks.end());
+            });
+            auto beg = ::std::lower_bound(reg.checks.begin(), reg.checks.end(), TStaticCheck{ "", file, first + 1 }, static_check_less);
+            auto end = ::std::lower_bound(beg, reg.checks.end(), TStaticCheck{ "", file, last + 1 }, static_check_less);
+            return { beg, end };
+        }
+
+        static void report_static_checks(::std::source_location const & loc)
+        {
+            if (not current_log or not block_file or static_checks().checks.empty()) return;
+            if (::std::strcmp(block_file, loc.file_name()) != 0 or block_line > loc.line()) return;
+
+            auto checks = static_checks_between(block_file, block_line, loc.line());
+            for (auto const & check : checks)
+            {
+                start_macro("a");
+                output_bufer << "[pass] SAS(" << check.text << ")";
+                finish_macro(BP_ALL);
+            }
+            if (not checks.empty())
+                current_log->emplace_back(TTestLogType::message, beg_accum, lin_accum,
+                    TString("Static assertions passed: ", checks.size()));
+        }
+
+        void beg_macro(::std::source_location const & loc)
+        {
+            start_macro("b", false, false, "BEG is nested in another sib::debug macro.");
+            new_begin();
+            output_bufer
+                << "---------------------------------------------------------------------------------------------- "
+                << BEG_ACCUM;
+            finish_macro(BP_BEGIN);
+            block_file = loc.file_name();
+            block_line = loc.line();
+        }
+
+        void end_macro(::std::source_location const & loc)
+        {
+            report_static_checks(loc);
+            block_file = loc.file_name();
+            block_line = loc.line();
+            start_macro("e", false, false, "AND is nested in another sib::debug macro.");
+            finish_macro(BP_END);
+        }
+
+        void msg_macro(TString const & msg)
+        {
+            output_bufer << msg;
+            finish_macro(BP_ALL);
+        }
+
+        void exe_macro(TMacroSite const & site)
+        {
+            start_macro("x");
+            output_bufer << site.text;
+            finish_macro(BP_ALL);
+        }
+
+        void typ_macro(TMacroSite const & site, ::std::string const & type)
+        {
+            start_macro("p");
+            if (not nes_accum) output_bufer << site.text;
+            output_bufer << " -> " << type;
+            finish_macro(BP_ALL);
+        }
+
+        void ass_macro(TTestLog & log, TMacroSite const & site, bool val)
+        {
+            if (val)
+            {
+                output_bufer << "[pass] ASSERT(" << site.text << ")";
+            }
+            else
+            {
+                output_bufer << "[FAIL] ASSERT(" << site.text << ")";
+                log.emplace_back(TTestLogType::error, beg_accum, lin_accum, TString("Assertion fail", location(site)));
+                stop_macro(STOP_FLAG_ASSERTION_FAIL, "\n    - assertion fail -");
+            }
+            finish_macro(BP_ALL);
+        }
+
+        void ass_macro(TTestLog & log, TMacroSite const & site, error_tag)
+        {
+            output_bufer
+                << "[ERROR] ASSERT(" << site.text << ") "
+                << "Assertion statement is not convertible to bool";
+            log.emplace_back(TTestLogType::error, beg_accum, lin_accum,
+                TString("Assertion error (statement is not convertible to bool)", location(site)));
+            stop_macro(STOP_FLAG_ASSERTION_ERROR, "\n    - assertion error -");
+            finish_macro(BP_ALL);
+        }
+
+        void prn_macro(TMacroSite const & site, TString const & val, ::std::string const & type)
+        {
+            output_bufer << site.text << " = " << val << " -> " << type;
+            finish_macro(BP_ALL);
+        }
+
+        void pas_macro(TMacroSite const & site, TString const & val, char const * type)
+        {
+            output_bufer << site.text << " ~ " << val << " -> " << type;
+            finish_macro(BP_ALL);
+        }
+
     } // namespace detail
 
     thread_local unsigned const & BEG_ACCUM = detail::beg_accum;
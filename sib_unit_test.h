@@ -8,11 +8,21 @@
 #include <string>
 #include <type_traits>
 #include <functional>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <source_location>
+#include <bit>
+#include <charconv>
+#include <ranges>
 
 #include "sib_type_info.h"
 #include "sib_type_traits.h"
 #include "sib_console.h"
 #include "sib_string.h"
+#include "sib_rope.h"
+#include "sib_utf.h"
 
 namespace sib {
 namespace debug {
@@ -40,38 +50,148 @@ namespace debug {
 
     using TBufer  = ::sib::promiscuous_stringstream <OutStrmCh, OutStrmTr>;
     using TString = ::sib::promiscuous_string       <OutStrmCh, OutStrmTr>;
+    using TStringView = ::std::basic_string_view<OutStrmCh, OutStrmTr>;
+    using TRope   = ::sib::promiscuous_rope         <OutStrmCh, OutStrmTr>;
 
 
     
     // Преобразование символов в строку, для вывода в outstream
     //   - управляющие символы выводятся как \<ESC> (<ESC> — символ, обозначающий Escape sequences)
-    //   - символы в диапазоне OutStrmCh выводятся как есть
+    //   - печатаемые символы ASCII выводятся как есть
+    //   - целые кодовые точки от U+00A0 (не часть UTF-8 и не суррогат) перекодируются в OutStrmCh
     //   - остальные выводятся как \i<NUM> (<NUM> — числовое значение по основанию 10)
     template <Char Ch>
-    inline TString bufer_char_to_str(Ch ch)
+    inline void append_bufer_char(TString& out, Ch ch)
     {
+        auto put = [&out](::std::string_view text) { append_transcoded(out, text); };
+
         switch (ch)
         {
-            case '\0': return "\\0" ; // Null character
-            case '\a': return "\\a" ; // Alert (bell)
-            case '\b': return "\\b" ; // Backspace
-            case '\t': return "\\t" ; // Horizontal tab
-            case '\n': return "\\n" ; // New line
-            case '\v': return "\\v" ; // Vertical tab
-            case '\f': return "\\f" ; // Form feed
-            case '\r': return "\\r" ; // Carriage return
-            case  27 : return "\\e" ; // Escape
-            case '\\': return "\\\\"; // Backslash
-            case '\"': return "\\\""; // Double quote
+            case '\0': put("\\0" ); return; // Null character
+            case '\a': put("\\a" ); return; // Alert (bell)
+            case '\b': put("\\b" ); return; // Backspace
+            case '\t': put("\\t" ); return; // Horizontal tab
+            case '\n': put("\\n" ); return; // New line
+            case '\v': put("\\v" ); return; // Vertical tab
+            case '\f': put("\\f" ); return; // Form feed
+            case '\r': put("\\r" ); return; // Carriage return
+            case  27 : put("\\e" ); return; // Escape
+            case '\\': put("\\\\"); return; // Backslash
+            case '\"': put("\\\""); return; // Double quote
         }
 
-        auto sch = static_cast<OutStrmCh>(ch);
-        if ((static_cast<Ch>(sch) == ch) and (isprint(ch)))
+        // печатаемые символы ASCII — 0x20..0x7E, как isprint в любой ASCII-совместимой локали
+        auto code = ::sib::detail::code_unit(ch);
+        if (code >= 0x20 and code < 0x7F)
+        {
+            out.push_back(static_cast<OutStrmCh>(ch));
+            return;
+        }
+        if (code >= 0xA0 and is_whole_code_point(ch))
         {
-            return sch;
+            append_transcoded(out, ::std::basic_string_view<Ch>(&ch, 1));
+            return;
+        }
+
+        char num[16];
+        put("\\i");
+        put({ num, static_cast<size_t>(::std::to_chars(num, num + sizeof(num), static_cast<unsigned>(ch)).ptr - num) });
+    }
+
+    template <Char Ch>
+    inline TString bufer_char_to_str(Ch ch)
+    {
+        TString str;
+        append_bufer_char(str, ch);
+        return str;
+    }
+
+    namespace detail {
+
+        // Длина начального участка символов, которые append_bufer_char выводит как есть.
+        // Проверяется по 16 байт (SSE2) или по 32 байта (AVX2) за шаг.
+        template <Char Ch>
+        inline size_t plain_bufer_run(Ch const* ptr, size_t len) noexcept
+        {
+            size_t i = 0;
+        #if SIB_UTF_AVX2
+            if constexpr (sizeof(Ch) == 1)
+            {
+                __m256i const low   = _mm256_set1_epi8(0x20);
+                __m256i const del   = _mm256_set1_epi8(0x7F);
+                __m256i const slash = _mm256_set1_epi8('\\');
+                __m256i const quote = _mm256_set1_epi8('"');
+                for (; i + 32 <= len; i += 32)
+                {
+                    __m256i v   = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr + i));
+                    __m256i bad = _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpgt_epi8(low, v), _mm256_cmpeq_epi8(v, del)),   // < 0x20 и >= 0x80 (со знаком), 0x7F
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, slash), _mm256_cmpeq_epi8(v, quote)));
+                    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(bad));
+                    if (mask) return i + static_cast<size_t>(::std::countr_zero(mask));
+                }
+            }
+        #endif
+        #if SIB_UTF_SSE2
+            {
+                auto set = [](int value) {
+                    if constexpr (sizeof(Ch) == 1) return _mm_set1_epi8 (static_cast<char >(value));
+                    if constexpr (sizeof(Ch) == 2) return _mm_set1_epi16(static_cast<short>(value));
+                    if constexpr (sizeof(Ch) == 4) return _mm_set1_epi32(value);
+                };
+                auto lt = [](__m128i a, __m128i b) {
+                    if constexpr (sizeof(Ch) == 1) return _mm_cmplt_epi8 (a, b);
+                    if constexpr (sizeof(Ch) == 2) return _mm_cmplt_epi16(a, b);
+                    if constexpr (sizeof(Ch) == 4) return _mm_cmplt_epi32(a, b);
+                };
+                auto eq = [](__m128i a, __m128i b) {
+                    if constexpr (sizeof(Ch) == 1) return _mm_cmpeq_epi8 (a, b);
+                    if constexpr (sizeof(Ch) == 2) return _mm_cmpeq_epi16(a, b);
+                    if constexpr (sizeof(Ch) == 4) return _mm_cmpeq_epi32(a, b);
+                };
+                __m128i const low   = set(0x20);
+                __m128i const high  = set(0x7F);
+                __m128i const slash = set('\\');
+                __m128i const quote = set('"');
+                constexpr size_t step = 16 / sizeof(Ch);
+                for (; i + step <= len; i += step)
+                {
+                    // со знаком: всё, что >= 0x80 (0x8000, 0x80000000), тоже меньше 0x20
+                    __m128i v   = _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + i));
+                    __m128i bad = _mm_or_si128(
+                        _mm_or_si128(lt(v, low), _mm_xor_si128(lt(v, high), _mm_set1_epi8(-1))),
+                        _mm_or_si128(eq(v, slash), eq(v, quote)));
+                    auto mask = static_cast<unsigned>(_mm_movemask_epi8(bad));
+                    if (mask) return i + static_cast<size_t>(::std::countr_zero(mask)) / sizeof(Ch);
+                }
+            }
+        #endif
+            for (; i < len; ++i)
+            {
+                auto code = ::sib::detail::code_unit(ptr[i]);
+                if (code < 0x20 or code >= 0x7F or code == '\\' or code == '"') break;
+            }
+            return i;
+        }
+
+    } // namespace detail
+
+    // То же, что bufer_char_to_str для каждого символа подряд; чистые участки копируются целиком.
+    template <Char Ch>
+    inline void append_bufer_chars(TString& out, ::std::basic_string_view<Ch> text)
+    {
+        size_t pos = 0;
+        while (pos < text.size())
+        {
+            size_t run = detail::plain_bufer_run(text.data() + pos, text.size() - pos);
+            if (run)
+            {
+                append_transcoded(out, text.substr(pos, run));
+                pos += run;
+                if (pos == text.size()) break;
+            }
+            append_bufer_char(out, text[pos++]);
         }
-                   
-        return "\\i" + ::std::to_string(static_cast<unsigned>(ch));
     }
 
 
@@ -97,28 +217,34 @@ namespace debug {
 
                 if constexpr (is_like_string_v<T>) {
 
-                    if (std::size(val) == 0)
+                    if (::std::begin(val) == ::std::end(val))
                     {
                         return "\"\"";
                     }
                     else
                     {
-                        TBufer data;
-                        data << "\"";
-                        auto begin = ::std::begin(val);
-                        auto end   = ::std::end  (val);
-                        size_t counter = 1;
-                        for (auto it = begin; it != end; ++it, ++counter)
+                        TString data;
+                        data.push_back('"');
+                        bool more = false;
+                        if constexpr (::std::ranges::contiguous_range<T const> and ::std::ranges::sized_range<T const>)
                         {
-                            if (counter > CONTAINER_DISCLOSURE_LENGTH)
-                            {
-                                data << "...";
-                                return data.str();
-                            }
-                            data << bufer_char_to_str(*it);
+                            using Src = ::std::remove_cvref_t<::std::ranges::range_reference_t<T const>>;
+                            size_t count = ::std::ranges::size(val);
+                            size_t shown = (count > CONTAINER_DISCLOSURE_LENGTH) ? CONTAINER_DISCLOSURE_LENGTH : count;
+                            data.reserve(shown + 5);
+                            append_bufer_chars(data, ::std::basic_string_view<Src>(::std::ranges::data(val), shown));
+                            more = count > shown;
                         }
-                        data << "\"";
-                        return data.str();
+                        else
+                        {
+                            // без размера (forward_list<char> и т. п.) - по одному символу
+                            auto it  = ::std::begin(val);
+                            auto end = ::std::end  (val);
+                            for (size_t i = 0; i < CONTAINER_DISCLOSURE_LENGTH and it != end; ++i, ++it) append_bufer_char(data, *it);
+                            more = it != end;
+                        }
+                        append_transcoded(data, more ? ::std::string_view("...") : ::std::string_view("\""));
+                        return data;
                     }
 
                 } else {
@@ -216,7 +342,8 @@ namespace debug {
         }
     };
 
-    void under_lock_print(TString const& str);
+    void under_lock_print(TStringView str);
+    void under_lock_print(TRope const& text);
     
     
     
@@ -287,8 +414,144 @@ namespace debug {
 
     void RunAllTest();
 
+    /*
+        Long runs: the transcript goes to a file and the terminal only shows a live status -
+        done / total, failures, ETA and the current test of every worker - redrawn from a
+        background thread not more often than `fps` times a second. Without a terminal on
+        stdout only the final status line is printed.
+        Break points are off for the run, nobody is expected at the keyboard.
+        workers > 1 runs tests in parallel, only for tests that do not share process state
+        (stdin, current directory, etc); the transcript of each test is then written as one
+        block when it finishes.
+    */
+    struct TProgressOptions
+    {
+        TString  transcript_path = "test_transcript.log";
+        unsigned workers         = 1;
+        unsigned fps             = 20;
+    };
+
+    void RunAllTest(TProgressOptions const& progress, ::std::map<TString, TTest>& tests = Tests);
+
+    // The report over all tests. The rope borrows the test names and logs - it is valid until the tests change.
+    TRope ReportRope();
+
+    // ReportRope flattened into one string
     TString ReportText();
 
+    // ReportRope and a new line to outstream; stdout gets all the chunks in one scatter-gather write
+    void PrintReport();
+
+
+
+// ----------------------------------------------------------------------------------- performance budgets
+
+    // Limits per one execution of the measured block, a negative value - not limited.
+    // Usage: TPerfBudget().ns(5).allocs(0)
+    struct TPerfBudget
+    {
+        double ns_per_op     = -1; // median time, scaled by perf_calibration()
+        double allocs_per_op = -1; // calls of the global operator new
+        double instr_per_op  = -1; // retired instructions (Linux perf events only)
+
+        constexpr TPerfBudget& ns    (double val) noexcept { ns_per_op     = val; return *this; }
+        constexpr TPerfBudget& allocs(double val) noexcept { allocs_per_op = val; return *this; }
+        constexpr TPerfBudget& instr (double val) noexcept { instr_per_op  = val; return *this; }
+    };
+
+    struct TPerfMeasure
+    {
+        double ns_per_op     = 0 ;
+        double allocs_per_op = -1; // < 0 - counter is not available
+        double instr_per_op  = -1; // < 0 - counter is not available
+        size_t ops           = 0 ; // executions of the block in all samples
+    };
+
+    inline size_t PERF_SAMPLES   = 15;      // samples per measurement, the median one is taken
+    inline double PERF_SAMPLE_NS = 200'000; // minimal duration of one sample
+
+    // Machine speed factor applied to ns budgets: measured time of a reference workload divided
+    // by PERF_REFERENCE_NS. 0 - measure on first use (or take the SIB_PERF_CALIBRATION environment variable).
+    inline double PERF_CALIBRATION  = 0;
+    inline double PERF_REFERENCE_NS = 1.33; // ~4 cycles of a 3 GHz core per reference step
+
+    double perf_calibration();
+
+    template <typename T>
+    inline void do_not_optimize(T const & val) noexcept
+    {
+        #if defined(__GNUC__) || defined(__clang__)
+            asm volatile("" : : "r"(&val) : "memory");
+        #else
+            static void const * volatile sink;
+            sink = &val;
+        #endif
+    }
+
+    namespace detail {
+
+        // Number of global operator new calls in the current thread,
+        // < 0 if the counter is disabled (SIB_DEBUG_NO_ALLOC_COUNTER).
+        long long alloc_count() noexcept;
+
+        class TInstrCounter
+        {
+        public:
+            TInstrCounter();
+            ~TInstrCounter();
+
+            TInstrCounter(TInstrCounter const &) = delete;
+            TInstrCounter& operator=(TInstrCounter const &) = delete;
+
+            bool available() const noexcept;
+            void start() noexcept;
+            long long stop() noexcept; // < 0 if not available
+
+        private:
+            int _fd = -1;
+        };
+
+        template <typename F>
+        TPerfMeasure perf_measure(F&& block)
+        {
+            using clock = ::std::chrono::steady_clock;
+
+            auto run = [&](size_t ops) {
+                auto t0 = clock::now();
+                for (size_t i = 0; i < ops; ++i) block();
+                return ::std::chrono::duration<double, ::std::nano>(clock::now() - t0).count();
+            };
+
+            // executions per sample (also warms up)
+            size_t ops = 1;
+            for (double ns = run(ops); ns < PERF_SAMPLE_NS and ops < (size_t(1) << 30); ns = run(ops))
+            {
+                ops = (ns * 16 < PERF_SAMPLE_NS) ? ops * 16 : ops * 2;
+            }
+
+            auto samples_count = ::std::max<size_t>(PERF_SAMPLES, 1);
+            ::std::vector<double> samples;
+            samples.reserve(samples_count);
+
+            TInstrCounter instr;
+            auto allocs = alloc_count();
+            instr.start();
+            for (size_t i = 0; i < samples_count; ++i) samples.push_back(run(ops) / static_cast<double>(ops));
+            auto instr_cnt = instr.stop();
+            auto allocs_cnt = alloc_count() - allocs;
+
+            ::std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+
+            TPerfMeasure res;
+            res.ops           = ops * samples_count;
+            res.ns_per_op     = samples[samples.size() / 2];
+            res.allocs_per_op = (allocs    < 0) ? -1 : static_cast<double>(allocs_cnt) / static_cast<double>(res.ops);
+            res.instr_per_op  = (instr_cnt < 0) ? -1 : static_cast<double>(instr_cnt ) / static_cast<double>(res.ops);
+            return res;
+        }
+
+    } // namespace detail
+
 
 
 // ----------------------------------------------------------------------------------- debugging step by step
@@ -331,7 +594,7 @@ namespace debug {
         extern thread_local TBufer output_bufer;
 
         void start_macro(
-            TString const& prefix,
+            char const* prefix,
             bool new_lin                  = true   ,
             bool brk_lin                  = false  ,
             char const* nesting_error_msg = nullptr);
@@ -344,40 +607,73 @@ namespace debug {
     
         void new_begin();
 
+        // ------------------------------------------------------------------- static assertion registry
+        // With SIB_DEBUG_STATIC_ASSERTS defined every SAS site is recorded once, before main,
+        // by the initializer of static_check<Site>. The test only reads the registry at END:
+        // the checks written between the BEG (or previous END) and that END become passed entries.
+
+        struct TStaticCheck
+        {
+            char const * text;
+            char const * file;
+            unsigned     line;
+        };
+
+        bool register_static_check(TStaticCheck const & check);
+
+        template <typename Site>
+        inline bool const static_check = register_static_check(Site{}());
+
+        // ------------------------------------------------------------------- out-of-line macro core
+        // The macros below only evaluate their arguments and pass them here together with
+        // a compact description of the call site, so each use expands to a single expression.
+        // Macros that evaluate user code open with start_macro first (a comma expression), so
+        // the macros nested in their arguments see the same depth as before.
+
+        struct TMacroSite
+        {
+            char const *           text; // stringified macro arguments
+            ::std::source_location loc ;
+        };
+
+        #define SIB_DEBUG_SITE(...) ::sib::debug::detail::TMacroSite{ __VA_ARGS__, ::std::source_location::current() }
+
+        // BEG and END take the line they are written on, END reports the SAS checks of its block.
+        void beg_macro(::std::source_location const & loc = ::std::source_location::current());
+        void end_macro(::std::source_location const & loc = ::std::source_location::current());
+        void msg_macro(TString const & msg);
+        void exe_macro(TMacroSite const & site);
+        void typ_macro(TMacroSite const & site, ::std::string const & type);
+        void ass_macro(TTestLog & log, TMacroSite const & site, bool      val);
+        void ass_macro(TTestLog & log, TMacroSite const & site, error_tag val);
+        void prn_macro(TMacroSite const & site, TString const & val, ::std::string const & type);
+        void pas_macro(TMacroSite const & site, TString const & val, char const * type);
+
+        // Prints the measure, writes it to the log and stops on violation (like ASS).
+        // msg_, ass_, prf_, prn_ and pas_macro continue the macro opened by start_macro.
+        void prf_macro(TTestLog & log, TMacroSite const & site, TPerfBudget const & budget, TPerfMeasure const & measure);
+
     } // namespace detail
 
     #define BP                                                                                          \
         ::sib::debug::  SetBreakPoint(sib::debug::BP_CUSTOM)                                            \
 
     #define BEG                                                                                         \
-        ::sib::debug::detail::start_macro("b", false, false, "BEG is nested in another sib::debug macro."); \
-        ::sib::debug::detail::new_begin();                                                              \
-        ::sib::debug::detail::output_bufer                                                              \
-            << "---------------------------------------------------------------------------------------------- " \
-            << ::sib::debug::BEG_ACCUM;                                                                 \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_BEGIN);                                       \
+        ::sib::debug::detail::beg_macro()                                                               \
 
     #define END                                                                                         \
-        ::sib::debug::detail::start_macro("e", false, false, "AND is nested in another sib::debug macro."); \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_END)                                          \
+        ::sib::debug::detail::end_macro()                                                               \
 
     #define MSG(...)                                                                                    \
-        ::sib::debug::detail::start_macro("m", false);                                                  \
-        ::sib::debug::detail::output_bufer << ::sib::debug::TString(__VA_ARGS__);                       \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
+        (::sib::debug::detail::start_macro("m", false),                                                 \
+         ::sib::debug::detail::msg_macro(::sib::debug::TString(__VA_ARGS__)))                           \
 
     #define EXE(...)                                                                                    \
-        ::sib::debug::detail::start_macro("x");                                                         \
-        ::sib::debug::detail::output_bufer << #__VA_ARGS__;                                             \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL);                                         \
+        ::sib::debug::detail::exe_macro(SIB_DEBUG_SITE(#__VA_ARGS__));                                  \
         __VA_ARGS__                                                                                     \
 
     #define TYP(...)                                                                                    \
-        ::sib::debug::detail::start_macro("p");                                                         \
-        if (not ::sib::debug::NES_ACCUM)                                                                \
-            ::sib::debug::detail::output_bufer << #__VA_ARGS__;                                         \
-        ::sib::debug::detail::output_bufer << " -> " << ::sib::type_name<__VA_ARGS__>();                \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
+        ::sib::debug::detail::typ_macro(SIB_DEBUG_SITE(#__VA_ARGS__), ::sib::type_name<__VA_ARGS__>())  \
 
     #define DEF(type, inst, ...)                                                                        \
         ::sib::debug::detail::start_macro("d");                                                         \
@@ -386,49 +682,44 @@ namespace debug {
         ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
 
     #define ASS(...)                                                                                    \
-        ::sib::debug::detail::start_macro("a", true, true);                                             \
-        if constexpr (std::same_as<decltype(::sib::debug::detail::to_bool(__VA_ARGS__)), bool>)         \
-        {                                                                                               \
-            if (::sib::debug::detail::to_bool(__VA_ARGS__))                                             \
-            {                                                                                           \
-                ::sib::debug::detail::output_bufer << "[pass] ASSERT(" << #__VA_ARGS__ << ")";          \
-            }                                                                                           \
-            else                                                                                        \
-            {                                                                                           \
-                ::sib::debug::detail::output_bufer << "[FAIL] ASSERT(" << #__VA_ARGS__ << ")";          \
-                CUR_LOG.emplace_back(                                                                   \
-                    ::sib::debug::TTestLogType::error,                                                  \
-                    ::sib::debug::BEG_ACCUM,                                                            \
-                    ::sib::debug::LIN_ACCUM,                                                            \
-                    "Assertion fail"                                                                    \
-                );                                                                                      \
-                ::sib::debug::detail::stop_macro(                                                       \
-                    ::sib::debug::STOP_FLAG_ASSERTION_FAIL,                                             \
-                    "\n    - assertion fail -"                                                          \
-                );                                                                                      \
-            }                                                                                           \
-        }                                                                                               \
-        else                                                                                            \
-        {                                                                                               \
-            ::sib::debug::detail::output_bufer                                                          \
-                << "[ERROR] ASSERT(" << #__VA_ARGS__ << ") "                                            \
-                << "Assertion statement is not convertible to bool";                                    \
-            CUR_LOG.emplace_back(                                                                       \
-                ::sib::debug::TTestLogType::error,                                                      \
-                ::sib::debug::BEG_ACCUM,                                                                \
-                ::sib::debug::LIN_ACCUM,                                                                \
-                "Assertion error (statement is not convertible to bool)"                                \
-            );                                                                                          \
-            ::sib::debug::detail::stop_macro(                                                           \
-                ::sib::debug::STOP_FLAG_ASSERTION_ERROR,                                                \
-                "\n    - assertion error -"                                                             \
-            );                                                                                          \
-        }                                                                                               \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
+        (::sib::debug::detail::start_macro("a", true, true),                                            \
+         ::sib::debug::detail::ass_macro(                                                               \
+            CUR_LOG,                                                                                    \
+            SIB_DEBUG_SITE(#__VA_ARGS__),                                                               \
+            ::sib::debug::detail::to_bool(__VA_ARGS__)                                                  \
+        ))                                                                                              \
+
+    #define PRF(budget, ...)                                                                            \
+        (::sib::debug::detail::start_macro("f", true, true),                                            \
+         ::sib::debug::detail::prf_macro(                                                               \
+            CUR_LOG,                                                                                    \
+            SIB_DEBUG_SITE(#__VA_ARGS__),                                                               \
+            budget,                                                                                     \
+            ::sib::debug::detail::perf_measure([&]() { __VA_ARGS__; })                                  \
+        ))                                                                                              \
+
+    // SAS - assertion of a constant expression (type-level facts).
+    // With SIB_DEBUG_STATIC_ASSERTS defined SAS, TIS and EIS are checked by static_assert:
+    // no code at run time and no break point, the text goes to the registry and is reported
+    // by the END of the block as passed entries.
+    #ifdef SIB_DEBUG_STATIC_ASSERTS
+
+        #define SAS(...)                                                                                \
+            do {                                                                                        \
+                static_assert((__VA_ARGS__), "SAS(" #__VA_ARGS__ ")");                                  \
+                (void)::sib::debug::detail::static_check<decltype([] {                                  \
+                    return ::sib::debug::detail::TStaticCheck{ #__VA_ARGS__, __FILE__, __LINE__ }; })>; \
+            } while (false)                                                                             \
 
-    #define TIS(type, ...) ASS(std::is_same_v<type, __VA_ARGS__>)
+    #else
+
+        #define SAS(...) ASS(__VA_ARGS__)
+
+    #endif // SIB_DEBUG_STATIC_ASSERTS
 
-    #define EIS(expr, ...) ASS(std::is_same_v<decltype(expr), __VA_ARGS__>)
+    #define TIS(type, ...) SAS(std::is_same_v<type, __VA_ARGS__>)
+
+    #define EIS(expr, ...) SAS(std::is_same_v<decltype(expr), __VA_ARGS__>)
 
     #define DEFA(type, inst, init, ...)                                                                 \
         ::sib::debug::detail::start_macro("d");                                                         \
@@ -438,20 +729,20 @@ namespace debug {
         ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
     
     #define PRN(...)                                                                                    \
-        ::sib::debug::detail::start_macro("p");                                                         \
-        ::sib::debug::detail::output_bufer                                                              \
-            << #__VA_ARGS__                                                                             \
-            << " = "  << ::sib::debug::disclosure(__VA_ARGS__)                                          \
-            << " -> " << ::sib::type_name<decltype(__VA_ARGS__)>();                                     \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
+        (::sib::debug::detail::start_macro("p"),                                                        \
+         ::sib::debug::detail::prn_macro(                                                               \
+            SIB_DEBUG_SITE(#__VA_ARGS__),                                                               \
+            ::sib::debug::disclosure(__VA_ARGS__),                                                      \
+            ::sib::type_name<decltype(__VA_ARGS__)>()                                                   \
+        ))                                                                                              \
 
     #define PAS(inst, ...)                                                                              \
-        ::sib::debug::detail::start_macro("p");                                                         \
-        ::sib::debug::detail::output_bufer                                                              \
-            << SIB_DEGUG_LITERAL(SIB_STR_STRINGISE(inst))                                               \
-            << " ~ "  << ::sib::debug::disclosure(static_cast<__VA_ARGS__>(inst))                       \
-            << " -> " << #__VA_ARGS__;                                                                  \
-        ::sib::debug::detail::finish_macro(sib::debug::BP_ALL)                                          \
+        (::sib::debug::detail::start_macro("p"),                                                        \
+         ::sib::debug::detail::pas_macro(                                                               \
+            SIB_DEBUG_SITE(SIB_STR_STRINGISE(inst)),                                                    \
+            ::sib::debug::disclosure(static_cast<__VA_ARGS__>(inst)),                                   \
+            #__VA_ARGS__                                                                                \
+        ))                                                                                              \
 
 } // namespace debug
 } // namespace sib
@@ -0,0 +1,322 @@
+﻿#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "sib_type_traits.h"
+
+#if !defined(SIB_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define SIB_UTF_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if !defined(SIB_NO_SIMD) && defined(__AVX2__)
+    #define SIB_UTF_AVX2 1
+    #include <immintrin.h>
+#endif
+
+/*
+    Transcoding between the character types of promiscuous strings. The encoding follows the size of
+    the type: 1 byte - UTF-8 (char, char8_t, signed and unsigned char), 2 bytes - UTF-16 (char16_t and
+    wchar_t on Windows), 4 bytes - UTF-32 (char32_t and wchar_t elsewhere). Types of the same size are
+    copied as is; malformed input (broken UTF-8, lone surrogates, values past U+10FFFF) becomes U+FFFD.
+
+    ASCII runs are found and widened or narrowed 16 bytes at a time with SSE2 (32 with AVX2),
+    only the rest is decoded code point by code point. Define SIB_NO_SIMD to keep the scalar code.
+*/
+
+namespace sib {
+
+    inline constexpr char32_t REPLACEMENT_CHARACTER = U'�';
+
+    namespace detail {
+
+        template <Char Ch>
+        constexpr ::std::uint32_t code_unit(Ch ch) noexcept { return static_cast<::std::make_unsigned_t<::std::remove_cv_t<Ch>>>(ch); }
+
+        // length of the leading run of ASCII characters
+        template <Char Ch>
+        size_t ascii_run(Ch const* ptr, size_t len) noexcept
+        {
+            size_t i = 0;
+        #if SIB_UTF_AVX2
+            if constexpr (sizeof(Ch) == 1)
+            {
+                for (; i + 32 <= len; i += 32)
+                {
+                    auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr + i))));
+                    if (mask) return i + static_cast<size_t>(::std::countr_zero(mask));
+                }
+            }
+        #endif
+        #if SIB_UTF_SSE2
+            if constexpr (sizeof(Ch) == 1)
+            {
+                for (; i + 16 <= len; i += 16)
+                {
+                    auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + i))));
+                    if (mask) return i + static_cast<size_t>(::std::countr_zero(mask));
+                }
+            }
+            else
+            {
+                // a unit is ASCII when none of its bits above the lowest 7 is set
+                __m128i const high = (sizeof(Ch) == 2) ? _mm_set1_epi16(static_cast<short>(0xFF80)) : _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+                __m128i const zero = _mm_setzero_si128();
+                constexpr size_t step = 16 / sizeof(Ch);
+                for (; i + step <= len; i += step)
+                {
+                    __m128i v = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr + i)), high);
+                    __m128i ascii = (sizeof(Ch) == 2) ? _mm_cmpeq_epi16(v, zero) : _mm_cmpeq_epi32(v, zero);
+                    auto mask = static_cast<unsigned>(_mm_movemask_epi8(ascii)) ^ 0xFFFFu;
+                    if (mask) return i + static_cast<size_t>(::std::countr_zero(mask)) / sizeof(Ch);
+                }
+            }
+        #endif
+            while (i < len and code_unit(ptr[i]) < 0x80) ++i;
+            return i;
+        }
+
+        // copies ASCII characters to a character type of another size
+        template <Char Dst, Char Src>
+        void copy_ascii(Dst* dst, Src const* src, size_t count) noexcept
+        {
+            size_t i = 0;
+        #if SIB_UTF_SSE2
+            auto load  = [](auto const* ptr) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr)); };
+            auto store = [](auto* ptr, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), v); };
+            __m128i const zero = _mm_setzero_si128();
+
+            if constexpr (sizeof(Src) == 1 and sizeof(Dst) == 2)
+            {
+                for (; i + 16 <= count; i += 16)
+                {
+                    __m128i v = load(src + i);
+                    store(dst + i    , _mm_unpacklo_epi8(v, zero));
+                    store(dst + i + 8, _mm_unpackhi_epi8(v, zero));
+                }
+            }
+            else if constexpr (sizeof(Src) == 1 and sizeof(Dst) == 4)
+            {
+                for (; i + 16 <= count; i += 16)
+                {
+                    __m128i v  = load(src + i);
+                    __m128i lo = _mm_unpacklo_epi8(v, zero);
+                    __m128i hi = _mm_unpackhi_epi8(v, zero);
+                    store(dst + i     , _mm_unpacklo_epi16(lo, zero));
+                    store(dst + i +  4, _mm_unpackhi_epi16(lo, zero));
+                    store(dst + i +  8, _mm_unpacklo_epi16(hi, zero));
+                    store(dst + i + 12, _mm_unpackhi_epi16(hi, zero));
+                }
+            }
+            else if constexpr (sizeof(Src) == 2 and sizeof(Dst) == 1)
+            {
+                for (; i + 16 <= count; i += 16)
+                    store(dst + i, _mm_packus_epi16(load(src + i), load(src + i + 8)));
+            }
+            else if constexpr (sizeof(Src) == 2 and sizeof(Dst) == 4)
+            {
+                for (; i + 8 <= count; i += 8)
+                {
+                    __m128i v = load(src + i);
+                    store(dst + i    , _mm_unpacklo_epi16(v, zero));
+                    store(dst + i + 4, _mm_unpackhi_epi16(v, zero));
+                }
+            }
+            else if constexpr (sizeof(Src) == 4 and sizeof(Dst) == 1)
+            {
+                for (; i + 16 <= count; i += 16)
+                {
+                    __m128i lo = _mm_packs_epi32(load(src + i    ), load(src + i +  4));
+                    __m128i hi = _mm_packs_epi32(load(src + i + 8), load(src + i + 12));
+                    store(dst + i, _mm_packus_epi16(lo, hi));
+                }
+            }
+            else if constexpr (sizeof(Src) == 4 and sizeof(Dst) == 2)
+            {
+                for (; i + 8 <= count; i += 8)
+                    store(dst + i, _mm_packs_epi32(load(src + i), load(src + i + 4)));
+            }
+        #endif
+            for (; i < count; ++i) dst[i] = static_cast<Dst>(src[i]);
+        }
+
+        // One code point from a non-empty input, returns the number of units taken.
+        template <Char Src>
+        size_t decode_utf(Src const* ptr, size_t len, char32_t& cp) noexcept
+        {
+            ::std::uint32_t lead = code_unit(ptr[0]);
+            if constexpr (sizeof(Src) == 1)
+            {
+                if (lead < 0x80) { cp = lead; return 1; }
+
+                size_t   need;
+                char32_t min;
+                if      (lead >= 0xC2 and lead <= 0xDF) { need = 1; min = 0x80;    cp = lead & 0x1F; }
+                else if (lead >= 0xE0 and lead <= 0xEF) { need = 2; min = 0x800;   cp = lead & 0x0F; }
+                else if (lead >= 0xF0 and lead <= 0xF4) { need = 3; min = 0x10000; cp = lead & 0x07; }
+                else { cp = REPLACEMENT_CHARACTER; return 1; }
+
+                if (len <= need) { cp = REPLACEMENT_CHARACTER; return 1; }
+                for (size_t i = 1; i <= need; ++i)
+                {
+                    ::std::uint32_t next = code_unit(ptr[i]);
+                    if ((next & 0xC0) != 0x80) { cp = REPLACEMENT_CHARACTER; return 1; }
+                    cp = (cp << 6) | (next & 0x3F);
+                }
+                if (cp < min or cp > 0x10FFFF or (cp >= 0xD800 and cp < 0xE000)) { cp = REPLACEMENT_CHARACTER; return 1; }
+                return need + 1;
+            }
+            else if constexpr (sizeof(Src) == 2)
+            {
+                if (lead < 0xD800 or lead >= 0xE000) { cp = lead; return 1; }
+                if (lead < 0xDC00 and len > 1)
+                {
+                    ::std::uint32_t low = code_unit(ptr[1]);
+                    if (low >= 0xDC00 and low < 0xE000) { cp = 0x10000 + ((lead - 0xD800) << 10) + (low - 0xDC00); return 2; }
+                }
+                cp = REPLACEMENT_CHARACTER;
+                return 1;
+            }
+            else
+            {
+                cp = (lead > 0x10FFFF or (lead >= 0xD800 and lead < 0xE000)) ? REPLACEMENT_CHARACTER : lead;
+                return 1;
+            }
+        }
+
+        // Writes a valid code point, returns the number of units written (up to 4).
+        template <Char Dst>
+        size_t encode_utf(char32_t cp, Dst* out) noexcept
+        {
+            if constexpr (sizeof(Dst) == 1)
+            {
+                if (cp < 0x80)    { out[0] = static_cast<Dst>(cp); return 1; }
+                if (cp < 0x800)   { out[0] = static_cast<Dst>(0xC0 | (cp >> 6));
+                                    out[1] = static_cast<Dst>(0x80 | (cp & 0x3F)); return 2; }
+                if (cp < 0x10000) { out[0] = static_cast<Dst>(0xE0 | (cp >> 12));
+                                    out[1] = static_cast<Dst>(0x80 | ((cp >> 6) & 0x3F));
+                                    out[2] = static_cast<Dst>(0x80 | (cp & 0x3F)); return 3; }
+                out[0] = static_cast<Dst>(0xF0 | (cp >> 18));
+                out[1] = static_cast<Dst>(0x80 | ((cp >> 12) & 0x3F));
+                out[2] = static_cast<Dst>(0x80 | ((cp >> 6) & 0x3F));
+                out[3] = static_cast<Dst>(0x80 | (cp & 0x3F));
+                return 4;
+            }
+            else if constexpr (sizeof(Dst) == 2)
+            {
+                if (cp < 0x10000) { out[0] = static_cast<Dst>(cp); return 1; }
+                out[0] = static_cast<Dst>(0xD800 + ((cp - 0x10000) >> 10));
+                out[1] = static_cast<Dst>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+                return 2;
+            }
+            else
+            {
+                out[0] = static_cast<Dst>(cp);
+                return 1;
+            }
+        }
+
+        template <Char Dst>
+        constexpr size_t utf_units(char32_t cp) noexcept
+        {
+            if constexpr (sizeof(Dst) == 1) return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+            else if constexpr (sizeof(Dst) == 2) return (cp < 0x10000) ? 1 : 2;
+            else return 1;
+        }
+
+    } // namespace detail
+
+    // ----------------------------------------------------------------------------------- transcoding
+
+    // Converts the text to the encoding of Dst and hands it to sink(Dst const*, size_t) in pieces.
+    template <Char Dst, Char Src, typename Sink>
+    void transcode(::std::basic_string_view<Src> text, Sink&& sink)
+    {
+        using D = ::std::remove_cv_t<Dst>;
+        using S = ::std::remove_cv_t<Src>;
+
+        if constexpr (::std::is_same_v<D, S>)
+        {
+            if (not text.empty()) sink(text.data(), text.size());
+        }
+        else
+        {
+            constexpr size_t capacity = 256;
+            D      buf[capacity];
+            size_t used = 0;
+
+            auto const* ptr = text.data();
+            size_t const len = text.size();
+            size_t pos = 0;
+            while (pos < len)
+            {
+                // same encoding (char and char8_t, char32_t and a 4 byte wchar_t) - everything is a run
+                size_t run = (sizeof(D) == sizeof(S)) ? len - pos : detail::ascii_run(ptr + pos, len - pos);
+                while (run)
+                {
+                    size_t take = (run < capacity - used) ? run : capacity - used;
+                    detail::copy_ascii(buf + used, ptr + pos, take);
+                    used += take;
+                    pos  += take;
+                    run  -= take;
+                    if (used == capacity) { sink(static_cast<D const*>(buf), used); used = 0; }
+                }
+                if (pos == len) break;
+
+                if (used + 4 > capacity) { sink(static_cast<D const*>(buf), used); used = 0; }
+                char32_t cp;
+                pos  += detail::decode_utf(ptr + pos, len - pos, cp);
+                used += detail::encode_utf(cp, buf + used);
+            }
+            if (used) sink(static_cast<D const*>(buf), used);
+        }
+    }
+
+    // Units of Dst taken by the transcoded text.
+    template <Char Dst, Char Src>
+    size_t transcoded_length(::std::basic_string_view<Src> text) noexcept
+    {
+        if constexpr (sizeof(Dst) == sizeof(Src)) return text.size();
+        else
+        {
+            size_t length = 0;
+            size_t pos    = 0;
+            while (pos < text.size())
+            {
+                size_t run = detail::ascii_run(text.data() + pos, text.size() - pos);
+                length += run;
+                pos    += run;
+                if (pos == text.size()) break;
+
+                char32_t cp;
+                pos    += detail::decode_utf(text.data() + pos, text.size() - pos, cp);
+                length += detail::utf_units<Dst>(cp);
+            }
+            return length;
+        }
+    }
+
+    // Appends the text transcoded to the character type of the string.
+    template <typename Str, Char Src>
+    Str& append_transcoded(Str& out, ::std::basic_string_view<Src> text)
+    {
+        using Ch = typename Str::value_type;
+        if constexpr (sizeof(Ch) == sizeof(Src))
+            out.reserve(out.size() + text.size());
+        transcode<Ch>(text, [&out](Ch const* ptr, size_t len) { out.append(ptr, len); });
+        return out;
+    }
+
+    // Whether a single character is a whole code point (not a piece of UTF-8 or a surrogate).
+    template <Char Ch>
+    constexpr bool is_whole_code_point(Ch ch) noexcept
+    {
+        ::std::uint32_t cp = detail::code_unit(ch);
+        if constexpr (sizeof(Ch) == 1) return cp < 0x80;
+        else return cp <= 0x10FFFF and (cp < 0xD800 or cp >= 0xE000);
+    }
+
+} // namespace sib
@@ -0,0 +1,614 @@
+﻿#include "sib_viewer.h"
+#include "sib_screen.h"
+#include "sib_console.h"
+#include "sib_support.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace sib {
+namespace console {
+
+    // ----------------------------------------------------------------------------------- TReportFile
+
+    namespace {
+
+        constexpr size_t INDEX_CHUNK = 4096; // lines published at once
+
+        ::std::string_view trim(::std::string_view text) noexcept
+        {
+            while (not text.empty() and (text.front() == ' ' or text.front() == '\t')) text.remove_prefix(1);
+            while (not text.empty() and (text.back()  == ' ' or text.back()  == '\t' or text.back() == '\r')) text.remove_suffix(1);
+            return text;
+        }
+
+        ::std::uint32_t to_number(::std::string_view text) noexcept
+        {
+            ::std::uint32_t res = 0;
+            for (char ch : text)
+            {
+                if (ch < '0' or ch > '9') return 0;
+                res = res * 10 + ::std::uint32_t(ch - '0');
+            }
+            return res;
+        }
+
+        bool is_log_type(TLineType type) noexcept
+        {
+            return type == TLineType::Message or type == TLineType::Warning or type == TLineType::Error;
+        }
+
+    } // namespace
+
+    TReportFile::TReportFile(::std::string const& path)
+        : _path(path)
+    {
+        #if defined(_WIN32)
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (_file == INVALID_HANDLE_VALUE) throw ::std::runtime_error("TReportFile: can not open " + path);
+            LARGE_INTEGER size{};
+            GetFileSizeEx(_file, &size);
+            _size = static_cast<size_t>(size.QuadPart);
+            if (_size)
+            {
+                _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (_mapping) _data = static_cast<char const*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+                if (not _data)
+                {
+                    if (_mapping) CloseHandle(_mapping);
+                    CloseHandle(_file);
+                    throw ::std::runtime_error("TReportFile: can not map " + path);
+                }
+            }
+        #else
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) throw ::std::runtime_error("TReportFile: can not open " + path);
+            struct stat st{};
+            if (::fstat(fd, &st) == 0) _size = static_cast<size_t>(st.st_size);
+            if (_size)
+            {
+                void* data = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(fd);
+                    throw ::std::runtime_error("TReportFile: can not map " + path);
+                }
+                ::madvise(data, _size, MADV_SEQUENTIAL);
+                _data = static_cast<char const*>(data);
+            }
+            ::close(fd);
+        #endif
+
+        _thread = ::std::thread([this] { index_loop(); });
+    }
+
+    TReportFile::~TReportFile()
+    {
+        _stop = true;
+        if (_thread.joinable()) _thread.join();
+
+        #if defined(_WIN32)
+            if (_data   ) UnmapViewOfFile(_data);
+            if (_mapping) CloseHandle(_mapping);
+            if (_file   ) CloseHandle(_file);
+        #else
+            if (_data) ::munmap(const_cast<char*>(_data), _size);
+        #endif
+    }
+
+    TLineType TReportFile::classify(::std::string_view line, TLineType previous, ::std::string_view& test_name, ::std::uint32_t& block) noexcept
+    {
+        if (not line.empty() and line.back() == '\r') line.remove_suffix(1);
+
+        // report row: "  | Error    | 1    | 1    | text"
+        if (line.starts_with("  | "))
+        {
+            auto cells = line.substr(4);
+            auto type  = trim(cells.substr(0, cells.find(" |")));
+            if (type.empty()) return is_log_type(previous) ? previous : TLineType::Other;
+
+            TLineType res = TLineType::Other;
+            if      (type == "Message") res = TLineType::Message;
+            else if (type == "Warning") res = TLineType::Warning;
+            else if (type == "Error"  ) res = TLineType::Error;
+            else return TLineType::Other; // the header
+
+            auto rest = cells.substr(::std::min(cells.find(" | "), cells.size()));
+            if (rest.size() > 3) rest.remove_prefix(3);
+            block = to_number(trim(rest.substr(0, rest.find(" |"))));
+            return res;
+        }
+
+        // test header of the report or the transcript
+        auto head = line;
+        while (not head.empty() and (head.front() == ' ' or head.front() == '*')) head.remove_prefix(1);
+        if (head.starts_with("TEST: "))
+        {
+            test_name = trim(head.substr(6));
+            block     = 0;
+            return TLineType::Test;
+        }
+
+        // transcript macro: one letter, then the text after the tab
+        if (line.size() >= 2 and line[0] >= 'a' and line[0] <= 'z' and line[1] == ' ')
+        {
+            if (line[0] == 'b' and line.find("---") != ::std::string_view::npos)
+            {
+                block = to_number(trim(line.substr(line.find_last_of(' ') + 1)));
+                return TLineType::Block;
+            }
+            if (line.find("[FAIL]") != ::std::string_view::npos or line.find("[ERROR]") != ::std::string_view::npos)
+                return TLineType::Error;
+            if (line[0] == 'm') return TLineType::Message;
+        }
+        return TLineType::Other;
+    }
+
+    void TReportFile::index_loop()
+    {
+        ::std::vector<TLine> chunk;
+        chunk.reserve(INDEX_CHUNK);
+
+        ::std::uint32_t test     = 0;
+        ::std::uint32_t block    = 0;
+        TLineType       previous = TLineType::Other;
+
+        auto publish = [&](size_t done) {
+            ::std::lock_guard lock(_mtx);
+            _index.insert(_index.end(), chunk.begin(), chunk.end());
+            _lines_ready.store(_index.size(), ::std::memory_order_release);
+            _bytes_done .store(done, ::std::memory_order_release);
+            chunk.clear();
+        };
+
+        size_t pos = 0;
+        while (pos < _size and not _stop.load(::std::memory_order_relaxed))
+        {
+            auto nl  = static_cast<char const*>(::std::memchr(_data + pos, '\n', _size - pos));
+            auto end = nl ? size_t(nl - _data) : _size;
+
+            ::std::string_view name;
+            auto type = classify({ _data + pos, end - pos }, previous, name, block);
+            if (type == TLineType::Test)
+            {
+                ::std::lock_guard lock(_mtx);
+                _tests.emplace_back(name);
+                test = static_cast<::std::uint32_t>(_tests.size() - 1);
+            }
+            previous = type;
+
+            TLine line;
+            line.offset = pos;
+            line.type   = static_cast<::std::uint8_t>(type);
+            line.test   = test;
+            line.block  = block;
+            chunk.push_back(line);
+
+            pos = end + 1;
+            if (chunk.size() == INDEX_CHUNK) publish(::std::min(pos, _size));
+        }
+        publish(_size);
+        _indexed.store(true, ::std::memory_order_release);
+    }
+
+    double TReportFile::progress() const noexcept
+    {
+        if (_size == 0) return 1.0;
+        return double(_bytes_done.load(::std::memory_order_acquire)) / double(_size);
+    }
+
+    void TReportFile::wait_indexed() const
+    {
+        while (not indexed()) ::std::this_thread::sleep_for(::std::chrono::milliseconds(1));
+    }
+
+    TReportFile::TLine TReportFile::line(size_t i) const
+    {
+        ::std::lock_guard lock(_mtx);
+        return _index.at(i);
+    }
+
+    ::std::string_view TReportFile::line_text(size_t i) const
+    {
+        size_t begin, end;
+        {
+            ::std::lock_guard lock(_mtx);
+            begin = _index.at(i).offset;
+            end   = (i + 1 < _index.size()) ? size_t(_index[i + 1].offset) - 1 : ::std::string_view::npos;
+        }
+        if (end == ::std::string_view::npos)
+        {
+            auto nl = static_cast<char const*>(::std::memchr(_data + begin, '\n', _size - begin));
+            end = nl ? size_t(nl - _data) : _size;
+        }
+        ::std::string_view res(_data + begin, end - begin);
+        if (not res.empty() and res.back() == '\r') res.remove_suffix(1);
+        return res;
+    }
+
+    ::std::vector<TReportFile::TLine> TReportFile::range(size_t first, size_t count) const
+    {
+        ::std::lock_guard lock(_mtx);
+        first = ::std::min(first, _index.size());
+        count = ::std::min(count, _index.size() - first);
+        return { _index.begin() + ::std::ptrdiff_t(first), _index.begin() + ::std::ptrdiff_t(first + count) };
+    }
+
+    size_t TReportFile::line_at(size_t offset) const
+    {
+        ::std::lock_guard lock(_mtx);
+        auto it = ::std::upper_bound(_index.begin(), _index.end(), offset,
+            [](size_t value, TLine const& line) { return value < line.offset; });
+        return (it == _index.begin()) ? 0 : size_t(it - _index.begin()) - 1;
+    }
+
+    size_t TReportFile::offset_of(size_t line) const
+    {
+        ::std::lock_guard lock(_mtx);
+        return (line < _index.size()) ? size_t(_index[line].offset) : _bytes_done.load(::std::memory_order_relaxed);
+    }
+
+    ::std::string TReportFile::test_name(::std::uint32_t test) const
+    {
+        ::std::lock_guard lock(_mtx);
+        return (test < _tests.size()) ? _tests[test] : ::std::string();
+    }
+
+    size_t TReportFile::tests() const
+    {
+        ::std::lock_guard lock(_mtx);
+        return _tests.size();
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- TReportView
+
+    TReportView::TReportView(TReportFile const& file)
+        : _file(file)
+    {
+        refresh();
+    }
+
+    bool TReportView::passes(TReportFile::TLine const& line) const noexcept
+    {
+        auto type = static_cast<TLineType>(line.type);
+        if (_test != ANY and line.test != _test) return false;
+        if (type == TLineType::Test) return true;
+        if (_block != 0 and line.block != _block) return false;
+        if (_types != 0 and not (_types & line_type_bit(type))) return false;
+        return true;
+    }
+
+    bool TReportView::refresh()
+    {
+        size_t before = _visible.size();
+        _scanned = _file.for_each(_scanned, [this](size_t idx, TReportFile::TLine const& line) {
+            if (passes(line))
+            {
+                _visible.push_back(idx);
+                _kinds.push_back(static_cast<TLineType>(line.type));
+            }
+        });
+        return _visible.size() != before;
+    }
+
+    void TReportView::rebuild(size_t keep_line)
+    {
+        _visible.clear();
+        _kinds.clear();
+        _scanned = 0;
+        refresh();
+
+        auto it = ::std::lower_bound(_visible.begin(), _visible.end(), keep_line);
+        _cursor = (it == _visible.end() and not _visible.empty()) ? _visible.size() - 1 : size_t(it - _visible.begin());
+        _top    = (_cursor > _height / 2) ? _cursor - _height / 2 : 0;
+        keep_cursor_visible();
+    }
+
+    void TReportView::filter(::std::uint32_t test, ::std::uint32_t block, ::std::uint8_t types)
+    {
+        size_t keep = _visible.empty() ? 0 : _visible[_cursor];
+        _test  = test;
+        _block = block;
+        _types = types;
+        rebuild(keep);
+    }
+
+    void TReportView::set_height(size_t height) noexcept
+    {
+        _height = ::std::max<size_t>(height, 1);
+        keep_cursor_visible();
+    }
+
+    void TReportView::keep_cursor_visible() noexcept
+    {
+        if (_visible.empty()) { _top = _cursor = 0; return; }
+        _cursor = ::std::min(_cursor, _visible.size() - 1);
+        if (_cursor < _top) _top = _cursor;
+        if (_cursor >= _top + _height) _top = _cursor - _height + 1;
+        _top = ::std::min(_top, (_visible.size() > _height) ? _visible.size() - _height : 0);
+    }
+
+    void TReportView::move(::std::ptrdiff_t delta) noexcept
+    {
+        if (delta < 0) _cursor = (size_t(-delta) > _cursor) ? 0 : _cursor - size_t(-delta);
+        else           _cursor += size_t(delta);
+        keep_cursor_visible();
+    }
+
+    void TReportView::move_to(size_t pos) noexcept
+    {
+        _cursor = pos;
+        keep_cursor_visible();
+    }
+
+    bool TReportView::next_error(bool forward /* = true */)
+    {
+        if (_visible.empty()) return false;
+        if (forward)
+        {
+            auto it = ::std::find(_kinds.begin() + ::std::ptrdiff_t(_cursor) + 1, _kinds.end(), TLineType::Error);
+            if (it == _kinds.end()) return false;
+            move_to(size_t(it - _kinds.begin()));
+        }
+        else
+        {
+            auto rend = _kinds.rend();
+            auto it   = ::std::find(rend - ::std::ptrdiff_t(_cursor), rend, TLineType::Error);
+            if (it == rend) return false;
+            move_to(size_t(rend - it) - 1);
+        }
+        return true;
+    }
+
+    bool TReportView::search(::std::string_view text, bool forward /* = true */)
+    {
+        refresh();
+        if (text.empty() or _visible.empty()) return false;
+
+        // a match past the lines taken by the view would be placed on a wrong line
+        auto   all  = _file.text().substr(0, _file.offset_of(_scanned));
+        size_t from = size_t(_file.line(_visible[_cursor]).offset);
+        for (;;)
+        {
+            size_t found;
+            if (forward)
+            {
+                // from the end of the cursor line
+                auto nl = all.find('\n', from);
+                if (nl == ::std::string_view::npos) return false;
+                found = all.find(text, nl + 1);
+            }
+            else
+            {
+                if (from == 0) return false;
+                // a match starting before the cursor line
+                found = all.rfind(text, from - 1);
+            }
+            if (found == ::std::string_view::npos) return false;
+
+            size_t line = _file.line_at(found);
+            auto   it = ::std::lower_bound(_visible.begin(), _visible.end(), line);
+            if (it != _visible.end() and *it == line)
+            {
+                move_to(size_t(it - _visible.begin()));
+                return true;
+            }
+            // filtered out, go on from that line
+            from = size_t(_file.line(line).offset);
+        }
+    }
+
+    void TReportView::draw(TScreen& screen, int height) const
+    {
+        for (int row = 0; row < height; ++row)
+        {
+            size_t pos = _top + size_t(row);
+            if (pos >= _visible.size()) break;
+
+            TAttr attr{};
+            switch (_kinds[pos])
+            {
+            case TLineType::Test   : attr.style = STYLE_BOLD; break;
+            case TLineType::Block  : attr.fg    = 6;          break;
+            case TLineType::Warning: attr.fg    = 3;          break;
+            case TLineType::Error  : attr.fg    = 1;          break;
+            default: break;
+            }
+            if (pos == _cursor)
+            {
+                attr.style |= STYLE_REVERSE;
+                screen.fill(0, row, screen.width(), 1, U' ', attr);
+            }
+            screen.print(0, row, _file.line_text(_visible[pos]), attr);
+        }
+    }
+
+
+
+    // ----------------------------------------------------------------------------------- ViewReport
+
+    namespace {
+
+        struct TViewer
+        {
+            TReportFile&  file;
+            TReportView&  view;
+            TScreen&      screen;
+            TEventLoop&   loop;
+            TKeyBindings& keys;
+
+            TKeyBindings::TModeId search_mode = 0;
+
+            ::std::string search{};
+            ::std::string prompt{};
+            ::std::string note  {};
+            bool          retry = false; // the forward search goes on as the file gets indexed
+
+            void draw()
+            {
+                auto [width, height] = TerminalSize();
+                if (width != screen.width() or height != screen.height()) screen.resize(width, height);
+
+                int rows = ::std::max(screen.height() - 1, 1);
+                view.set_height(size_t(rows));
+                screen.clear();
+                view.draw(screen, rows);
+
+                ::std::string status = " " + file.path();
+                status += "  " + ::std::to_string(view.size() ? view.cursor() + 1 : 0) + "/" + ::std::to_string(view.size());
+                if (not file.indexed())
+                    status += "  indexing " + ::std::to_string(int(file.progress() * 100)) + "%";
+                if (view.filter_test() != TReportView::ANY)
+                    status += "  test: " + file.test_name(view.filter_test());
+                if (view.filter_block())
+                    status += "  block: " + ::std::to_string(view.filter_block());
+                if (auto types = view.filter_types())
+                {
+                    status += "  types: ";
+                    if (types & line_type_bit(TLineType::Message)) status += 'M';
+                    if (types & line_type_bit(TLineType::Warning)) status += 'W';
+                    if (types & line_type_bit(TLineType::Error  )) status += 'E';
+                }
+                if (keys.mode() == search_mode) status += "  /" + prompt;
+                else if (not note.empty())      status += "  " + note;
+                else if (not search.empty())    status += "  /" + search;
+
+                TAttr bar{ COLOR_DEFAULT, COLOR_DEFAULT, STYLE_REVERSE };
+                screen.fill(0, screen.height() - 1, screen.width(), 1, U' ', bar);
+                int end = screen.print(0, screen.height() - 1, status, bar);
+                screen.cursor(end, screen.height() - 1, keys.mode() == search_mode);
+                screen.present();
+            }
+
+            TReportFile::TLine current() const
+            {
+                return file.line(view.line(view.cursor()));
+            }
+
+            void toggle_types(TLineType type)
+            {
+                view.filter(view.filter_test(), view.filter_block(), view.filter_types() ^ line_type_bit(type));
+            }
+
+            ::std::ptrdiff_t page() const
+            {
+                return ::std::max(screen.height() - 2, 1);
+            }
+
+            void found(bool ok, char const* what)
+            {
+                note = ok ? ::std::string() : ::std::string(what);
+            }
+
+            void find(bool forward)
+            {
+                bool ok = view.search(search, forward);
+                retry = not ok and forward and not file.indexed();
+                found(ok, retry ? "searching" : "not found");
+            }
+        };
+
+        using TViewerAction = void (*)(TViewer&);
+
+        // every action is followed by a redraw; empty codes (keys missing on the platform) are skipped
+        void bind_keys(TViewer* st, TKeyBindings::TModeId mode, ::std::initializer_list<TKeyCode> codes, TViewerAction action,
+            TKeyBindings::TModeId next_mode = TKeyBindings::NO_MODE)
+        {
+            for (auto code : codes)
+                if (not code.empty()) st->keys.bind(mode, { code }, [st, action] { st->retry = false; action(*st); st->draw(); }, next_mode);
+        }
+
+    } // namespace
+
+    void ViewReport(::std::string const& path)
+    {
+        TReportFile  file(path);
+        TReportView  view(file);
+        TScreen      screen(0, 0);
+        TEventLoop   loop;
+        TKeyBindings keys("view");
+
+        TViewer  state{ file, view, screen, loop, keys };
+        TViewer* st     = &state;
+        auto     search = keys.add_mode("search");
+        state.search_mode = search;
+
+        bind_keys(st, 0, { KC_DOWN, { 'j' } }, [](TViewer& v) { v.view.move(+1); });
+        bind_keys(st, 0, { KC_UP  , { 'k' } }, [](TViewer& v) { v.view.move(-1); });
+        bind_keys(st, 0, { KC_PAGE_DOWN, { ' ' } }, [](TViewer& v) { v.view.move(+v.page()); });
+        bind_keys(st, 0, { KC_PAGE_UP          }, [](TViewer& v) { v.view.move(-v.page()); });
+        bind_keys(st, 0, { KC_HOME, { 'g' } }, [](TViewer& v) { v.view.move_to(0); });
+        bind_keys(st, 0, { KC_END , { 'G' } }, [](TViewer& v) { v.view.move_to(v.view.size()); });
+        bind_keys(st, 0, { { 'e' } }, [](TViewer& v) { v.found(v.view.next_error(true ), "no more failures"); });
+        bind_keys(st, 0, { { 'E' } }, [](TViewer& v) { v.found(v.view.next_error(false), "no more failures"); });
+        bind_keys(st, 0, { { 'n' } }, [](TViewer& v) { v.find(true ); });
+        bind_keys(st, 0, { { 'N' } }, [](TViewer& v) { v.find(false); });
+        bind_keys(st, 0, { { '/' } }, [](TViewer& v) { v.prompt.clear(); v.note.clear(); }, search);
+        bind_keys(st, 0, { { 't' } }, [](TViewer& v) {
+            if (not v.view.size()) return;
+            auto test = (v.view.filter_test() == TReportView::ANY) ? ::std::uint32_t(v.current().test) : TReportView::ANY;
+            v.view.filter(test, v.view.filter_block(), v.view.filter_types());
+        });
+        bind_keys(st, 0, { { 'b' } }, [](TViewer& v) {
+            if (not v.view.size()) return;
+            auto block = v.view.filter_block() ? 0 : ::std::uint32_t(v.current().block);
+            v.view.filter(v.view.filter_test(), block, v.view.filter_types());
+        });
+        bind_keys(st, 0, { { '1' } }, [](TViewer& v) { v.toggle_types(TLineType::Message); });
+        bind_keys(st, 0, { { '2' } }, [](TViewer& v) { v.toggle_types(TLineType::Warning); });
+        bind_keys(st, 0, { { '3' } }, [](TViewer& v) { v.toggle_types(TLineType::Error  ); });
+        bind_keys(st, 0, { { '0' } }, [](TViewer& v) { v.view.filter(TReportView::ANY, 0, 0); });
+        bind_keys(st, 0, { KC_ESC, { 'q' } }, [](TViewer& v) { v.loop.stop(); });
+
+        bind_keys(st, search, { KC_ENTER, { '\r' } }, [](TViewer& v) {
+            v.search = v.prompt;
+            v.find(true);
+        }, 0);
+        bind_keys(st, search, { KC_ESC }, [](TViewer&) {}, 0);
+        bind_keys(st, search, { KC_BACKSPACE, { '\x7F' }, { '\x08' } }, [](TViewer& v) {
+            while (not v.prompt.empty())
+            {
+                bool lead = (static_cast<unsigned char>(v.prompt.back()) & 0xC0) != 0x80;
+                v.prompt.pop_back();
+                if (lead) break;
+            }
+        });
+        keys.compile();
+
+        loop.set_bindings(&keys);
+        loop.on_key([st](TKeyCode code) {
+            if (st->keys.mode() == st->search_mode and static_cast<unsigned char>(code[0]) >= 0x20)
+                for (size_t i = 0; i < code.size(); ++i) st->prompt += code[i];
+            st->draw();
+        });
+        // picks up the lines indexed meanwhile, the terminal size and the end of input
+        loop.add_timer({}, [st] {
+            if (st->loop.input_closed()) { st->loop.stop(); return; }
+            st->view.refresh();
+            if (st->retry) st->find(true);
+            st->draw();
+        }, ::std::chrono::milliseconds(50));
+
+        outstream.flush();
+        WriteOutput("\x1B[?1049h");
+        SIB_SCOPE_GUARD( WriteOutput("\x1B[?25h\x1B[0m\x1B[?1049l"); );
+
+        state.draw();
+        loop.run();
+    }
+
+} // namespace console
+} // namespace sib
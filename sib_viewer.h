@@ -0,0 +1,184 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace sib {
+namespace console {
+
+    class TScreen;
+
+    // ----------------------------------------------------------------------------------- report file
+
+    enum class TLineType : ::std::uint8_t { Other = 0, Test, Block, Message, Warning, Error };
+
+    inline constexpr ::std::uint8_t line_type_bit(TLineType type) noexcept { return ::std::uint8_t(1u << unsigned(type)); }
+
+    /*
+        Report (ReportText) or macro transcript file mapped into memory. A background thread splits it
+        into lines and tags every line with its test, BEG block and log type:
+            "  TEST: <name>", "******** TEST: <name>"   - test header
+            "b   ------ <n>"                            - BEG block of the transcript
+            "  | <Type> | <beg> | <line> | <text>"     - report row, continuation rows keep the type
+            "a   ...  [FAIL] ...", "[ERROR]"            - failed macro of the transcript
+            "m   ..."                                   - message of the transcript
+        Lines that are already indexed can be read while the rest is indexed.
+    */
+    class TReportFile
+    {
+    public:
+        struct TLine
+        {
+            ::std::uint64_t offset : 56;
+            ::std::uint64_t type   : 8;   // TLineType
+            ::std::uint32_t test;         // index in tests(), 0 - before the first test header
+            ::std::uint32_t block;        // BEG block, 0 - none
+        };
+
+        // throws ::std::runtime_error if the file can not be mapped
+        explicit TReportFile(::std::string const& path);
+        ~TReportFile();
+
+        TReportFile(TReportFile const &) = delete;
+        TReportFile& operator=(TReportFile const &) = delete;
+
+        ::std::string_view text() const noexcept { return { _data, _size }; }
+        ::std::string const& path() const noexcept { return _path; }
+
+        size_t lines  () const noexcept { return _lines_ready.load(::std::memory_order_acquire); }
+        bool   indexed() const noexcept { return _indexed.load(::std::memory_order_acquire); }
+        double progress() const noexcept;  // 0..1 of the bytes indexed
+        void   wait_indexed() const;
+
+        // i < lines()
+        TLine              line     (size_t i) const;
+        ::std::string_view line_text(size_t i) const;
+
+        // copies of lines [first, first + count) clipped by lines()
+        ::std::vector<TLine> range(size_t first, size_t count) const;
+
+        // calls func(index, TLine) for the indexed lines from first on, under the index lock
+        template <typename Func>
+        size_t for_each(size_t first, Func&& func) const
+        {
+            ::std::lock_guard lock(_mtx);
+            size_t last = _index.size();
+            for (size_t i = first; i < last; ++i) func(i, _index[i]);
+            return last;
+        }
+
+        // the line holding the byte
+        size_t line_at(size_t offset) const;
+
+        // first byte of the line; for line == lines() - the end of the indexed bytes
+        size_t offset_of(size_t line) const;
+
+        ::std::string test_name(::std::uint32_t test) const;
+        size_t        tests() const;
+
+        // type of the line; sets test_name for a test header and updates the current BEG block,
+        // previous - type of the line before (continuation rows of the report)
+        static TLineType classify(::std::string_view line, TLineType previous, ::std::string_view& test_name, ::std::uint32_t& block) noexcept;
+
+    private:
+        void index_loop();
+
+        ::std::string       _path;
+        char const*         _data = nullptr;
+        size_t              _size = 0;
+
+        #if defined(_WIN32)
+            void* _file    = nullptr;
+            void* _mapping = nullptr;
+        #endif
+
+        mutable ::std::mutex        _mtx{};
+        ::std::vector<TLine>        _index{};
+        ::std::vector<::std::string> _tests{ ::std::string() };
+        ::std::atomic<size_t>       _lines_ready{ 0 };
+        ::std::atomic<size_t>       _bytes_done { 0 };
+        ::std::atomic<bool>         _indexed    { false };
+        ::std::atomic<bool>         _stop       { false };
+        ::std::thread               _thread{};
+    };
+
+
+
+    // ----------------------------------------------------------------------------------- report view
+
+    /*
+        Window over a TReportFile: filters, position, search. Only the lines passing the filters
+        are visible; they are collected incrementally as the file gets indexed (refresh), so moving
+        around costs the same for any file size. Test headers stay visible under a type filter.
+    */
+    class TReportView
+    {
+    public:
+        static constexpr ::std::uint32_t ANY = 0xFFFFFFFF;
+
+        explicit TReportView(TReportFile const& file);
+
+        // takes the lines indexed since the last call; returns true if anything was added
+        bool refresh();
+
+        // filters, ANY / 0 - off; `types` - line_type_bit set
+        void filter(::std::uint32_t test, ::std::uint32_t block, ::std::uint8_t types);
+
+        ::std::uint32_t filter_test () const noexcept { return _test;  }
+        ::std::uint32_t filter_block() const noexcept { return _block; }
+        ::std::uint8_t  filter_types() const noexcept { return _types; }
+
+        size_t size() const noexcept { return _visible.size(); }
+        size_t top () const noexcept { return _top; }
+        size_t cursor() const noexcept { return _cursor; }
+
+        // line of the file at the visible position
+        size_t line(size_t pos) const noexcept { return _visible[pos]; }
+
+        void set_height(size_t height) noexcept;
+        void move(::std::ptrdiff_t delta) noexcept;
+        void move_to(size_t pos) noexcept;
+
+        // false if there is nothing to go to; the search sees only the lines indexed so far
+        bool next_error(bool forward = true);
+        bool search    (::std::string_view text, bool forward = true);
+
+        void draw(TScreen& screen, int height) const;
+
+    private:
+        bool passes(TReportFile::TLine const& line) const noexcept;
+        void keep_cursor_visible() noexcept;
+        void rebuild(size_t keep_line);
+
+        TReportFile const&    _file;
+        ::std::vector<size_t>    _visible{};   // lines of the file
+        ::std::vector<TLineType> _kinds  {};   // their types
+        size_t                _scanned = 0;  // lines of the file already filtered
+        ::std::uint32_t       _test    = ANY;
+        ::std::uint32_t       _block   = 0;
+        ::std::uint8_t        _types   = 0;
+        size_t                _top     = 0;
+        size_t                _cursor  = 0;
+        size_t                _height  = 1;
+    };
+
+    /*
+        Interactive viewer of a report or transcript file:
+            Up/Down, PgUp/PgDn, Home/End    - move
+            e / E                           - next / previous failure
+            /  then n / N                   - search, next / previous match
+            t / b                           - show only the test / BEG block under the cursor (toggle)
+            1 / 2 / 3                       - show only messages / warnings / errors (toggle)
+            0                               - drop the filters
+            q / Esc                         - quit
+        Uses the alternate screen of the terminal, the file is indexed while it is viewed.
+    */
+    void ViewReport(::std::string const& path);
+
+} // namespace console
+} // namespace sib
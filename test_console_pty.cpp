@@ -0,0 +1,641 @@
+﻿#include "test_console_pty.h"
+#include "sib_unit_test.h"
+#include "sib_console.h"
+#include "sib_support.h"
+
+#if !defined(_WIN32)
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    using TClock = std::chrono::steady_clock;
+    using namespace std::chrono_literals;
+    using sib::console::TKeyCode;
+
+    // pseudo-terminal pair, the slave side replaces stdin while alive
+    class TPtyStdin
+    {
+    public:
+        TPtyStdin()
+        {
+            _master = ::posix_openpt(O_RDWR | O_NOCTTY);
+            if (_master < 0 or ::grantpt(_master) != 0 or ::unlockpt(_master) != 0) return;
+
+            _slave = ::open(::ptsname(_master), O_RDWR | O_NOCTTY);
+            if (_slave < 0) return;
+
+            // raw from the start: bytes written before GetKey switches the mode must not wait for a line
+            termios mode{};
+            ::tcgetattr(_slave, &mode);
+            ::cfmakeraw(&mode);
+            ::tcsetattr(_slave, TCSANOW, &mode);
+
+            _saved = ::dup(STDIN_FILENO);
+            if (_saved >= 0) ::dup2(_slave, STDIN_FILENO);
+        }
+
+        ~TPtyStdin()
+        {
+            if (_saved >= 0)
+            {
+                ::dup2(_saved, STDIN_FILENO);
+                ::close(_saved);
+            }
+            if (_slave  >= 0) ::close(_slave);
+            if (_master >= 0) ::close(_master);
+        }
+
+        TPtyStdin(TPtyStdin const&) = delete;
+        TPtyStdin& operator=(TPtyStdin const&) = delete;
+
+        bool ok() const noexcept { return _saved >= 0; }
+
+        void write(std::string_view bytes) const
+        {
+            while (not bytes.empty())
+            {
+                auto done = ::write(_master, bytes.data(), bytes.size());
+                if (done <= 0) return;
+                bytes.remove_prefix(static_cast<size_t>(done));
+            }
+        }
+
+    private:
+        int _master = -1;
+        int _slave  = -1;
+        int _saved  = -1;
+    };
+
+    // stdout replaced by the write end of a small non-blocking pipe while alive; the read end is
+    // drained by a thread that stops after `limit` bytes and closes it
+    class TPipeStdout
+    {
+    public:
+        explicit TPipeStdout(size_t limit = SIZE_MAX)
+        {
+            int fds[2];
+            if (::pipe(fds) != 0) return;
+            #if defined(F_SETPIPE_SZ)
+                ::fcntl(fds[1], F_SETPIPE_SZ, 4096);
+            #endif
+            ::fcntl(fds[1], F_SETFL, ::fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+            _saved = ::dup(STDOUT_FILENO);
+            ::dup2(fds[1], STDOUT_FILENO);
+            ::close(fds[1]);
+
+            _reader = std::thread([this, fd = fds[0], limit] {
+                char buf[1000];
+                while (_read.size() < limit)
+                {
+                    auto bytes = ::read(fd, buf, std::min(sizeof(buf), limit - _read.size()));
+                    if (bytes <= 0) break;
+                    _read.append(buf, size_t(bytes));
+                    std::this_thread::sleep_for(50us); // slower than the writer: the pipe fills up
+                }
+                ::close(fd);
+            });
+        }
+
+        ~TPipeStdout() { finish(); }
+
+        TPipeStdout(TPipeStdout const&) = delete;
+        TPipeStdout& operator=(TPipeStdout const&) = delete;
+
+        // stdout back, everything that went through the pipe
+        std::string const& finish()
+        {
+            if (_saved >= 0)
+            {
+                ::dup2(_saved, STDOUT_FILENO);
+                ::close(_saved);
+                _saved = -1;
+            }
+            if (_reader.joinable()) _reader.join();
+            return _read;
+        }
+
+    private:
+        int         _saved = -1;
+        std::thread _reader{};
+        std::string _read  {};
+    };
+
+    // bytes written to the terminal after a pause
+    struct TStep
+    {
+        std::string               bytes;
+        std::chrono::microseconds pause = 0us;
+    };
+
+    // feeds the script from another thread and reads `count` keys by GetKey
+    std::vector<TKeyCode> run_script(std::vector<TStep> const& script, size_t count)
+    {
+        std::vector<TKeyCode> keys;
+        TPtyStdin pty;
+        if (not pty.ok()) return keys;
+
+        std::thread writer([&] {
+            for (auto const& step : script)
+            {
+                std::this_thread::sleep_for(step.pause);
+                pty.write(step.bytes);
+            }
+        });
+        while (keys.size() < count) keys.push_back(sib::console::GetKey());
+        writer.join();
+        return keys;
+    }
+
+    struct TLatency
+    {
+        double median_us = 0;
+        double p99_us    = 0;
+    };
+
+    // time from a key being written to GetKey returning it
+    TLatency key_latency(std::string_view key, size_t samples)
+    {
+        std::vector<double> times;
+        TPtyStdin pty;
+        if (not pty.ok()) return {};
+
+        for (size_t i = 0; i < samples; ++i)
+        {
+            auto start = TClock::now();
+            pty.write(key);
+            [[maybe_unused]] auto code = sib::console::GetKey();
+            times.push_back(std::chrono::duration<double, std::micro>(TClock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return { times[times.size() / 2], times[times.size() * 99 / 100] };
+    }
+
+    // the same through TEventLoop, woken meanwhile by a periodic timer
+    TLatency loop_key_latency(std::string_view key, size_t samples, std::chrono::milliseconds period)
+    {
+        std::vector<double> times;
+        TPtyStdin pty;
+        if (not pty.ok()) return {};
+
+        sib::console::TEventLoop loop;
+        size_t got = 0;
+        loop.on_key([&](TKeyCode) { ++got; });
+        loop.add_timer(period, [] {}, period);
+        for (size_t i = 0; i < samples; ++i)
+        {
+            auto start = TClock::now();
+            pty.write(key);
+            // a key held back by the timer gives up after a second instead of hanging the test
+            for (size_t before = got; got == before and TClock::now() - start < 1s; ) loop.run_once(100);
+            times.push_back(std::chrono::duration<double, std::micro>(TClock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return { times[times.size() / 2], times[times.size() * 99 / 100] };
+    }
+
+    // keys (or bytes of pasted text) per second
+    template <typename TRead>
+    double throughput(std::string const& bytes, size_t units, TRead read)
+    {
+        TPtyStdin pty;
+        if (not pty.ok()) return 0;
+
+        auto start = TClock::now();
+        std::thread writer([&] { pty.write(bytes); });
+        for (size_t done = 0; done < units; ) done += read();
+        writer.join();
+        return units / std::chrono::duration<double>(TClock::now() - start).count();
+    }
+
+    // compiled terminfo entry in the legacy format with only the given string capabilities
+    std::string terminfo_image(std::vector<std::pair<unsigned, std::string>> const& caps)
+    {
+        unsigned count = 0;
+        for (auto const& cap : caps) count = std::max(count, cap.first + 1);
+
+        std::string names = "test|pty harness";
+        std::string offsets(count * 2, '\xFF');
+        std::string table;
+        for (auto const& [idx, seq] : caps)
+        {
+            offsets[idx * 2    ] = static_cast<char>(table.size() & 0xFF);
+            offsets[idx * 2 + 1] = static_cast<char>(table.size() >> 8);
+            table += seq + '\0';
+        }
+
+        std::string image;
+        for (unsigned v : { 0432u, unsigned(names.size() + 1), 0u, 0u, count, unsigned(table.size()) })
+        {
+            image += static_cast<char>(v & 0xFF);
+            image += static_cast<char>(v >> 8);
+        }
+        image += names + '\0';
+        if (image.size() % 2) image += '\0';
+        return image + offsets + table;
+    }
+
+    std::string fmt(double value, char const* unit)
+    {
+        return std::to_string(static_cast<long long>(value + 0.5)) + unit;
+    }
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+DEF_TEST(test_console_pty)
+{
+    using namespace sib::console;
+
+    sib::debug::Init();
+
+    // an empty key table in place of the $TERM one: the sequences below pass as they are,
+    // whatever terminal the tests are run from and whichever test read a key first
+    TTerminalKeys const  no_keys(nullptr, {});
+    TTerminalKeys const* saved_keys = TTerminalKeys::set_current(&no_keys);
+    SIB_SCOPE_GUARD( TTerminalKeys::set_current(saved_keys); );
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                         sib_console (pty)                                          ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    {
+        BEG;
+        ASS(TPtyStdin().ok());
+        END;
+    } {
+        BEG;
+        // one key per write
+        EXE(std::vector<TKeyCode> codes = {
+            KC_F1, KC_F4, KC_F5, KC_F12, KC_UP, KC_DOWN, KC_LEFT, KC_RIGHT,
+            KC_HOME, KC_END, KC_INSERT, KC_DELETE, KC_PAGE_UP, KC_PAGE_DOWN, KC_ENTER,
+            { 'a' }, { '\xD0', '\x96' }, { '\x1B', 'x' },
+        });
+        EXE(std::vector<TStep> script);
+        for (auto const& code : codes)
+        {
+            std::string bytes;
+            for (size_t i = 0; i < code.size(); ++i) bytes += code[i];
+            script.push_back({ bytes, 2ms });
+        }
+        EXE(auto keys = run_script(script, codes.size()));
+        ASS(keys == codes);
+        END;
+
+        // the same keys in one write
+        std::string burst;
+        for (auto const& step : script) burst += step.bytes;
+        EXE(keys = run_script({ { burst } }, codes.size()));
+        ASS(keys == codes);
+        END;
+    } {
+        BEG;
+        // a sequence split by a pause shorter than KEY_SEQUENCE_TIMEOUT_MS is still one key
+        EXE(auto keys = run_script({ { "\x1B[" }, { "A", 5ms }, { "\x1BO" }, { "P", 5ms } }, 2));
+        ASS(keys == std::vector<TKeyCode>{ KC_UP, KC_F1 });
+        END;
+
+        // a lone ESC is returned after the timeout
+        EXE(keys = run_script({ { "\x1B" }, { "q", std::chrono::milliseconds(KEY_SEQUENCE_TIMEOUT_MS * 4) } }, 2));
+        ASS(keys == std::vector<TKeyCode>{ KC_ESC, { 'q' } });
+        END;
+
+        // ... also by the event loop woken by a timer faster than the timeout
+        std::vector<TKeyCode> loop_keys;
+        int  ticks   = 0;
+        auto elapsed = TClock::duration::zero();
+        {
+            TPtyStdin  pty;
+            TEventLoop loop;
+            loop.on_key([&](TKeyCode key) { loop_keys.push_back(key); });
+            loop.add_timer(5ms, [&] { ++ticks; }, 5ms);
+            auto start = TClock::now();
+            pty.write("\x1B");
+            while (loop_keys.empty() and ticks < 200) loop.run_once(100);
+            elapsed = TClock::now() - start;
+        }
+        ASS(loop_keys == std::vector<TKeyCode>{ KC_ESC });
+        ASS(elapsed < std::chrono::milliseconds(KEY_SEQUENCE_TIMEOUT_MS) + 500ms);
+        ASS(ticks < 100);
+        END;
+    } {
+        BEG;
+        // a CSI sequence longer than TKeyCode::capacity is skipped, not cut into another key
+        auto decode = [](std::string_view bytes) {
+            TKeyDecoder decoder;
+            std::vector<TKeyCode> keys;
+            for (char ch : bytes) if (decoder.feed(ch)) keys.push_back(decoder.take());
+            if (decoder.pending()) keys.push_back(TKeyCode{ '?' });
+            return keys;
+        };
+        ASS(decode("\x1B[27;5;13~" "a") == std::vector<TKeyCode>{ { 'a' } });
+        ASS(decode("\x1B[1;2;3;4~" "\x1B[1;2;3;5~" "b") == std::vector<TKeyCode>{ { 'b' } });
+        ASS(decode("\x1B[15;5~") == std::vector<TKeyCode>{ { '\x1B', '[', '1', '5', ';', '5', '~' } });
+        END;
+    } {
+        BEG;
+        // kcuu1, kcub1 (same as KC_LEFT, so not needed), kf1
+        EXE(auto image = terminfo_image({ { 87, "\x1BOA" }, { 79, "\x1B[D" }, { 66, "\x1B[11~" } }));
+        EXE(auto entries = TTerminalKeys::parse(image));
+        ASS(entries.size() == 2);
+        ASS(entries.size() == 2 and TKeyCode::from_data(entries[0].raw) == TKeyCode{ '\x1B', 'O', 'A' });
+        ASS(entries.size() == 2 and TKeyCode::from_data(entries[0].key) == KC_UP);
+        ASS(entries.size() == 2 and TKeyCode::from_data(entries[1].key) == KC_F1);
+        ASS(TTerminalKeys::parse(image.substr(0, 20)).empty());
+        END;
+    } {
+        BEG;
+        // the table is stored in the cache directory, mapped from it by the next load and rebuilt
+        // when the terminfo entry changes; without a cache directory nothing is written
+        namespace fs = std::filesystem;
+        EXE(auto root = fs::temp_directory_path() / ("sib_keys_" + std::to_string(TClock::now().time_since_epoch().count())));
+        EXE(fs::create_directories(root / "terminfo" / "s"));
+        EXE(auto source = root / "terminfo" / "s" / "sib-test");
+        EXE(std::ofstream(source, std::ios::binary) << terminfo_image({ { 87, "\x1BOA" }, { 66, "\x1B[11~" } }));
+        EXE(auto cache = root / "cache");
+        EXE(auto saved = std::string(std::getenv("TERMINFO") ? std::getenv("TERMINFO") : ""));
+        EXE(::setenv("TERMINFO", (root / "terminfo").c_str(), 1));
+        {
+            TTerminalKeys keys("sib-test", {});
+            ASS(keys.size() == 2 and not keys.from_cache());
+            ASS(not fs::exists(cache));
+        } {
+            TTerminalKeys keys("sib-test", cache.string());
+            ASS(keys.size() == 2 and not keys.from_cache());
+            ASS(fs::is_regular_file(cache / "keys-sib-test"));
+        } {
+            TTerminalKeys keys("sib-test", cache.string());
+            ASS(keys.size() == 2 and keys.from_cache());
+            ASS(keys.translate(TKeyCode{ '\x1B', 'O', 'A' }) == KC_UP);
+            ASS(keys.translate(TKeyCode{ '\x1B', '[', '1', '1', '~' }) == KC_F1);
+            ASS(keys.translate(TKeyCode{ 'a' }) == TKeyCode{ 'a' });
+        }
+        EXE(std::ofstream(source, std::ios::binary) << terminfo_image({ { 87, "\x1BOA" } }));
+        {
+            TTerminalKeys keys("sib-test", cache.string());
+            ASS(keys.size() == 1 and not keys.from_cache());
+        } {
+            TTerminalKeys keys("sib-test", cache.string());
+            ASS(keys.size() == 1 and keys.from_cache());
+        }
+
+        // GetKey translates by the table put in place of the $TERM one
+        TKeyCode translated, passed;
+        {
+            TTerminalKeys keys("sib-test", {});
+            TPtyStdin     pty;
+            pty.write("\x1BOA");
+            TTerminalKeys::set_current(&keys);
+            translated = GetKey();
+            TTerminalKeys::set_current(&no_keys);
+            pty.write("\x1BOA");
+            passed = GetKey();
+        }
+        ASS(translated == KC_UP);
+        ASS(passed == TKeyCode{ '\x1B', 'O', 'A' });
+        EXE(saved.empty() ? ::unsetenv("TERMINFO") : ::setenv("TERMINFO", saved.c_str(), 1));
+        EXE(fs::remove_all(root));
+        END;
+    } {
+        BEG;
+        // more pieces than one writev takes, into a pipe far smaller than the text: the writes come
+        // out short and resume inside a piece
+        std::vector<std::string>      texts;
+        std::vector<std::string_view> pieces;
+        std::string                   expected;
+        for (int i = 0; i < 300; ++i) texts.push_back(std::string(size_t(1 + i * 37 % 900), char('a' + i % 26)));
+        for (auto const& text : texts) { pieces.push_back(text); expected += text; }
+        ASS(pieces.size() > 64 and expected.size() > 16 * 4096);
+
+        sib::debug::outstream.flush();
+        bool   ok      = false;
+        size_t written = 0;
+        std::string got;
+        {
+            TPipeStdout pipe;
+            ok  = WriteOutput(pieces, written);
+            got = pipe.finish();
+        }
+        ASS(ok and written == expected.size());
+        ASS(got == expected);
+        END;
+
+        // the reader gives up: the write fails and tells how much got through
+        auto old_pipe = ::signal(SIGPIPE, SIG_IGN);
+        {
+            TPipeStdout pipe(10000);
+            ok  = WriteOutput(pieces, written);
+            got = pipe.finish();
+        }
+        ::signal(SIGPIPE, old_pipe);
+        ASS(not ok);
+        ASS(got == expected.substr(0, 10000));
+        ASS(written >= got.size() and written < expected.size());
+        END;
+    } {
+        BEG;
+        TKeyCode key, none;
+        {
+            TPtyStdin pty;
+            pty.write("ab\n");
+            key  = WaitKeyCodes({ KC_ENTER });
+            none = WaitAnyKeyFor(20ms);
+        }
+        ASS(key == KC_ENTER);
+        ASS(none == KC_EMPTY);
+        END;
+    } {
+        BEG;
+        // the deadline and a cancel from another thread end the wait without a key, in bounded time
+        TKeyCode         until, cancelled, cut, finished;
+        TClock::duration until_time{}, cancel_time{};
+        {
+            TPtyStdin pty;
+            auto start = TClock::now();
+            until      = WaitAnyKeyUntil(start + 30ms);
+            until_time = TClock::now() - start;
+
+            TCancelToken token;
+            std::thread  canceller([&] { std::this_thread::sleep_for(30ms); token.cancel(); });
+            start       = TClock::now();
+            cancelled   = WaitAnyKeyFor(10s, &token);
+            cancel_time = TClock::now() - start;
+            canceller.join();
+
+            // a sequence cut by the deadline is finished by the next call, not read as a new key
+            int saved_timeout = KEY_SEQUENCE_TIMEOUT_MS;
+            KEY_SEQUENCE_TIMEOUT_MS = 500;
+            pty.write("\x1B[");
+            cut = WaitAnyKeyFor(20ms);
+            pty.write("A");
+            finished = WaitAnyKeyFor(1s);
+            KEY_SEQUENCE_TIMEOUT_MS = saved_timeout;
+        }
+        ASS(until == KC_EMPTY and until_time >= 30ms and until_time < 1s);
+        ASS(cancelled == KC_EMPTY and cancel_time >= 30ms and cancel_time < 1s);
+        ASS(cut == KC_EMPTY);
+        ASS(finished == KC_UP);
+        END;
+    } {
+        BEG;
+        std::string text(1 << 20, 'x');
+        size_t pasted = 0;
+        {
+            TPtyStdin pty;
+            std::thread writer([&] { pty.write("\x1B[200~" + text + "\x1B[201~"); });
+            pasted = GetInput().text.size();
+            writer.join();
+        }
+        ASS(pasted == text.size());
+        END;
+
+        // an empty paste is skipped, not taken for the end of input
+        TInput after_empty;
+        {
+            TPtyStdin pty;
+            pty.write("\x1B[200~\x1B[201~" "a");
+            after_empty = GetInput();
+        }
+        ASS(not after_empty.is_end() and after_empty.key == TKeyCode{ 'a' });
+        END;
+    } {
+        BEG;
+        // key bindings: a chord, a mode switch and a layer over the normal mode
+        TKeyCode const ctrl_x{ '\x18' }, ctrl_s{ '\x13' };
+        int saved = 0, quit = 0, step = 0;
+        TKeyCode last;
+        DEF(TKeyBindings, bindings, ("normal"));
+        EXE(auto debug = bindings.add_mode("debug", 0));
+        EXE(bindings.bind(0, { ctrl_x, ctrl_s }, [&saved] { ++saved; }));
+        EXE(bindings.bind(0, { { 'q' } }, [&quit] { ++quit; }));
+        EXE(bindings.bind(0, { KC_F5 }, {}, debug));
+        EXE(bindings.bind(debug, { KC_F10 }, [&step, &last](TKeyCode key) { ++step; last = key; }));
+        EXE(bindings.bind(debug, { KC_ESC }, {}, 0));
+        EXE(bindings.compile());
+        ASS(bindings.key(ctrl_x) == TKeyBindings::TResult::Pending);
+        ASS(bindings.key(ctrl_s) == TKeyBindings::TResult::Done and saved == 1);
+        ASS(bindings.key({ 'w' }) == TKeyBindings::TResult::Unbound);
+        // a key breaking a chord is taken on its own
+        ASS(bindings.key(ctrl_x) == TKeyBindings::TResult::Pending);
+        ASS(bindings.key({ 'q' }) == TKeyBindings::TResult::Done and quit == 1);
+        ASS(bindings.key(KC_F10) == TKeyBindings::TResult::Unbound);
+        ASS(bindings.key(KC_F5) == TKeyBindings::TResult::Done and bindings.mode() == debug);
+        ASS(bindings.key(KC_F10) == TKeyBindings::TResult::Done and step == 1 and last == KC_F10);
+        // the normal mode works under the debug one
+        ASS(bindings.key({ 'q' }) == TKeyBindings::TResult::Done and quit == 2);
+        ASS(bindings.key(KC_ESC) == TKeyBindings::TResult::Done and bindings.mode_name(bindings.mode()) == "normal");
+        END;
+
+        // a chord continuing a shorter one of the same mode can not be reached
+        EXE(bindings.bind(0, { ctrl_x }, {}));
+        bool conflict = false;
+        try { bindings.compile(); } catch (std::logic_error const&) { conflict = true; }
+        ASS(conflict);
+        END;
+
+        PRF(sib::debug::TPerfBudget().allocs(0),
+            static auto fast = [] {
+                static int count = 0;
+                TKeyBindings res;
+                res.bind(0, { KC_UP }, [] { ++count; });
+                res.compile();
+                return res;
+            }();
+            auto res = fast.key(KC_UP);
+            sib::debug::do_not_optimize(res));
+        END;
+
+        // dispatched by the event loop, unbound keys reach on_key
+        std::vector<TKeyCode> unbound;
+        {
+            TKeyBindings loop_bindings;
+            loop_bindings.bind(0, { ctrl_x, ctrl_s }, [&saved] { ++saved; });
+            TPtyStdin pty;
+            TEventLoop loop;
+            loop.set_bindings(&loop_bindings);
+            loop.on_key([&](TKeyCode key) { unbound.push_back(key); });
+            pty.write("\x18\x13" "a" "\x1B[A");
+            for (int i = 0; i < 50 and unbound.size() < 2; ++i) loop.run_once(20);
+        }
+        ASS(saved == 2);
+        ASS(unbound == std::vector<TKeyCode>{ { 'a' }, KC_UP });
+        END;
+    } {
+        BEG;
+        auto single = key_latency("x", 1000);
+        MSG("single key latency  : median " + fmt(single.median_us, " us") + ", p99 " + fmt(single.p99_us, " us"));
+
+        auto arrow = key_latency("\x1B[A", 1000);
+        MSG("arrow key latency   : median " + fmt(arrow.median_us, " us") + ", p99 " + fmt(arrow.p99_us, " us"));
+
+        auto esc = key_latency("\x1B", 20);
+        MSG("lone ESC latency    : median " + fmt(esc.median_us, " us") + ", p99 " + fmt(esc.p99_us, " us"));
+        ASS(esc.median_us >= KEY_SEQUENCE_TIMEOUT_MS * 1000.0);
+
+        // the budgets are scaled by the machine speed and taken on the median of samples
+        {
+            TPtyStdin pty;
+            PRF(sib::debug::TPerfBudget().ns(2'000'000),
+                pty.write("x");
+                auto code = GetKey();
+                sib::debug::do_not_optimize(code));
+            PRF(sib::debug::TPerfBudget().ns(2'000'000),
+                pty.write("\x1B[A");
+                auto code = GetKey();
+                sib::debug::do_not_optimize(code));
+        }
+
+        // a timer waking the event loop more often than the sequence timeout neither delays keys
+        // nor holds back a lone ESC; the bounds are loose, only a lost or stuck key breaks them
+        auto loop_arrow = loop_key_latency("\x1B[A", 200, 10ms);
+        MSG("arrow in event loop : median " + fmt(loop_arrow.median_us, " us") + ", p99 " + fmt(loop_arrow.p99_us, " us"));
+        ASS(loop_arrow.median_us < 20'000);
+
+        auto loop_esc = loop_key_latency("\x1B", 20, 10ms);
+        MSG("ESC in event loop   : median " + fmt(loop_esc.median_us, " us") + ", p99 " + fmt(loop_esc.p99_us, " us"));
+        ASS(loop_esc.median_us >= KEY_SEQUENCE_TIMEOUT_MS * 1000.0);
+        ASS(loop_esc.median_us < KEY_SEQUENCE_TIMEOUT_MS * 1000.0 + 200'000);
+
+        std::string arrows;
+        for (int i = 0; i < 20000; ++i) arrows += "\x1B[A";
+        auto keys = throughput(arrows, 20000, [] { return GetKey().size() == 3 ? 1 : 0; });
+        MSG("burst throughput    : " + fmt(keys, " keys/s"));
+
+        std::string paste = "\x1B[200~" + std::string(4 << 20, 'x') + "\x1B[201~";
+        auto bytes = throughput(paste, 4 << 20, [] { return GetInput().text.size(); });
+        MSG("paste throughput    : " + fmt(bytes / (1 << 20), " MiB/s"));
+        END;
+    }
+
+    return 0;
+}
+
+#else
+
+DEF_TEST(test_console_pty)
+{
+    sib::debug::Init();
+    MSG("test_console_pty: pseudo-terminals are POSIX only");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,152 @@
+﻿#include "test_screen.h"
+#include "sib_unit_test.h"
+#include "sib_screen.h"
+
+#include <string>
+#include <string_view>
+
+#if !defined(_WIN32)
+    #include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    #if !defined(_WIN32)
+
+        // what `action` writes to stdout, read back through a pipe
+        template <typename TAction>
+        std::string captured_stdout(TAction&& action)
+        {
+            int fds[2];
+            if (::pipe(fds) != 0) return "<no pipe>";
+            int saved = ::dup(STDOUT_FILENO);
+            ::dup2(fds[1], STDOUT_FILENO);
+            ::close(fds[1]);
+
+            action();
+
+            ::dup2(saved, STDOUT_FILENO);
+            ::close(saved);
+            std::string res;
+            char buf[4096];
+            for (ssize_t bytes; (bytes = ::read(fds[0], buf, sizeof(buf))) > 0; ) res.append(buf, size_t(bytes));
+            ::close(fds[0]);
+            return res;
+        }
+
+    #endif
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+DEF_TEST(test_screen)
+{
+    using namespace sib::console;
+
+    sib::debug::Init();
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                             sib_screen                                             ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    {
+        BEG;
+        DEF(TScreen, screen, (20, 3));
+        EXE(screen.print(0, 0, "hello"));
+        EXE(std::string first(screen.render()));
+        ASS(first.find("\x1B[2J") != std::string::npos);
+        ASS(first.find("hello") != std::string::npos);
+        // nothing changed - nothing to write
+        ASS(screen.render().empty());
+        END;
+
+        // one cell: a cursor move and the character
+        EXE(screen.print(4, 0, "!"));
+        ASS(screen.render() == "\x1B[?25l\x1B[1;5H!");
+        END;
+
+        // a short gap with the same attributes is rewritten instead of moving the cursor
+        EXE(screen.print(0, 1, "a"));
+        EXE(screen.print(2, 1, "c"));
+        ASS(screen.render() == "\x1B[?25l\x1B[2;1Ha c");
+        END;
+
+        // attributes are switched only when they change and reset at the end of the frame
+        EXE(screen.print(0, 2, "ab", TAttr{ 1, COLOR_DEFAULT, STYLE_BOLD }));
+        ASS(screen.render() == "\x1B[?25l\x1B[3;1H\x1B[0;1;31mab\x1B[0m");
+        END;
+
+        // UTF-8 text takes one cell per code point
+        EXE(screen.print(10, 0, "Жук"));
+        ASS(screen.at(11, 0)->ch == U'у');
+        ASS(screen.render() == "\x1B[?25l\x1B[1;11HЖук");
+        END;
+    } {
+        BEG;
+        // the cursor goes down, back or to the row start by a relative move when it is shorter than CUP
+        DEF(TScreen, screen, (20, 4));
+        EXE(screen.render());
+        EXE(screen.print(5, 0, "x"));
+        EXE(screen.print(6, 1, "y"));
+        EXE(screen.print(0, 2, "z"));
+        EXE(screen.print(5, 2, "w"));
+        ASS(screen.render() == "\x1B[?25l\x1B[1;6Hx\x1B[By\x1B[B\rz\x1B[4Cw");
+        END;
+
+        EXE(screen.print(15, 0, "u"));
+        EXE(screen.print(2, 3, "v"));
+        ASS(screen.render() == "\x1B[?25l\x1B[1;16Hu\x1B[4;3Hv");
+        END;
+
+        EXE(screen.print(9, 1, "p"));
+        EXE(screen.print(4, 1, "q"));
+        ASS(screen.render() == "\x1B[?25l\x1B[2;5Hq\x1B[4Cp");
+        END;
+
+        EXE(screen.print(7, 3, "s"));
+        EXE(screen.cursor(8, 2));
+        ASS(screen.render() == "\x1B[?25l\x1B[4;8Hs\x1B[A\x1B[?25h");
+        END;
+    } {
+        #if !defined(_WIN32)
+            BEG;
+            // a screen that left the cursor hidden shows it again, one that only rendered writes nothing
+            auto hidden = captured_stdout([] { TScreen screen(4, 1); screen.print(0, 0, "a"); screen.present(); });
+            ASS(hidden.ends_with("a\x1B[?25h"));
+            auto shown = captured_stdout([] { TScreen screen(4, 1); screen.cursor(1, 0); screen.present(); });
+            ASS(shown.ends_with("\x1B[?25h") and not shown.ends_with("\x1B[?25h\x1B[?25h"));
+            auto rendered = captured_stdout([] { TScreen screen(4, 1); screen.print(0, 0, "a"); screen.render(); });
+            ASS(rendered.empty());
+            END;
+        #endif
+    } {
+        BEG;
+        // a status view where one counter changes per frame
+        TScreen screen(80, 24);
+        auto draw = [&](int frame) {
+            for (int y = 0; y < 24; ++y)
+                screen.print(0, y, "line " + std::to_string(y) + ": monitoring value of the process and its status");
+            screen.print(0, 23, "frame " + std::to_string(frame), TAttr{ 2, COLOR_DEFAULT, STYLE_REVERSE });
+        };
+
+        draw(0);
+        size_t full = screen.render().size();
+        size_t diff = 0;
+        for (int frame = 1; frame <= 100; ++frame)
+        {
+            draw(frame);
+            diff += screen.render().size();
+        }
+        diff /= 100;
+        MSG("full frame: " + std::to_string(full) + " bytes, changed counter: " + std::to_string(diff) + " bytes per frame");
+        ASS(diff * 10 < full);
+        END;
+    }
+
+    return 0;
+}
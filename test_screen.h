@@ -0,0 +1,5 @@
+﻿#pragma once
+
+#include "sib_unit_test.h"
+
+DEF_TEST(test_screen);
@@ -0,0 +1,336 @@
+﻿#include "test_string.h"
+#include "sib_unit_test.h"
+#include "sib_string.h"
+#include "sib_format.h"
+#include "sib_utf.h"
+#include "sib_rope.h"
+#include "sib_support.h"
+
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <forward_list>
+#include <list>
+#include <type_traits>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    struct TPoint { int x, y; };
+
+    std::ostream& operator<< (std::ostream& os, TPoint const& pt) { return os << '(' << pt.x << ", " << pt.y << ')'; }
+
+    template <typename... Args>
+    std::string streamed(Args const&... args)
+    {
+        std::ostringstream os;
+        (os << ... << args);
+        return os.str();
+    }
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+DEF_TEST(test_string)
+{
+    using namespace std::string_view_literals;
+
+    sib::debug::Init();
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                             sib_string                                             ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    {
+        BEG;
+        // display width
+        ASS(sib::display_width(""sv) == 0);
+        ASS(sib::display_width("plain ascii text, longer than a word"sv) == 36);
+        ASS(sib::display_width("Жук"sv) == 3);
+        ASS(sib::display_width("ascii and then Жук"sv) == 18);
+        ASS(sib::display_width("漢字"sv) == 4);
+        ASS(sib::display_width("é"sv) == 1);
+        ASS(sib::display_width("\xFF\xFE"sv) == 2);
+        ASS(sib::display_width(std::u16string(u"漢\U0001F600")) == 4);
+        ASS(sib::display_width(std::u32string(U"Жук")) == 3);
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(0),
+            static std::string const text(4096, 'x');
+            auto width = sib::display_width(std::string_view(text));
+            sib::debug::do_not_optimize(width));
+    } {
+        BEG;
+        // utf transcoding
+        auto to = []<typename Dst, typename Src>(std::basic_string_view<Src> text, Dst) {
+            std::basic_string<Dst> out;
+            return sib::append_transcoded(out, text);
+        };
+        auto round_trip = [&](std::string_view text) {
+            auto u16 = to(text, char16_t());
+            auto u32 = to(std::u16string_view(u16), char32_t());
+            auto w   = to(std::u32string_view(u32), wchar_t());
+            return u32.size() == sib::transcoded_length<char32_t>(text)
+                and u16.size() == sib::transcoded_length<char16_t>(text)
+                and to(std::wstring_view(w), char()) == text
+                and to(std::u32string_view(u32), char()) == text
+                and to(std::u16string_view(u16), char()) == text;
+        };
+        auto runs = [&]() {
+            for (size_t len = 0; len < 72; ++len)
+                for (size_t pos : { len, size_t(0), len / 2, len ? len - 1 : 0 })
+                {
+                    std::string text(len, 'a');
+                    if (pos < len) text.replace(pos, 1, "Ж");
+                    if (not round_trip(text)) return false;
+                }
+            return true;
+        };
+        ASS(round_trip("Жук ascii 漢字 \U0001F600 and a long ASCII tail to cover the vector loops"));
+        ASS(runs());
+        ASS(to("\xFF|\xE0\x80\x80|\xED\xA0\x80"sv, char32_t()) == U"\uFFFD|\uFFFD\uFFFD\uFFFD|\uFFFD\uFFFD\uFFFD");
+        ASS(to(std::u16string_view(u"a\xD800" u"b\xDC00"), char()) == "a\uFFFDb\uFFFD");
+        ASS(to(std::u32string_view(std::u32string(1, char32_t(0x110000))), char16_t()) == u"\uFFFD");
+        ASS(sib::debug::TString(std::u16string(u"Жук")) == "Жук");
+        ASS(sib::debug::TString(U"Жук", 1, std::wstring(L"ёж")) == "Жук1ёж");
+        ASS((sib::debug::TBufer() << std::u32string(U"Жук")).view() == "Жук");
+        ASS(sib::debug::bufer_char_to_str(u'Ж') == "Ж");
+        ASS(sib::debug::bufer_char_to_str(char8_t(0xD0)) == "\\i208");
+        ASS(sib::debug::bufer_char_to_str(char16_t(0xD800)) == "\\i55296");
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(0),
+            static std::string const text = [] { std::string t; for (int i = 0; i < 128; ++i) t += "Журнал теста: ascii run "; return t; }();
+            static std::u16string out(text.size(), u' ');
+            out.clear();
+            sib::append_transcoded(out, std::string_view(text));
+            sib::debug::do_not_optimize(out.size()));
+    } {
+        BEG;
+        // disclosure escapes strings in bulk exactly as char by char
+        auto by_char = []<typename Src>(std::basic_string_view<Src> text) {
+            sib::debug::TString out;
+            for (auto ch : text) out += sib::debug::bufer_char_to_str(ch);
+            return out;
+        };
+        auto same = [&]<typename Src>(std::basic_string_view<Src> text) {
+            for (size_t first = 0; first < text.size(); first += 7)
+            {
+                sib::debug::TString out;
+                sib::debug::append_bufer_chars(out, text.substr(first));
+                if (out != by_char(text.substr(first))) return false;
+            }
+            return true;
+        };
+        EXE(std::string bytes);
+        EXE(for (int i = 0; i < 256; ++i) bytes += std::string(40, 'a') + char(i));
+        EXE(std::u16string u16 = u"Жук \\ \"q\" \t \x7F \xD83D\xDE00 \x85 ещё немного текста подлиннее");
+        EXE(std::u32string u32 = U"Жук \\ \"q\" \t \x7F \U0001F600 \x85 ещё немного текста подлиннее");
+        ASS(same(std::string_view(bytes)));
+        ASS(same(std::u16string_view(u16)));
+        ASS(same(std::u32string_view(u32)));
+        ASS(sib::debug::bufer_char_to_str('\x7F') == "\\i127");
+        ASS(sib::debug::bufer_char_to_str(char(0xD0)) == "\\i4294967248");
+        EXE(auto length = sib::debug::CONTAINER_DISCLOSURE_LENGTH);
+        EXE(sib::debug::CONTAINER_DISCLOSURE_LENGTH = 16);
+        ASS(sib::debug::disclosure(std::string("a\tb")) == "\"a\\tb\"");
+        ASS(sib::debug::disclosure(std::string(20, 'x')) == "\"" + std::string(16, 'x') + "...");
+        ASS(sib::debug::disclosure(std::string(16, 'x')) == "\"" + std::string(16, 'x') + "\"");
+        ASS(sib::debug::disclosure(std::u16string(u"Жук")) == "\"Жук\"");
+        ASS(sib::debug::disclosure(std::forward_list<char>{ 'a', '\n' }) == "\"a\\n\"");
+        ASS(sib::debug::disclosure(std::forward_list<char>(20, 'y')) == "\"" + std::string(16, 'y') + "...");
+        ASS(sib::debug::disclosure(std::list<char>(16, 'z')) == "\"" + std::string(16, 'z') + "\"");
+        // a char pointer shows the character it points to, as before
+        EXE(char const* text = "pointer text");
+        ASS(sib::debug::disclosure(text).ends_with("] { 'p' }"));
+        EXE(sib::debug::CONTAINER_DISCLOSURE_LENGTH = length);
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(1),
+            static std::string const text = [] { std::string t; for (int i = 0; i < 64; ++i) t += "a clean line of log text, "; return t; }();
+            auto previous = sib::debug::CONTAINER_DISCLOSURE_LENGTH;
+            sib::debug::CONTAINER_DISCLOSURE_LENGTH = text.size();
+            auto shown = sib::debug::disclosure(text);
+            sib::debug::CONTAINER_DISCLOSURE_LENGTH = previous;
+            sib::debug::do_not_optimize(shown));
+    } {
+        BEG;
+        // aligned_string
+        ASS(sib::aligned_string(std::string("ab"), 6, sib::TPositionHor::Left  , '.') == "ab....");
+        ASS(sib::aligned_string(std::string("ab"), 6, sib::TPositionHor::Right , '.') == "....ab");
+        ASS(sib::aligned_string(std::string("ab"), 5, sib::TPositionHor::Center, '.') == ".ab..");
+        ASS(sib::aligned_string(std::string("Жук"), 5, sib::TPositionHor::Right, ' ') == "  Жук");
+        ASS(sib::aligned_string(std::string("too wide"), 3, sib::TPositionHor::Left, ' ') == "too wide");
+        END;
+    } {
+        BEG;
+        // tab stops
+        auto widths = sib::console::TAB_WIDTH;
+        auto def    = sib::console::TAB_DEF_WIDTH;
+        EXE(sib::console::TAB_WIDTH = { 2, 3, 5 });
+        EXE(sib::console::TAB_DEF_WIDTH = 4);
+        ASS(sib::console::tab_pos(0) == 2);
+        ASS(sib::console::tab_pos(2) == 10);
+        ASS(sib::console::tab_pos(4) == 18);
+        ASS(sib::console::tab_width(4) == 4);
+        EXE(sib::console::TAB_WIDTH = widths);
+        EXE(sib::console::TAB_DEF_WIDTH = def);
+        END;
+    } {
+        BEG;
+        // table layout
+        DEF(sib::table_layout<std::string>, table, ({ { 3 }, { 4, sib::TPositionHor::Right }, {} }, "| ", " | "));
+        ASS(table.offset(1) == 8);
+        ASS(table.blank() == "|     |      | ");
+        EXE(std::string out);
+        EXE(out.reserve(table.row_size({ "a", "12", "first\nsecond" }) + table.row_size({ "Жук", "", "x\n" })));
+        EXE(auto cap = out.capacity());
+        EXE(table.append_row(out, { "a", "12", "first\nsecond" }));
+        EXE(table.append_row(out, { "Жук", "", "x\n" }));
+        ASS(out ==
+            "| a   |   12 | first\n"
+            "|     |      | second\n"
+            "| Жук |      | x\n");
+        ASS(out.capacity() == cap);
+        END;
+    } {
+        BEG;
+        // promiscuous_string builder formats like the stream
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+        ASS(sib::debug::TString().empty());
+        ASS(sib::debug::TString("n=", 42, ", m=", -7, '!') == "n=42, m=-7!");
+        ASS(sib::debug::TString(std::numeric_limits<long long>::min(), ' ', std::numeric_limits<unsigned long long>::max())
+            == streamed(std::numeric_limits<long long>::min(), ' ', std::numeric_limits<unsigned long long>::max()));
+        ASS(sib::debug::TString(0.1, ' ', 1e20, ' ', 123456789.0, ' ', 1.0 / 3, ' ', -0.0, ' ', 1e-5, ' ', 100000.0)
+            == streamed(0.1, ' ', 1e20, ' ', 123456789.0, ' ', 1.0 / 3, ' ', -0.0, ' ', 1e-5, ' ', 100000.0));
+        ASS(sib::debug::TString(inf, ' ', -inf, ' ', nan, ' ', 2.5f, ' ', 1e300L) == streamed(inf, ' ', -inf, ' ', nan, ' ', 2.5f, ' ', 1e300L));
+        ASS(sib::debug::TString(true, false, (signed char)'s', (unsigned char)'u') == "10su");
+        ASS(sib::debug::TString(std::string("str"), "sv"sv, (char const*)"ptr") == "strsvptr");
+        ASS(sib::debug::TString(L"wide ", std::wstring(L"string "), std::u16string_view(u"view")) == "wide string view");
+        ASS(sib::debug::TString(std::list<char>{ 'l', 's' }, std::vector<char32_t>{ U'v', U'c' }) == "lsvc");
+        ASS(sib::debug::TString("pt=", TPoint{ 1, 2 }, " ", nullptr) == streamed("pt=", TPoint{ 1, 2 }, " ", nullptr));
+        ASS(sib::promiscuous_string<wchar_t>(L"w", 12, "narrow", 0.5) == L"w12narrow0.5");
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(1),
+            static std::string const what = "an exception message long enough to leave small buffer";
+            sib::debug::TString message("Test stopped due to exception [", 42, "] ", 3.25, what);
+            sib::debug::do_not_optimize(message));
+    } {
+        BEG;
+        // promiscuous_stringstream on the arena buffer
+        DEF(sib::debug::TBufer, buf, );
+        EXE(buf << "x=" << std::setw(4) << 42 << ' ' << std::fixed << std::setprecision(2) << 0.5 << std::wstring(L" wide"));
+        ASS(buf.view() == "x=  42 0.50 wide");
+        ASS(buf.str() == buf.view());
+        EXE(buf << std::string(300, '-'));
+        ASS(buf.view().size() == 316 and buf.view().substr(0, 6) == "x=  42");
+        EXE(buf.str({}));
+        ASS(buf.view().empty());
+        EXE(buf << 12 << ' ' << 34);
+        EXE(int a = 0);
+        EXE(int b = 0);
+        ASS((buf >> a >> b) and a == 12 and b == 34);
+        EXE(std::string moved = std::move(buf).str());
+        ASS(moved == "12 34" and buf.view().empty());
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(0),
+            sib::debug::TBufer temp;
+            temp << "a line of a report, long enough to leave small buffer: " << 12345 << ' ' << 2.5;
+            sib::debug::do_not_optimize(temp.view().size()));
+    } {
+        BEG;
+        // format
+        ASS(sib::format("a{}b{}", 1, "xy") == "a1bxy");
+        ASS(sib::format("{1}{0} {{}} {0:.2}", "xyz", 7) == "7xyz {} xy");
+        ASS(sib::format("[{:>5}|{:<4}|{:^7}|{:*^7}]", "ab", -3, 2.5, true) == "[   ab|-3  |  2.5  |*true**]");
+        ASS(sib::format("{:#x} {:#X} {:b} {:#o} {:+} {: d} {:05}", 255, 255, 5, 8, 1, 2, -42) == "0xff 0XFF 101 010 +1  2 -0042");
+        ASS(sib::format("{:08.3f} {:e} {:G} {} {}", -3.14159, 12345.678, 1e-10, 0.1, 1e20) == "-003.142 1.234568e+04 1E-10 0.1 1e+20");
+        ASS(sib::format("{:c}{}{:d}{:s}{:d}", 65, 'b', 'c', false, true) == "Ab99false1");
+        ASS(sib::format("{:p} {} {}", (void*)0x10, nullptr, std::list<char>{ 'l' }) == "0x10 0x0 l");
+        ASS(sib::format("{:.3}|{:>4}|", "Жуков", "Жук") == "Жук| Жук|");
+        ASS(sib::format(U"{} {}", std::u16string(u"wide"), 3) == "wide 3");
+        ASS(sib::format<char>(u"[{:Ж^5}]", 1) == "[ЖЖ1ЖЖ]");
+        ASS(sib::format<char>(U"[{:é<3}]", 'x') == "[xéé]");
+        ASS(sib::format<char16_t>(U"[{:😀>2}]", 7) == u"[😀7]");
+        ASS(sib::format<wchar_t>(L"{}:{:02}", std::string("narrow"), 5) == L"narrow:05");
+        ASS(sib::format<sib::debug::OutStrmCh>(SIB_DEGUG_LITERAL("{} of {}"), 1, 2) == SIB_DEGUG_LITERAL("1 of 2"));
+        EXE(std::string out = "log: ");
+        ASS(sib::format_to(out, "{:>3}%", 42) == "log:  42%");
+        END;
+
+        // integer presentations of characters keep the sign of the type, as std::format
+        ASS(sib::format("{:d} {:x} {:d} {:b}", (signed char)-56, (signed char)-1, (unsigned char)200, (signed char)-3) == "-56 -1 200 -11");
+        ASS(sib::format("{:d} {:x}", char(-56), char(-1)) == (std::is_signed_v<char> ? "-56 -1" : "200 ff"));
+        ASS(sib::format("{:#x} {:d} {:c}", (signed char)-1, u'Ж', (signed char)65) == "-0x1 1046 A");
+        END;
+
+        // a string of more segments than format_string keeps is parsed by the call
+        ASS(sib::format_string<int>("{{{{{{{{{{{{}}}}}}}}}}}}{0}{0}{0}{0}").resolved() == false);
+        ASS(sib::format("{{{{{{{{{{{{}}}}}}}}}}}}{0}{0}{0}{0}", 5) == "{{{{{{}}}}}}5555");
+        ASS(sib::format_string<int, int>("a{}b{}c").segments().size() == 5);
+        END;
+
+        // formatting stays well below its stream equivalent
+        PRF(sib::debug::TPerfBudget().ns(1'500).allocs(1),
+            auto text = sib::format("Test {:<24} {:>6} of {:>6} {:8.2f} ms", "a rather long test name", 12, 345, 6.789);
+            sib::debug::do_not_optimize(text));
+        PRF(sib::debug::TPerfBudget().ns(5'000).allocs(0),
+            sib::debug::TBufer buf;
+            buf << "Test " << std::left << std::setw(24) << "a rather long test name" << ' ' << std::right << std::setw(6) << 12
+                << " of " << std::setw(6) << 345 << ' ' << std::fixed << std::setprecision(2) << std::setw(8) << 6.789 << " ms";
+            sib::debug::do_not_optimize(buf.view().size()));
+    } {
+        BEG;
+        // promiscuous_rope shares its chunks
+        using TRope = sib::promiscuous_rope<char>;
+        EXE(static std::string const borrowed(100, 'b'));
+        EXE(TRope rope);
+        EXE(rope.append("head: ").append(3, '=').push_back(' '));
+        ASS(rope.chunks().size() == 1 and rope.str() == "head: === ");
+        EXE(rope.append_borrowed(borrowed));
+        ASS(rope.chunks().size() == 2 and rope.chunks()[1].text.data() == borrowed.data());
+        EXE(TRope::string_type owned(std::string(200, 'o')));
+        EXE(auto const* owned_data = owned.data());
+        EXE(rope += std::move(owned));
+        ASS(rope.chunks().size() == 3 and rope.chunks()[2].text.data() == owned_data);
+        EXE(rope += " tail");
+        ASS(rope.size() == 315 and rope.str() == "head: === " + std::string(100, 'b') + std::string(200, 'o') + " tail");
+        EXE(TRope copy = rope);
+        EXE(copy += '!');
+        ASS(copy.chunks()[2].text.data() == owned_data and copy.str().back() == '!' and rope.str().back() == 'l');
+        ASS(rope.substr(8, 4).str() == "= bb" and rope.substr(8, 4).chunks().size() == 2);
+        ASS(rope.substr(305).str() == "ooooo tail" and rope.substr(400).empty());
+        EXE(TRope joined("<"));
+        EXE(joined.append(rope).append(rope));
+        ASS(joined.size() == 1 + 2 * rope.size() and joined.chunks()[3].text.data() == owned_data);
+        ASS(streamed(rope) == rope.str());
+        END;
+        PRF(sib::debug::TPerfBudget().allocs(4),
+            static std::string const line(64, 'x');
+            TRope report;
+            report.reserve_chunks(2000);
+            for (int i = 0; i < 1000; ++i) { report.append("  | row | "); report.append_borrowed(line); }
+            sib::debug::do_not_optimize(report.size()));
+    } {
+        BEG;
+        // table rows in parts: the last cell stays as is
+        DEF(sib::table_layout<std::string>, table, ({ { 3 }, { 4, sib::TPositionHor::Right }, {} }, "| ", " | "));
+        EXE(std::string head);
+        EXE(table.append_head(head, { "a", "12", "first\nsecond\n" }));
+        ASS(head == "| a   |   12 | ");
+        EXE(std::string last);
+        EXE(table.for_last_cell("first\nsecond\n", [&](std::string_view piece) { last += piece; last += '|'; }));
+        ASS(last == "first\n||     |      | |second|");
+        EXE(std::string row);
+        EXE(table.append_row(row, { "a", "12", "first\nsecond\n" }));
+        ASS(row == head + "first\n|     |      | second\n");
+        END;
+    }
+
+    return 0;
+}
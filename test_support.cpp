@@ -0,0 +1,99 @@
+﻿#include "test_support.h"
+#include "sib_unit_test.h"
+#include "sib_support.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    sib::scope_timer_summary const* find_timer(std::vector<sib::scope_timer_summary> const& sums, std::string const& name)
+    {
+        auto it = std::find_if(sums.begin(), sums.end(), [&](auto const& sum) { return sum.name == name; });
+        return (it == sums.end()) ? nullptr : &*it;
+    }
+
+} // namespace
+
+DEF_TEST(test_support)
+{
+    using sib::latency_histogram;
+
+    sib::debug::Init();
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                            sib_support                                             ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    {
+        BEG;
+        // latency_histogram: counts and percentiles
+        DEF(latency_histogram, hist, );
+        ASS(hist.total() == 0 and hist.percentile(0.5) == 0);
+        EXE(for (std::uint64_t val = 1; val <= 1000; ++val) hist.record(val));
+        ASS(hist.total() == 1000);
+        ASS(hist.count(latency_histogram::bucket_of(7)) == 1);
+        ASS(hist.percentile(0.0) == 1);
+        // the bucket bound is at most 1/16 above the exact value
+        ASS(hist.percentile(0.5) >= 500 and hist.percentile(0.5) <= 500 + 500 / 16);
+        ASS(hist.percentile(0.9) >= 900 and hist.percentile(0.9) <= 900 + 900 / 16);
+        ASS(hist.percentile(1.0) >= 1000 and hist.percentile(1.0) <= 1000 + 1000 / 16);
+        DEF(latency_histogram, other, );
+        EXE(other.record(1u << 20));
+        EXE(hist.merge(other));
+        ASS(hist.total() == 1001 and hist.percentile(1.0) == latency_histogram::bucket_high(latency_histogram::bucket_of(1u << 20)));
+        END;
+    } {
+        BEG;
+        // SIB_SCOPE_TIMER: histograms of exited threads are kept by the registry
+        auto run = [](int times) {
+            for (int i = 0; i < times; ++i) { SIB_SCOPE_TIMER("test_support thread"); }
+        };
+        EXE(std::vector<std::thread> threads);
+        EXE(for (int i = 0; i < 8; ++i) threads.emplace_back(run, 10));
+        EXE(for (auto& thread : threads) thread.join());
+        EXE(auto sums = sib::scope_timers_summary());
+        EXE(auto const* sum = find_timer(sums, "test_support thread"));
+        ASS(sum and sum->count == 80);
+        ASS(sum and sum->p50 <= sum->p90 and sum->p90 <= sum->p99 and sum->p99 <= sum->p999 and sum->p999 <= sum->max);
+        // and a live thread adds to them
+        EXE(run(5));
+        EXE(sums = sib::scope_timers_summary());
+        EXE(sum  = find_timer(sums, "test_support thread"));
+        ASS(sum and sum->count == 85);
+        EXE(auto text = sib::scope_timers_text());
+        ASS(text.find("| Timer ") != std::string::npos);
+        ASS(text.find("| test_support thread      | 85         | ") != std::string::npos);
+        END;
+    } {
+        BEG;
+        // the allocation counter of PRF sees the whole operator new family
+        struct alignas(64) TWide { char data[64]; };
+        auto family = [] {
+            using sib::debug::detail::alloc_count;
+            using sib::debug::do_not_optimize;
+            auto before = alloc_count();
+            auto* one     = new int(1);                      do_not_optimize(one);     delete one;
+            auto* many    = new int[4];                      do_not_optimize(many);    delete[] many;
+            auto* one_nt  = new (std::nothrow) int(2);       do_not_optimize(one_nt);  delete one_nt;
+            auto* many_nt = new (std::nothrow) int[4];       do_not_optimize(many_nt); delete[] many_nt;
+            auto* wide    = new TWide();                     do_not_optimize(wide);
+            bool aligned  = reinterpret_cast<std::uintptr_t>(wide) % 64 == 0;  delete wide;
+            auto* wides   = new TWide[3];                    do_not_optimize(wides);   delete[] wides;
+            auto* wide_nt = new (std::nothrow) TWide();      do_not_optimize(wide_nt); delete wide_nt;
+            return aligned and (before < 0 or alloc_count() - before == 7);
+        };
+        ASS(family());
+        END;
+    }
+
+    return 0;
+}
@@ -190,7 +190,7 @@ DEF_TEST(test_type_traits)
         using T = __VA_ARGS__;                                      \
         if constexpr (std::is_default_constructible_v<T>)           \
             [[maybe_unused]] T tmp {};                              \
-        ASS(lp sib::is_like_pointer_v<__VA_ARGS__>);                \
+        SAS(lp sib::is_like_pointer_v<__VA_ARGS__>);                \
         TIS(deref_t<T>, dt);                                        \
         TIS(arrow_t<T>, at);                                        \
         END;                                                        \
@@ -222,7 +222,7 @@ DEF_TEST(test_type_traits)
         TM(           ,    int const &    ,     int const *    , set<int>::iterator                    );
         TM(           ,  TPointer<void>&  ,  TPointer<void>*   , vector<TPointer<void>>::iterator      );
         TM(           ,  TPointer2<int>&  ,  TPointer2<int>*   , vector<TPointer2<int>>::iterator      );
-        TM(           , int (&&) (double) ,        None        , TFn*                                  );
+        TM(           , int ( &) (double) ,        None        , TFn*                                  );
         TM(           , int ( &) (double) ,        None        , TPointer<TFn>                         );
         TM(           , int ( &) (double) ,        None        , TWrapper<TFn*>                        );
         TM(    not    ,       None        ,        None        , function<TFn>                         );
@@ -238,13 +238,13 @@ DEF_TEST(test_type_traits)
 
     {
         BEG;
-        ASS( sib::is_convertible_from_tooneof_v<int, float, std::string>);
+        SAS( sib::is_convertible_from_tooneof_v<int, float, std::string>);
         TIS( sib::convert_from_tooneof_select<int _ float _ std::string>, float);
-        ASS(!sib::is_convertible_from_tooneof_v<int, float, char, std::string>);
-        ASS(!sib::is_convertible_from_tooneof_v<int, std::string, std::vector<int>>);
-        ASS( sib::is_convertible_from_tooneof_v<int, std::string, sib::TWrapper<float>, std::vector<int>>);
+        SAS(!sib::is_convertible_from_tooneof_v<int, float, char, std::string>);
+        SAS(!sib::is_convertible_from_tooneof_v<int, std::string, std::vector<int>>);
+        SAS( sib::is_convertible_from_tooneof_v<int, std::string, sib::TWrapper<float>, std::vector<int>>);
         TIS( sib::convert_from_tooneof_select<int _ std::string _ sib::TWrapper<float> _ std::vector<int>>, sib::TValue<float>);
-        ASS(!sib::is_convertible_from_tooneof_v<int, std::string, sib::TWrapper<float>, std::vector<int>, sib::TWrapper<int>>);
+        SAS(!sib::is_convertible_from_tooneof_v<int, std::string, sib::TWrapper<float>, std::vector<int>, sib::TWrapper<int>>);
         END;
     } {
         struct C1 {};
@@ -269,32 +269,32 @@ DEF_TEST(test_type_traits)
         };
 
         BEG;
-        ASS(!std::is_convertible_v<C2, C4>);
-        ASS( std::is_constructible_v<C4, C2>);
-        ASS(!sib::is_convertible_from_to_v<C2, C4>);
-        ASS( sib::is_constructible_to_from_v<C4, C2>);
+        SAS(!std::is_convertible_v<C2, C4>);
+        SAS( std::is_constructible_v<C4, C2>);
+        SAS(!sib::is_convertible_from_to_v<C2, C4>);
+        SAS( sib::is_constructible_to_from_v<C4, C2>);
         END;
-        ASS(!sib::is_convertible_from_tooneof_v<C1, C2, C3>);
-        ASS( sib::is_convertible_from_tooneof_v<C3, C1, C2, C1>);
+        SAS(!sib::is_convertible_from_tooneof_v<C1, C2, C3>);
+        SAS( sib::is_convertible_from_tooneof_v<C3, C1, C2, C1>);
         TIS(sib::convert_from_tooneof_select<C3 _ C1 _ C2 _ C1>, C2);
-        ASS( sib::is_convertible_from_tooneof_v<C3, C2, C1, int>);
+        SAS( sib::is_convertible_from_tooneof_v<C3, C2, C1, int>);
         TIS(sib::convert_from_tooneof_select<C3 _ C2 _ C1 _ int>, C2);
-        ASS( sib::is_convertible_from_tooneof_v<C2, C2, C1, C3>);
+        SAS( sib::is_convertible_from_tooneof_v<C2, C2, C1, C3>);
         TIS(sib::convert_from_tooneof_select<C2 _ C2 _ C1 _ C3>, C2);
-        ASS( sib::is_convertible_from_tooneof_v<C2, C1, int, C3>);
+        SAS( sib::is_convertible_from_tooneof_v<C2, C1, int, C3>);
         TIS(sib::convert_from_tooneof_select<C2 _ C1 _ int _ C3>, int);
         END;
-        ASS(!sib::is_convertible_to_fromoneof_v<C1, C2, C3>);
-        ASS( sib::is_convertible_to_fromoneof_v<int, C1, C2, C3>);
+        SAS(!sib::is_convertible_to_fromoneof_v<C1, C2, C3>);
+        SAS( sib::is_convertible_to_fromoneof_v<int, C1, C2, C3>);
         TIS(sib::convert_to_fromoneof_select<int _ C1 _ C2 _ C3>, C2);
-        ASS( sib::is_convertible_to_fromoneof_v<C3, C2, C1, int>);
-        ASS( sib::is_convertible_to_fromoneof_v<C3, C1, int, MyClass>);
+        SAS( sib::is_convertible_to_fromoneof_v<C3, C2, C1, int>);
+        SAS( sib::is_convertible_to_fromoneof_v<C3, C1, int, MyClass>);
         TIS(sib::convert_to_fromoneof_select<C3 _ C1 _ int _ MyClass>, int);
-        ASS(!sib::is_convertible_to_fromoneof_v<C2, C2, C1, C3>);
-        ASS( sib::is_convertible_to_fromoneof_v<C2, C2>);
-        ASS(!sib::is_convertible_to_fromoneof_v<C2, C1>);
-        ASS( sib::is_convertible_to_fromoneof_v<C2, C3>);
-        ASS( sib::is_convertible_to_fromoneof_v<C2, C1, int, C3>);
+        SAS(!sib::is_convertible_to_fromoneof_v<C2, C2, C1, C3>);
+        SAS( sib::is_convertible_to_fromoneof_v<C2, C2>);
+        SAS(!sib::is_convertible_to_fromoneof_v<C2, C1>);
+        SAS( sib::is_convertible_to_fromoneof_v<C2, C3>);
+        SAS( sib::is_convertible_to_fromoneof_v<C2, C1, int, C3>);
         TIS(sib::convert_to_fromoneof_select<C2 _ C1 _ int _ C3>, C3);
         END;
     } {
@@ -314,19 +314,19 @@ DEF_TEST(test_type_traits)
         };
 
         BEG;
-        ASS(!sib::is_constructible_from_tooneof_v<C1, C2, C4, C3>);
-        ASS( sib::is_constructible_from_tooneof_v<C1, C2, C1, C3>);
+        SAS(!sib::is_constructible_from_tooneof_v<C1, C2, C4, C3>);
+        SAS( sib::is_constructible_from_tooneof_v<C1, C2, C1, C3>);
         TIS(sib::construct_from_tooneof_select<C1 _ C2 _ C1 _ C3>, C1);
-        ASS( sib::is_constructible_from_tooneof_v<C4, C2, C1, C3>);
+        SAS( sib::is_constructible_from_tooneof_v<C4, C2, C1, C3>);
         TIS(sib::construct_from_tooneof_select<C4 _ C2 _ C1 _ C3>, C1);
-        ASS(!sib::is_constructible_from_tooneof_v<C4, C2, C1, C4>);
+        SAS(!sib::is_constructible_from_tooneof_v<C4, C2, C1, C4>);
         END;
-        ASS(!sib::is_constructible_to_fromoneof_v<C5, C1, C2, C3>);
-        ASS( sib::is_constructible_to_fromoneof_v<C1, C2, C4, C3>);
+        SAS(!sib::is_constructible_to_fromoneof_v<C5, C1, C2, C3>);
+        SAS( sib::is_constructible_to_fromoneof_v<C1, C2, C4, C3>);
         TIS(sib::construct_to_fromoneof_select<C1 _ C2 _ C4 _ C3>, C4);
-        ASS( sib::is_constructible_to_fromoneof_v<C1, C2, C1, C3>);
+        SAS( sib::is_constructible_to_fromoneof_v<C1, C2, C1, C3>);
         TIS(sib::construct_to_fromoneof_select<C1 _ C2 _ C1 _ C3>, C1);
-        ASS(!sib::is_constructible_to_fromoneof_v<C1, C2, C4, C1, C3>);
+        SAS(!sib::is_constructible_to_fromoneof_v<C1, C2, C4, C1, C3>);
         END;
     }
 
@@ -481,47 +481,47 @@ DEF_TEST(test_types_pack)
         BEG;
         EXE(using Ts = _gen_TS(_C));
         MSG("      ", TS_to_Str<Ts>());
-        ASS(sib::types_info<Ts>::count == _C);
+        SAS(sib::types_info<Ts>::count == _C);
         END;
 
         EXE(using H = sib::types_head_t<_I, Ts>);
         MSG("      ", TS_to_Str<H>());
-        ASS(sib::types_info<H>::count == _I);
+        SAS(sib::types_info<H>::count == _I);
         END;
 
         EXE(using T = sib::types_tail_t<_I _ Ts>);
         MSG("      ", TS_to_Str<T>());
-        ASS(sib::types_info<T>::count == _I);
+        SAS(sib::types_info<T>::count == _I);
         END;
     } {
         BEG;
         EXE(using STs = sib::types_merge_sort_t<_TS<>>);
         TYP(STs);
-        ASS(sib::types_info<STs>::count == 0);
+        SAS(sib::types_info<STs>::count == 0);
         END;
     } {
         BEG;
         EXE(using STs = sib::types_quick_sort_t<_TS<>>);
         TYP(STs);
-        ASS(sib::types_info<STs>::count == 0);
+        SAS(sib::types_info<STs>::count == 0);
         END;
     } {
         BEG;
         EXE(using Ts = sib::types_concat_t<_gen_TS(_C), _gen_TS(_I)>);
         MSG("      ", TS_to_Str<Ts>());
-        ASS(sib::types_info<Ts>::count == _C + _I);
+        SAS(sib::types_info<Ts>::count == _C + _I);
         END;
 
         EXE(using mSTs = sib::types_merge_sort_t<Ts>);
         MSG("      ", TS_to_Str<mSTs>());
-        ASS(sib::types_info<mSTs>::count == _C + _I);
+        SAS(sib::types_info<mSTs>::count == _C + _I);
         END;
 
         using qSTs111 = sib::types_quick_sort_t<Ts>;
 
         EXE(using qSTs = sib::types_quick_sort_t<Ts>);
         MSG("      ", TS_to_Str<qSTs>());
-        ASS(sib::types_info<qSTs>::count == _C + _I);
+        SAS(sib::types_info<qSTs>::count == _C + _I);
         END;
 
         ASS(TS_to_Str<mSTs>() == TS_to_Str<qSTs>());
@@ -538,30 +538,30 @@ DEF_TEST(test_types_pack)
         BEG;
         EXE(using Ts = _TS<_TS<>, _TS<>, int, _TS<>, A, float, _TS<>, int, _TS<>>);
         TYP(Ts);
-        ASS(sib::types_info<Ts>::count == 9);
+        SAS(sib::types_info<Ts>::count == 9);
         END;
 
         EXE(using mSTs = sib::types_merge_sort_t<Ts>);
         TYP(mSTs);
-        ASS(sib::types_info<mSTs>::count == 9);
+        SAS(sib::types_info<mSTs>::count == 9);
         END;
 
         EXE(using qSTs = sib::types_quick_sort_t<Ts>);
         TYP(qSTs);
-        ASS(sib::types_info<qSTs>::count == 9);
+        SAS(sib::types_info<qSTs>::count == 9);
         END;
 
         EXE(using CmSTs = sib::types_erase_t<mSTs, _TS<>>);
         TYP(CmSTs);
-        ASS(sib::types_info<CmSTs>::count == 4);
+        SAS(sib::types_info<CmSTs>::count == 4);
         END;
 
         EXE(using CqSTs = sib::types_erase_t<qSTs, _TS<>>);
         TYP(CqSTs);
-        ASS(sib::types_info<CqSTs>::count == 4);
+        SAS(sib::types_info<CqSTs>::count == 4);
         END;
 
-        ASS(sib::Same<CmSTs, CqSTs>);
+        SAS(sib::Same<CmSTs, CqSTs>);
         END;
     } {
         BEG;
@@ -569,8 +569,8 @@ DEF_TEST(test_types_pack)
         #define _C 50
         EXE(using mSTs = sib::types_merge_sort_t<_gen_TS(_C)>);
         EXE(using qSTs = sib::types_quick_sort_t<_gen_TS(_C)>);
-        ASS(sib::types_info<mSTs>::count == _C);
-        ASS(sib::types_info<qSTs>::count == _C);
+        SAS(sib::types_info<mSTs>::count == _C);
+        SAS(sib::types_info<qSTs>::count == _C);
         END;
     }
 
@@ -638,45 +638,45 @@ DEF_TEST(test_types_list)
         BEG;
         EXE(using Ts = _gen_TS(_C));
         MSG("      ", TS_to_Str<Ts>());
-        ASS(sib::types_info<Ts>::count == _C);
+        SAS(sib::types_info<Ts>::count == _C);
         END;
 
         EXE(using H = sib::types_head_t<_I, Ts>);
         MSG("      ", TS_to_Str<H>());
-        ASS(sib::types_info<H>::count == _I);
+        SAS(sib::types_info<H>::count == _I);
         END;
 
         EXE(using T = sib::types_tail_t<_I _ Ts>);
         MSG("      ", TS_to_Str<T>());
-        ASS(sib::types_info<T>::count == _I);
+        SAS(sib::types_info<T>::count == _I);
         END;
     } {
         BEG;
         EXE(using STs = sib::types_merge_sort_t<_TS<>>);
         TYP(STs);
-        ASS(sib::types_info<STs>::count == 0);
+        SAS(sib::types_info<STs>::count == 0);
         END;
     } {
         BEG;
         EXE(using STs = sib::types_quick_sort_t<_TS<>>);
         TYP(STs);
-        ASS(sib::types_info<STs>::count == 0);
+        SAS(sib::types_info<STs>::count == 0);
         END;
     } {
         BEG;
         EXE(using Ts = sib::types_concat_t<_gen_TS(_C), _gen_TS(_I)>);
         MSG("      ", TS_to_Str<Ts>());
-        ASS(sib::types_info<Ts>::count == _C + _I);
+        SAS(sib::types_info<Ts>::count == _C + _I);
         END;
 
         EXE(using mSTs = sib::types_merge_sort_t<Ts>);
         MSG("      ", TS_to_Str<mSTs>());
-        ASS(sib::types_info<mSTs>::count == _C + _I);
+        SAS(sib::types_info<mSTs>::count == _C + _I);
         END;
 
         EXE(using qSTs = sib::types_quick_sort_t<Ts>);
         MSG("      ", TS_to_Str<qSTs>());
-        ASS(sib::types_info<qSTs>::count == _C + _I);
+        SAS(sib::types_info<qSTs>::count == _C + _I);
         END;
 
         ASS(TS_to_Str<mSTs>() == TS_to_Str<qSTs>());
@@ -693,30 +693,30 @@ DEF_TEST(test_types_list)
         BEG;
         EXE(using Ts = _TS<_TS<>, _TS<>, int, _TS<>, A, float, _TS<>, int, _TS<>>);
         TYP(Ts);
-        ASS(sib::types_info<Ts>::count == 9);
+        SAS(sib::types_info<Ts>::count == 9);
         END;
 
         EXE(using mSTs = sib::types_merge_sort_t<Ts>);
         TYP(mSTs);
-        ASS(sib::types_info<mSTs>::count == 9);
+        SAS(sib::types_info<mSTs>::count == 9);
         END;
 
         EXE(using qSTs = sib::types_quick_sort_t<Ts>);
         TYP(qSTs);
-        ASS(sib::types_info<qSTs>::count == 9);
+        SAS(sib::types_info<qSTs>::count == 9);
         END;
 
         EXE(using CmSTs = sib::types_erase_t<mSTs, _TS<>>);
         TYP(CmSTs);
-        ASS(sib::types_info<CmSTs>::count == 4);
+        SAS(sib::types_info<CmSTs>::count == 4);
         END;
 
         EXE(using CqSTs = sib::types_erase_t<qSTs, _TS<>>);
         TYP(CqSTs);
-        ASS(sib::types_info<CqSTs>::count == 4);
+        SAS(sib::types_info<CqSTs>::count == 4);
         END;
 
-        ASS(sib::Same<CmSTs, CqSTs>);
+        SAS(sib::Same<CmSTs, CqSTs>);
         END;
     } {
         BEG;
@@ -724,8 +724,8 @@ DEF_TEST(test_types_list)
         #define _C 50
         EXE(using mSTs = sib::types_merge_sort_t<_gen_TS(_C)>);
         EXE(using qSTs = sib::types_quick_sort_t<_gen_TS(_C)>);
-        ASS(sib::types_info<mSTs>::count == _C);
-        ASS(sib::types_info<qSTs>::count == _C);
+        SAS(sib::types_info<mSTs>::count == _C);
+        SAS(sib::types_info<qSTs>::count == _C);
         END;
     }
 
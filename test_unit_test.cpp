@@ -0,0 +1,222 @@
+﻿#include "test_unit_test.h"
+#include "sib_unit_test.h"
+#include "sib_console.h"
+
+#if !defined(_WIN32)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    using TClock = std::chrono::steady_clock;
+    using TTests = std::map<sib::debug::TString, sib::debug::TTest>;
+    using namespace std::chrono_literals;
+
+    // stdout replaced by `fd` while alive
+    class TStdoutTo
+    {
+    public:
+        explicit TStdoutTo(int fd)
+        {
+            sib::debug::outstream.flush();
+            _saved = ::dup(STDOUT_FILENO);
+            ::dup2(fd, STDOUT_FILENO);
+        }
+
+        ~TStdoutTo()
+        {
+            ::dup2(_saved, STDOUT_FILENO);
+            ::close(_saved);
+        }
+
+        TStdoutTo(TStdoutTo const&) = delete;
+        TStdoutTo& operator=(TStdoutTo const&) = delete;
+
+    private:
+        int _saved = -1;
+    };
+
+    // all the bytes waiting in `fd`
+    std::string drain(int fd)
+    {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        std::string res;
+        char buf[4096];
+        for (ssize_t bytes; (bytes = ::read(fd, buf, sizeof(buf))) > 0; ) res.append(buf, size_t(bytes));
+        return res;
+    }
+
+    size_t count_of(std::string_view text, std::string_view what)
+    {
+        size_t count = 0;
+        for (size_t pos = text.find(what); pos != text.npos; pos = text.find(what, pos + what.size())) ++count;
+        return count;
+    }
+
+    // a test writing `lines` transcript lines with its tag, slow enough for parallel tests to interleave
+    sib::debug::TTestFunc tagged(std::string tag, int lines, std::chrono::milliseconds pause, int result)
+    {
+        return [=]([[maybe_unused]] sib::debug::TTestLog& CUR_LOG) {
+            for (int i = 0; i < lines; ++i)
+            {
+                MSG(tag);
+                std::this_thread::sleep_for(pause);
+            }
+            return result;
+        };
+    }
+
+    // transcript lines under every "******** TEST: " header; false - a header came twice
+    bool split_transcript(std::string const& text, std::map<std::string, std::vector<std::string>>& blocks)
+    {
+        std::istringstream in(text);
+        std::vector<std::string>* block = nullptr;
+        for (std::string line; std::getline(in, line); )
+        {
+            if (line.starts_with("******** TEST: "))
+            {
+                auto [it, added] = blocks.try_emplace(line.substr(15));
+                if (not added) return false;
+                block = &it->second;
+            }
+            else if (block)
+            {
+                block->push_back(line);
+            }
+        }
+        return true;
+    }
+
+    // every line of the block written by the test with this tag
+    bool block_of(std::vector<std::string> const& block, std::string const& tag, size_t lines)
+    {
+        return block.size() == lines
+            and std::all_of(block.begin(), block.end(), [&](auto const& line) { return line.ends_with(tag); });
+    }
+
+} // namespace
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+DEF_TEST(test_unit_test)
+{
+    namespace fs = std::filesystem;
+    using sib::debug::RunAllTest;
+    using sib::debug::TProgressOptions;
+
+    sib::debug::Init();
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                           sib_unit_test                                            ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    auto const transcript_path = fs::temp_directory_path() / ("sib_test_transcript_" + std::to_string(::getpid()) + ".log");
+
+    {
+        BEG;
+        // no terminal: only the final status line; parallel tests keep their lines under their own header
+        TTests tests;
+        tests.emplace("a", tagged("alpha", 6, 3ms, 0));
+        tests.emplace("b", tagged("beta" , 6, 3ms, 1));
+        tests.emplace("c", tagged("gamma", 6, 3ms, 0));
+
+        std::string status;
+        {
+            int fds[2];
+            ASS(::pipe(fds) == 0);
+            {
+                TStdoutTo to(fds[1]);
+                RunAllTest(TProgressOptions{ transcript_path.string(), 2, 50 }, tests);
+            }
+            ::close(fds[1]);
+            status = drain(fds[0]);
+            ::close(fds[0]);
+        }
+        MSG("final line: ", status.substr(0, status.find('\n')));
+        ASS(status.starts_with("3/3") and status.ends_with("\n") and count_of(status, "\n") == 1);
+        ASS(status.find("failed: 1") != std::string::npos and status.find("time: 0:0") != std::string::npos);
+        ASS(status.find('\x1B') == std::string::npos);
+        ASS(tests.at("b").log().back().type == sib::debug::TTestLogType::error);
+
+        std::map<std::string, std::vector<std::string>> blocks;
+        EXE(std::ifstream file(transcript_path));
+        EXE(std::string transcript((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()));
+        ASS(split_transcript(transcript, blocks) and blocks.size() == 3);
+        ASS(block_of(blocks["a"], "alpha", 6));
+        ASS(block_of(blocks["b"], "beta" , 6));
+        ASS(block_of(blocks["c"], "gamma", 6));
+        END;
+    } {
+        BEG;
+        // terminal: the block is redrawn in place, with the ETA, and not more often than fps even
+        // though the count changes every few milliseconds
+        TTests tests;
+        for (int i = 100; i < 200; ++i) tests.emplace(sib::debug::TString("t", i), tagged("tick", 1, 3ms, 0));
+
+        int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+        ASS(master >= 0 and ::grantpt(master) == 0 and ::unlockpt(master) == 0);
+        int slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+        ASS(slave >= 0);
+
+        termios mode{};
+        ::tcgetattr(slave, &mode);
+        ::cfmakeraw(&mode);
+        ::tcsetattr(slave, TCSANOW, &mode);
+        winsize size{ 24, 80, 0, 0 };
+        ::ioctl(master, TIOCSWINSZ, &size);
+
+        unsigned const fps = 20;
+        auto start = TClock::now();
+        {
+            TStdoutTo to(slave);
+            RunAllTest(TProgressOptions{ transcript_path.string(), 1, fps }, tests);
+        }
+        auto seconds = std::chrono::duration<double>(TClock::now() - start).count();
+        std::string screen = drain(master);
+        ::close(slave);
+        ::close(master);
+
+        // every frame but the first one starts by moving back over the previous one
+        size_t frames = count_of(screen, "\x1B[J") + 1;
+        MSG("frames: ", frames, " in ", int(seconds * 1000), " ms");
+        ASS(frames >= 3 and frames <= seconds * fps + 2 and frames < tests.size() / 4);
+        ASS(count_of(screen, "\r\x1B[1A\x1B[J") == frames - 1);
+        ASS(screen.find("eta: 0:0") != std::string::npos);
+        ASS(screen.find("#1") != std::string::npos);
+        ASS(screen.ends_with("\n") and screen.substr(screen.rfind("\x1B[J") + 3).starts_with("100/100"));
+        ASS(screen.find("failed: 0   time: 0:0") != std::string::npos);
+        END;
+    }
+
+    fs::remove(transcript_path);
+    return 0;
+}
+
+#else
+
+DEF_TEST(test_unit_test)
+{
+    sib::debug::Init();
+    MSG("test_unit_test: the runner is tested through pipes and pseudo-terminals, POSIX only");
+    return 0;
+}
+
+#endif
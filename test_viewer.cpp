@@ -0,0 +1,169 @@
+﻿#include "test_viewer.h"
+#include "sib_unit_test.h"
+#include "sib_viewer.h"
+#include "sib_screen.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// ---------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+    // report file removed with the object
+    class TTempReport
+    {
+    public:
+        explicit TTempReport(std::string const& text)
+            : _path((std::filesystem::temp_directory_path() / ("sib_viewer_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".txt")).string())
+        {
+            std::ofstream(_path, std::ios::binary) << text;
+        }
+
+        ~TTempReport() { std::remove(_path.c_str()); }
+
+        TTempReport(TTempReport const&) = delete;
+        TTempReport& operator=(TTempReport const&) = delete;
+
+        std::string const& path() const noexcept { return _path; }
+
+    private:
+        std::string _path;
+    };
+
+    constexpr std::string_view report_sample =
+        "******** TEST: alpha\n"
+        "b   ------------------------------------------------------ 1\n"
+        "m   hello\n"
+        "a   1     [FAIL] ASSERT(1 == 2)\n"
+        "  TEST: beta\n"
+        "  | Type     | Blok | Line | Description\n"
+        "  | Error    | 2    | 7    | Assertion fail\n"
+        "  |          |      |      | second line\n"
+        "  | Warning  | 3    | 1    | counter is not available\n"
+        "  | Message  |      |      | Return: 0\r\n"
+        "  log count: 3";
+
+} // namespace
+
+DEF_TEST(test_viewer)
+{
+    using namespace sib::console;
+
+    sib::debug::Init();
+
+    MSG("");                                              //
+    MSG("****************************************************************************************************");
+    MSG("                                             sib_viewer                                             ");
+    MSG("****************************************************************************************************");
+    MSG("");
+
+    {
+        BEG;
+        TTempReport tmp{ std::string(report_sample) };
+        DEF(TReportFile, file, (tmp.path()));
+        EXE(file.wait_indexed());
+        ASS(file.lines() == 11);
+        ASS(file.tests() == 3 and file.test_name(1) == "alpha" and file.test_name(2) == "beta");
+        ASS(file.line(1).type == unsigned(TLineType::Block) and file.line(2).block == 1);
+        ASS(file.line(3).type == unsigned(TLineType::Error) and file.line(3).test == 1);
+        ASS(file.line(6).type == unsigned(TLineType::Error) and file.line(6).block == 2);
+        // continuation rows keep the type of the row
+        ASS(file.line(7).type == unsigned(TLineType::Error));
+        ASS(file.line(9).type == unsigned(TLineType::Message) and file.line_text(9) == "  | Message  |      |      | Return: 0");
+        ASS(file.line_text(10) == "  log count: 3");
+        ASS(file.line_at(file.text().find("hello")) == 2);
+        END;
+
+        DEF(TReportView, view, (file));
+        EXE(view.set_height(4));
+        ASS(view.size() == 11);
+        ASS(view.next_error() and view.cursor() == 3);
+        ASS(view.next_error() and view.cursor() == 6);
+        ASS(view.next_error() and view.cursor() == 7);
+        ASS(not view.next_error());
+        ASS(view.next_error(false) and view.cursor() == 6);
+        ASS(view.top() == 4);
+        ASS(view.search("hello", false) and view.cursor() == 2);
+        ASS(view.search("Return") and view.cursor() == 9);
+        ASS(not view.search("Return"));
+        END;
+
+        // only the errors of beta, its header stays
+        EXE(view.filter(2, 0, line_type_bit(TLineType::Error)));
+        ASS(view.size() == 3 and view.line(0) == 4 and view.line(1) == 6 and view.line(2) == 7);
+        ASS(view.cursor() == 2);
+        EXE(view.filter(TReportView::ANY, 1, 0));
+        ASS(view.size() == 5);
+        ASS(not view.search("Assertion"));
+        END;
+
+        EXE(TScreen screen(40, 3));
+        EXE(view.filter(TReportView::ANY, 0, 0));
+        EXE(view.move_to(0));
+        EXE(view.draw(screen, 3));
+        ASS(screen.at(0, 0)->ch == U'*' and screen.at(0, 1)->ch == U'b');
+        ASS(screen.at(0, 0)->attr.style & STYLE_REVERSE);
+        END;
+    } {
+        BEG;
+        // a big transcript: the first lines are usable before the end is indexed
+        std::string big;
+        big.reserve(64 << 20);
+        for (int test = 0; test < 1000; ++test)
+        {
+            big += "******** TEST: test " + std::to_string(test) + "\n";
+            for (int block = 1; block <= 10; ++block)
+            {
+                big += "b   ------------------------------------------------------ " + std::to_string(block) + "\n";
+                for (int line = 0; line < 100; ++line)
+                    big += (line == 50 and block == 5) ? "a   1     [FAIL] ASSERT(value == expected)\n"
+                                                       : "a   1     [pass] ASSERT(value == expected and more text here)\n";
+            }
+        }
+        big += "m   needle at the end\n";
+        TTempReport tmp{ big };
+
+        auto start = std::chrono::steady_clock::now();
+        TReportFile file(tmp.path());
+        TReportView view(file);
+        while (view.size() < 100) view.refresh();
+        auto first = std::chrono::steady_clock::now();
+
+        // a search while the file is indexed lands on a matching line or finds nothing yet,
+        // a filtered view gives up at the indexed end instead of waiting for the indexer
+        EXE(bool indexing = not file.indexed());
+        EXE(bool early    = view.search("needle"));
+        MSG(std::string("search while indexing: ") + (indexing ? "yes" : "no") + ", found: " + (early ? "yes" : "no"));
+        ASS(not early or file.line_text(view.line(view.cursor())) == "m   needle at the end");
+        EXE(TReportView errors(file));
+        EXE(errors.filter(TReportView::ANY, 0, line_type_bit(TLineType::Error)));
+        ASS(not errors.search("needle"));
+
+        file.wait_indexed();
+        auto done = std::chrono::steady_clock::now();
+
+        // the view has not taken the last lines yet, the search takes them first
+        EXE(view.move_to(0));
+        ASS(view.search("needle") and view.line(view.cursor()) == file.lines() - 1);
+        EXE(view.refresh());
+
+        auto ms = [](auto duration) { return std::to_string(std::chrono::duration<double, std::milli>(duration).count()); };
+        MSG("transcript of " + std::to_string(big.size() >> 20) + " MiB, " + std::to_string(file.lines()) + " lines");
+        MSG("first screen after " + ms(first - start) + " ms, indexed in " + ms(done - start) + " ms");
+        ASS(view.size() == 1000 * (1 + 10 * 101) + 1);
+
+        EXE(view.set_height(50));
+        PRF(sib::debug::TPerfBudget().allocs(0),
+            if (not view.next_error()) view.move_to(0));
+        EXE(view.filter(TReportView::ANY, 0, line_type_bit(TLineType::Error)));
+        ASS(view.size() == 2000);
+        END;
+    }
+
+    return 0;
+}
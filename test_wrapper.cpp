@@ -135,7 +135,7 @@ DEF_TEST(test_TValue)
         PRN(i8);
         PRN(i9);
 
-        DEF(sib::TValue<int>, vi0,         );
+        DEF(sib::TValue<int>, vi0, {}      );
         DEF(sib::TValue<int>, vi1, { 111 } );
         DEF(sib::TValue<int>, vi2, ( 222 ) );
         DEF(sib::TValue<int>, vi3, = 333   );
@@ -975,6 +975,11 @@ DEF_TEST(test_TWrapper)
         PRN(i);
         PRN(w);
         END;
+    } {
+        BEG;
+        DEF(int, i, = 1);
+        PRF(sib::debug::TPerfBudget().ns(50).allocs(0), auto w = sib::to_wrap(i); sib::debug::do_not_optimize(w));
+        END;
     } {
         BEG;
         DEF(int const, ic, = 1);